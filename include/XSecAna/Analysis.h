@@ -1,14 +1,39 @@
 #pragma once
 #include<string>
 #include <map>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "XSecAna/Systematic.h"
 #include "XSecAna/IMeasurement.h"
 
 // root includes
 #include "TDirectory.h"
+#include "TFile.h"
 
 namespace xsec {
+    namespace detail {
+        ///\brief Everything in an Analysis directory except the systematics themselves
+        inline
+        void SaveAnalysisHeader(const xsec::IMeasurement * nominal,
+                                std::size_t nsystematics,
+                                const TH1 * data,
+                                TDirectory * dir) {
+            dir->cd();
+            TObjString("Analysis").Write("type");
+
+            nominal->SaveTo(dir, "Nominal");
+            data->Write("Data");
+
+            TObjString(std::to_string(nsystematics).c_str()).Write("NSystematics");
+        }
+    }
+
     inline
     void SaveAnalysis(xsec::IMeasurement * nominal,
                       std::vector<xsec::Systematic<xsec::IMeasurement>> systematics,
@@ -18,13 +43,7 @@ namespace xsec {
         TDirectory * tmp = gDirectory;
 
         dir = dir->mkdir(subdir.c_str()); // switch to subdir
-        dir->cd();
-        TObjString("Analysis").Write("type");
-
-        nominal->SaveTo(dir, "Nominal");
-        data->Write("Data");
-
-        TObjString(std::to_string(systematics.size()).c_str()).Write("NSystematics");
+        detail::SaveAnalysisHeader(nominal, systematics.size(), data, dir);
         auto syst_dir = dir->mkdir("Systematics");
         for (auto i = 0u; i < systematics.size(); i++) {
             systematics[i].SaveTo(syst_dir, std::to_string(i));
@@ -61,4 +80,93 @@ namespace xsec {
         tmp->cd();
         return {nominal, systematics, data};
     }
+
+    ///\brief Same as above, but writes a new file, serializing and compressing
+    /// the systematics in parallel on nthreads threads (0 for parallel::GetNThreads()).
+    // Each thread writes into its own in-memory file that ROOT's TBufferMerger
+    // merges into filename. Requires ROOT::EnableThreadSafety, which is called here.
+    void SaveAnalysis(xsec::IMeasurement * nominal,
+                      const std::vector<xsec::Systematic<xsec::IMeasurement>> & systematics,
+                      const TH1 * data,
+                      const std::string & filename,
+                      const std::string & subdir,
+                      int nthreads = 0);
+
+    ///\brief Read-only view of an Analysis saved with SaveAnalysis
+    /// that loads the shifts of the systematics when they are first needed.
+    // The nominal, the data and the systematics' names and types are read up front.
+    // All other reads happen on a background I/O thread, in the order they are requested,
+    // so Prefetch can overlap reading and decompressing upcoming systematics
+    // with computation on the ones already loaded.
+    // Loaded shifts are kept until dropped. Dropping only releases the reference
+    // held here; Systematics already handed out remain valid.
+    class LazyAnalysis {
+    public:
+        LazyAnalysis(xsec::type::LoadFunction<xsec::IMeasurement> load,
+                     const std::string & filename,
+                     const std::string & subdir);
+
+        ~LazyAnalysis();
+
+        LazyAnalysis(const LazyAnalysis &) = delete;
+        LazyAnalysis & operator=(const LazyAnalysis &) = delete;
+
+        IMeasurement * GetNominal() const { return fNominal.get(); }
+        const TH1 * GetData() const { return fData.get(); }
+
+        std::size_t GetNSystematics() const { return fSystematics.size(); }
+        const std::string & GetSystematicName(std::size_t isyst) const { return fSystematics.at(isyst).name; }
+        SystType_t GetSystematicType(std::size_t isyst) const { return fSystematics.at(isyst).type; }
+        std::size_t GetNShifts(std::size_t isyst) const { return fSystematics.at(isyst).shifts.size(); }
+
+        ///\brief Blocks until every shift of systematic isyst is loaded.
+        /// Shifts not already queued jump ahead of prefetches
+        Systematic<IMeasurement> GetSystematic(std::size_t isyst);
+
+        std::shared_ptr<IMeasurement> GetShift(std::size_t isyst, std::size_t ishift);
+
+        ///\brief Queue every shift of systematic isyst to be read in the background
+        void Prefetch(std::size_t isyst);
+
+        bool IsLoaded(std::size_t isyst) const;
+
+        void Drop(std::size_t isyst);
+        void Drop(std::size_t isyst, std::size_t ishift);
+        void DropAll();
+
+    private:
+        typedef std::shared_future<std::shared_ptr<IMeasurement>> Slot;
+
+        struct SystematicInfo {
+            std::string name;
+            SystType_t type;
+            std::vector<Slot> shifts;
+        };
+
+        struct Request {
+            std::size_t isyst;
+            std::size_t ishift;
+            std::shared_ptr<std::promise<std::shared_ptr<IMeasurement>>> promise;
+        };
+
+        ///\brief Returns the slot of a shift, queueing it if it isn't loaded or in flight.
+        /// Must hold fMutex
+        Slot & _request(std::size_t isyst, std::size_t ishift, bool urgent);
+
+        void _io_loop();
+
+        xsec::type::LoadFunction<xsec::IMeasurement> fLoad;
+        std::unique_ptr<TFile> fFile;
+        TDirectory * fSystematicsDir = nullptr;
+
+        std::unique_ptr<IMeasurement> fNominal;
+        std::unique_ptr<TH1> fData;
+        std::vector<SystematicInfo> fSystematics;
+
+        mutable std::mutex fMutex;
+        std::condition_variable fWakeIO;
+        std::deque<Request> fQueue;
+        bool fStop = false;
+        std::thread fIOThread;
+    };
 }
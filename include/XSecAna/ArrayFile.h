@@ -0,0 +1,89 @@
+#pragma once
+
+#include "XSecAna/MappedFile.h"
+#include "XSecAna/Utils.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xsec {
+    namespace detail {
+        ///\brief File header of an ArrayFile. Followed by the index of entries,
+        /// the table of names, then the data of each entry.
+        // Data blocks start on MappedFile::kAlignment byte boundaries.
+        struct ArrayFileHeader {
+            FileSignature signature;
+            std::uint64_t nentries;
+            std::uint64_t index_offset;
+            std::uint64_t names_offset;
+            std::uint64_t names_size;
+        };
+
+        struct ArrayFileEntry {
+            std::uint64_t name_offset;
+            std::uint64_t name_size;
+            std::uint64_t type;
+            std::uint64_t rows;
+            std::uint64_t cols;
+            std::uint64_t offset;
+            std::uint64_t nbytes;
+        };
+    }
+
+    ///\brief Builds a file of named matrices, integer arrays and strings
+    /// that can be read back in place by ArrayFile
+    class ArrayFileWriter {
+    public:
+        void Add(const std::string & name, const Matrix & matrix);
+        void Add(const std::string & name, const std::vector<int> & ints);
+        void Add(const std::string & name, const std::string & value);
+
+        void Write(const std::string & path) const;
+
+    private:
+        struct Entry {
+            std::uint64_t type;
+            std::uint64_t rows;
+            std::uint64_t cols;
+            std::string bytes;
+        };
+
+        void AddEntry(const std::string & name, Entry entry);
+
+        std::map<std::string, Entry> fEntries;
+    };
+
+    ///\brief Read-only memory map of a file written by ArrayFileWriter.
+    // Matrices are returned as maps into the file, so nothing is read until it is used
+    // and processes mapping the same file share its pages.
+    // Maps must not outlive the ArrayFile.
+    class ArrayFile {
+    public:
+        enum Type_t {
+            kMatrix = 0,
+            kInts = 1,
+            kString = 2,
+        };
+
+        explicit ArrayFile(const std::string & path);
+
+        bool Has(const std::string & name) const { return fEntries.count(name); }
+
+        ///\brief Names of all entries, sorted
+        std::vector<std::string> GetNames() const;
+
+        Eigen::Map<const Matrix> GetMatrix(const std::string & name) const;
+        Eigen::Map<const Eigen::VectorXi> GetInts(const std::string & name) const;
+        std::string GetString(const std::string & name) const;
+
+        const std::string & GetPath() const { return fFile.path(); }
+
+    private:
+        const detail::ArrayFileEntry & Find(const std::string & name, Type_t type) const;
+
+        MappedFile fFile;
+        std::map<std::string, detail::ArrayFileEntry> fEntries;
+    };
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "XSecAna/Systematic.h"
+#include "XSecAna/Utils.h"
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace xsec {
+    ///\brief Requirements every merged bin must meet
+    struct MergeConstraints {
+        // minimum nominal content, e.g. to keep statistical uncertainty under control
+        double min_content = 0;
+        double min_width = 0;
+        double max_fractional_uncertainty = std::numeric_limits<double>::infinity();
+    };
+
+    ///\brief Cost of one merged bin, given its nominal content and total fractional uncertainty
+    typedef std::function<double(double nominal, double fractional_uncertainty)> MergeCost;
+
+    ///\brief Finds the binning of one variable, built from contiguous groups of fine bins,
+    /// that minimizes the summed cost of its bins.
+    // Starts from nominal and systematic histograms in fine bins. Contents of every sample
+    // (nominal, each systematic shift and universe) are summed cumulatively once, so the contents
+    // of any merged bin are a difference of two sums. The cost and total fractional uncertainty
+    // (as SimpleQuadSum::TotalFractionalUncertainty calculates it) of every possible merged bin
+    // are computed up front, in parallel, and partitions are searched by dynamic programming.
+    // Memory goes as the square of the number of fine bins.
+    // Under/overflow are left as they are and never merged into the inner bins.
+    class BinMerger {
+    public:
+        ///\brief The default cost is the square of the fractional uncertainty,
+        /// so the best partition minimizes the total fractional uncertainty summed in quadrature
+        /// over bins, like distributed::TotalFractionalUncertainty
+        BinMerger(const TH1 * nominal,
+                  const std::map<std::string, Systematic<TH1>> & systematics,
+                  MergeConstraints constraints = MergeConstraints(),
+                  MergeCost cost = MergeCost());
+
+        std::size_t GetNFineBins() const { return fEdges.size() - 1; }
+
+        const Array & GetFineEdges() const { return fEdges; }
+
+        ///\brief Nominal content of fine bins [first, last), counting from 0 for the first inner bin
+        double Content(std::size_t first, std::size_t last) const;
+
+        ///\brief Total fractional uncertainty of fine bins [first, last)
+        double FractionalUncertainty(std::size_t first, std::size_t last) const;
+
+        ///\brief Cost of fine bins [first, last). Infinite if they don't meet the constraints
+        double Cost(std::size_t first, std::size_t last) const { return fCost(first, last); }
+
+        ///\brief Edges of the lowest cost binning with nbins bins.
+        /// Throws if no binning with nbins bins meets the constraints
+        Array Optimize(std::size_t nbins) const;
+
+        ///\brief Edges of the binning with the most bins that meets the constraints,
+        /// lowest cost among those.
+        // Searches every number of bins, so time goes as the cube of the number of fine bins
+        Array Finest() const;
+
+        ///\brief Sums contents of a fine binned histogram into edges, which must be edges of its bins.
+        /// Errors are summed in quadrature. Fine bins outside of edges go to under/overflow
+        static std::shared_ptr<TH1> Rebin(const TH1 * fine, const Array & edges);
+
+    private:
+        ///\brief Lowest cost of partitioning the first b fine bins into k bins is best(k, b).
+        /// The last of those bins starts at fine bin from(k, b)
+        void _partition(std::size_t max_bins, Matrix & best, Eigen::MatrixXi & from) const;
+
+        Array _edges(const Eigen::MatrixXi & from, std::size_t nbins) const;
+
+        Array fEdges;
+        // cumulative sum of inner fine bins. Element i is the sum of bins [0, i)
+        Array fNominal;
+        // fine bins [a, b) are element (a, b)
+        Matrix fFractional;
+        Matrix fCost;
+    };
+}
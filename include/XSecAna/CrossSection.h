@@ -108,6 +108,13 @@ namespace xsec {
     private:
         virtual void _eval_impl(const Array & data, const Array & error,
                                 ArrayRef result, ArrayRef rerror) const override;
+        virtual void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                                      Array2DRef result, Array2DRef rerror) const override;
+
+        ///\brief Bin widths of the data binning, recomputed only when the binning changes
+        Array _bin_widths() const;
+
+        mutable EvalCache fBinWidths;
     };
 
     class EigenCrossSectionEstimator : public ICrossSection,
@@ -133,6 +140,8 @@ namespace xsec {
 
         virtual void _eval_impl(const Array & data, const Array & error,
                                 ArrayRef result, ArrayRef rerror) const override;
+        virtual void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                                      Array2DRef result, Array2DRef rerror) const override;
     };
 
     const Array CalculateCrossSection(const Array * unfolded_selected_signal,
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "XSecAna/Distributed.h"
+#include "XSecAna/Systematic.h"
+#include "XSecAna/Utils.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xsec {
+    enum CutDirection_t {
+        // select events with the optimization variable at or above the cut
+        kKeepAbove,
+        // select events with the optimization variable below the cut
+        kKeepBelow,
+    };
+
+    ///\brief Objective of one cut, given the selected nominal and its total fractional uncertainty
+    /// in each inner analysis bin
+    typedef std::function<double(const Array & nominal, const Array & fractional_uncertainty)> CutObjective;
+
+    ///\brief Scans a cut on one variable without re-running the analysis for each cut value.
+    // Histograms have the optimization variable on the x axis, in bins as fine as the cut
+    // should be resolved, and the analysis binning on the y (and z) axes.
+    // A 1D histogram is treated as a counting analysis with a single bin.
+    // Every sample (nominal, each systematic shift and universe) is summed cumulatively along x once,
+    // after which the selected spectrum at any cut is a column lookup. Candidate cuts are the x bin edges.
+    class CutScanner {
+    public:
+        CutScanner(const TH1 * nominal,
+                   const std::map<std::string, Systematic<TH1>> & systematics,
+                   CutDirection_t direction = kKeepAbove);
+
+        std::size_t GetNCuts() const { return fCutValues.size(); }
+
+        ///\brief Analysis bins, including under/overflow
+        std::size_t GetNBins() const { return fNBins; }
+
+        const Array & GetCutValues() const { return fCutValues; }
+
+        CutDirection_t GetDirection() const { return fDirection; }
+
+        ///\brief Nominal analysis spectrum selected by cut icut
+        Array SelectedNominal(std::size_t icut) const;
+
+        ///\brief Shifts (or universes) of a systematic selected by cut icut, one per column
+        Matrix SelectedShifts(const std::string & systematic, std::size_t icut) const;
+
+        ///\brief Total fractional uncertainty, as SimpleQuadSum::TotalFractionalUncertainty
+        /// calculates it, of every analysis bin (rows) at every cut (columns).
+        /// Cuts are evaluated in parallel
+        Matrix TotalFractionalUncertainty() const;
+
+        ///\brief Cut minimizing objective
+        distributed::OptimizationResult Scan(const CutObjective & objective) const;
+
+        ///\brief Cut minimizing the total fractional uncertainty summed in quadrature
+        /// over the inner analysis bins, like distributed::TotalFractionalUncertainty
+        distributed::OptimizationResult Scan() const;
+
+    private:
+        ///\brief Cumulative sums of each column of contents.
+        /// Row ishift * nbins + ibin of the result is analysis bin ibin of shift ishift
+        Matrix _cumulative(const Matrix & contents) const;
+
+        Array _fractional_uncertainty(std::size_t icut) const;
+
+        Array _inner(const Array & arr) const;
+
+        struct Sample {
+            SystType_t type;
+            std::size_t nshifts;
+            // (nshifts * analysis bins) x cuts
+            Matrix selected;
+        };
+
+        CutDirection_t fDirection;
+        std::size_t fNX;
+        std::size_t fNBins;
+        Array fCutValues;
+        // analysis bins x cuts
+        Matrix fNominal;
+        std::map<std::string, Sample> fSystematics;
+        // indices of inner analysis bins
+        std::vector<std::size_t> fInner;
+    };
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "XSecAna/IMeasurement.h"
+#include "XSecAna/Systematic.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef XSECANA_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace xsec {
+    namespace distributed {
+        ///\brief Evaluates an objective on every one of a set of candidates,
+        /// e.g. binnings or cut values, sharing the candidates among workers
+        class IDriver {
+        public:
+            ///\brief objective(i) for every i in [0, ncandidates).
+            /// Every process that calls Evaluate gets every value
+            virtual std::vector<double> Evaluate(std::size_t ncandidates,
+                                                 const std::function<double(std::size_t)> & objective) = 0;
+
+            ///\brief Rank of this process. Zero unless processes are started by MPI
+            virtual int GetRank() const { return 0; }
+
+            virtual ~IDriver() = default;
+        };
+
+        ///\brief Candidates are evaluated on threads of this process with parallel::For,
+        /// so objective must be safe to call concurrently
+        class ThreadDriver : public IDriver {
+        public:
+            ///\brief nthreads <= 0 for parallel::GetNThreads()
+            explicit ThreadDriver(int nthreads = 0) : fNThreads(nthreads) {}
+
+            std::vector<double> Evaluate(std::size_t ncandidates,
+                                         const std::function<double(std::size_t)> & objective) override;
+
+        private:
+            int fNThreads;
+        };
+
+        ///\brief Candidates are evaluated in nworkers forked child processes.
+        // Children see a copy-on-write image of the parent, so objectives can use anything
+        // set up beforehand without serializing it, and needn't be thread safe.
+        // Each child takes every nworkers'th candidate and sends its values back through a pipe.
+        // Must not be used while other threads of the process are running.
+        class ForkDriver : public IDriver {
+        public:
+            ///\brief nworkers <= 0 for parallel::GetNThreads()
+            explicit ForkDriver(int nworkers = 0) : fNWorkers(nworkers) {}
+
+            std::vector<double> Evaluate(std::size_t ncandidates,
+                                         const std::function<double(std::size_t)> & objective) override;
+
+        private:
+            int fNWorkers;
+        };
+
+#ifdef XSECANA_USE_MPI
+        ///\brief Candidates are shared among the ranks of an MPI communicator.
+        // Each rank takes every size'th candidate and the values are combined with MPI_Allreduce,
+        // so every rank must call Evaluate with the same candidates.
+        // Initializes MPI if nothing else has, in which case it is finalized at exit.
+        // Throws if MPI has already been finalized.
+        class MPIDriver : public IDriver {
+        public:
+            explicit MPIDriver(MPI_Comm comm = MPI_COMM_WORLD);
+
+            ~MPIDriver();
+
+            MPIDriver(const MPIDriver &) = delete;
+            MPIDriver & operator=(const MPIDriver &) = delete;
+
+            std::vector<double> Evaluate(std::size_t ncandidates,
+                                         const std::function<double(std::size_t)> & objective) override;
+
+            int GetRank() const override { return fRank; }
+            int GetSize() const { return fSize; }
+
+        private:
+            MPI_Comm fComm;
+            int fRank;
+            int fSize;
+        };
+#endif
+
+        struct OptimizationResult {
+            // index of the candidate with the lowest objective
+            std::size_t best;
+            double value;
+            // objective of every candidate
+            std::vector<double> values;
+        };
+
+        ///\brief The best of values. NaN values are never the best.
+        /// Throws if values is empty or every value is NaN
+        OptimizationResult Minimum(std::vector<double> values);
+
+        ///\brief Nominal, systematics and data of an analysis
+        /// built for one candidate binning or cut
+        struct AnalysisSpec {
+            std::shared_ptr<IMeasurement> nominal;
+            std::map<std::string, Systematic<IMeasurement>> systematics;
+            std::shared_ptr<TH1> data;
+        };
+
+        typedef std::function<double(const AnalysisSpec &)> AnalysisObjective;
+
+        ///\brief Default objective. Total fractional uncertainty from SimpleQuadSum,
+        /// summed in quadrature over the analysis bins
+        double TotalFractionalUncertainty(const AnalysisSpec & analysis);
+
+        ///\brief Binning among candidate bin edges that minimizes objective.
+        /// make_analysis builds the analysis for a set of bin edges.
+        /// Throws if the objective is NaN for every candidate
+        OptimizationResult OptimizeBinning(IDriver & driver,
+                                           const std::vector<Array> & candidate_edges,
+                                           const std::function<AnalysisSpec(const Array &)> & make_analysis,
+                                           const AnalysisObjective & objective = TotalFractionalUncertainty);
+
+        ///\brief Cut value among nsteps evenly spaced values in [lo, hi] that minimizes objective.
+        /// make_analysis builds the analysis with events passing a cut value.
+        /// Throws if the objective is NaN for every cut value
+        OptimizationResult OptimizeCut(IDriver & driver,
+                                       double lo,
+                                       double hi,
+                                       int nsteps,
+                                       const std::function<AnalysisSpec(double)> & make_analysis,
+                                       const AnalysisObjective & objective = TotalFractionalUncertainty);
+    }
+}
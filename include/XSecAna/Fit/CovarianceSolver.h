@@ -0,0 +1,119 @@
+#pragma once
+
+#include "XSecAna/Utils.h"
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <memory>
+#include <vector>
+
+namespace xsec {
+    namespace fit {
+        enum CovarianceStructure_t {
+            kAutoStructure,
+            kDenseStructure,
+            kBlockDiagonalStructure,
+            kSparseStructure,
+        };
+
+        ///\brief Evaluates v^T (C + diag(d))^-1 v for a fixed covariance C
+        /// and a varying diagonal term d.
+        // The nonzero pattern of C is inspected once at construction.
+        // Block-diagonal covariances are factorized block by block (in parallel),
+        // banded or mostly-empty covariances use a sparse Cholesky,
+        // and anything else falls back to a dense LLT.
+        class CovarianceSolver {
+        public:
+            CovarianceSolver() = default;
+
+            explicit CovarianceSolver(const Matrix & covariance,
+                                      CovarianceStructure_t structure = kAutoStructure,
+                                      double zero_threshold = 0);
+
+            ///\brief Dense solver reusing a lower Cholesky factor of covariance computed earlier,
+            /// e.g. mapped from a TemplateFitSignalEstimator snapshot.
+            /// Neither the covariance nor the factor is copied. owner keeps their storage alive
+            /// and is shared by copies of the solver
+            CovarianceSolver(Eigen::Map<const Matrix> covariance,
+                             const double * lower_factor,
+                             std::shared_ptr<const void> owner);
+
+            double Chi2(const Vector & v, const Vector & diagonal) const;
+
+            ///\brief Same as above with d = 0. Uses the factorization cached at construction
+            double Chi2(const Vector & v) const;
+
+            ///\brief Returns (C + diag(d))^-1 b
+            Matrix Solve(const Matrix & b, const Vector & diagonal) const;
+
+            ///\brief Returns C^-1 b using the factorization cached at construction
+            Matrix Solve(const Matrix & b) const;
+
+            CovarianceStructure_t GetStructure() const { return fStructure; }
+
+            const std::vector<std::vector<int>> & GetBlocks() const { return fBlocks; }
+
+            int GetBandwidth() const { return fBandwidth; }
+
+            double GetDensity() const { return fDensity; }
+
+            Eigen::Map<const Matrix> GetCovariance() const {
+                if (fMappedCovariance) return {fMappedCovariance, fNMappedBins, fNMappedBins};
+                return {fCovariance.data(), fCovariance.rows(), fCovariance.cols()};
+            }
+
+            ///\brief Lower Cholesky factor of a dense covariance. Empty for other structures
+            Matrix GetCholeskyFactor() const;
+
+            // auto-detection thresholds
+            static constexpr double kMaxSparseDensity = 0.1;
+            static constexpr double kMaxBandFraction = 0.1;
+            // blocks are only factorized in parallel when there is enough work to share
+            static constexpr double kMinParallelBlockWork = 1e6;
+
+        private:
+            void DetectStructure(double zero_threshold);
+
+            void SetupBlocks();
+
+            void SetupSparse(double zero_threshold);
+
+            double BlockChi2(const Vector & v, const Vector & diagonal, bool cached) const;
+
+            double SparseChi2(const Vector & v, const Vector & diagonal) const;
+
+            Matrix BlockSolve(const Matrix & b, const Vector & diagonal, bool cached) const;
+
+            typedef Eigen::SparseMatrix<double> SparseMatrix;
+            typedef Eigen::SimplicialLLT<SparseMatrix, Eigen::Lower, Eigen::NaturalOrdering<int>> SparseLLT;
+
+            // owned, or in fFactorOwner's storage
+            Matrix fCovariance;
+            const double * fMappedCovariance = nullptr;
+            Eigen::Index fNMappedBins = 0;
+            CovarianceStructure_t fStructure = kDenseStructure;
+            std::vector<std::vector<int>> fBlocks;
+            int fBandwidth = 0;
+            double fDensity = 1;
+
+            // dense. Either factorized here or a factor owned by fFactorOwner
+            Eigen::LLT<Matrix> fDecomp;
+            const double * fFactor = nullptr;
+            std::shared_ptr<const void> fFactorOwner;
+
+            // block diagonal
+            std::vector<int> fDiagonalIdx; // 1x1 blocks
+            Vector fDiagonalVariance;
+            std::vector<int> fMultiBinBlocks;
+            std::vector<Matrix> fBlockCovariances;
+            std::vector<Eigen::LLT<Matrix>> fBlockDecomps;
+            double fBlockWork = 0;
+
+            // sparse. Stored symmetrically permuted by fPermutation
+            // so the factorization can use natural ordering
+            SparseMatrix fSparseCovariance;
+            std::vector<int> fSparseDiagonalIdx;
+            Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> fPermutation;
+            std::shared_ptr<SparseLLT> fSparseDecomp;
+        };
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "XSecAna/Fit/IFitter.h"
+#include "XSecAna/MappedFile.h"
+
+namespace xsec {
+    namespace fit {
+        enum FitResultColumn_t {
+            kFunValColumn,
+            kFunCallsColumn,
+            kIsValidColumn,
+            kParamsColumn,
+            kParamsErrorUpColumn,
+            kParamsErrorDownColumn,
+            kCovarianceColumn,
+        };
+
+        namespace detail {
+            ///\brief File header of a fit result store.
+            // Followed by row groups. Each group starts with its number of rows (uint64)
+            // followed by nrows x row_width doubles in column-major order, so every column
+            // of a group is contiguous. Every group but the last holds rows_per_group rows.
+            struct FitResultStoreHeader {
+                xsec::detail::FileSignature signature;
+                std::uint64_t nparams;
+                std::uint64_t store_covariance;
+                std::uint64_t rows_per_group;
+                std::uint64_t nrows;
+            };
+
+            ///\brief Number of doubles in a row.
+            // fun_val, fun_calls, is_valid, params, params_error_up, params_error_down
+            // and, optionally, the upper triangle of the covariance packed row by row
+            inline std::size_t FitResultRowWidth(std::size_t nparams, bool store_covariance) {
+                return 3 + 3 * nparams + (store_covariance ? nparams * (nparams + 1) / 2 : 0);
+            }
+        }
+
+        ///\brief Appends FitResults of a fixed number of parameters to a columnar file
+        // meant for large toy campaigns. Rows are buffered one group at a time.
+        // The header's row count is updated after every group, so a partially
+        // written file is readable up to the last complete group.
+        class FitResultWriter {
+        public:
+            ///\brief rows_per_group <= 0 picks as many rows as fit in about kGroupBytes,
+            /// so the buffer stays small however many parameters there are
+            FitResultWriter(const std::string & path,
+                            int nparams,
+                            bool store_covariance = false,
+                            int rows_per_group = 0);
+
+            ///\brief Closes the file. Errors are reported on std::cerr rather than thrown.
+            /// Call Close to handle them
+            ~FitResultWriter();
+
+            void Append(const FitResult & result);
+
+            ///\brief Write the last group, holding only the rows appended since the previous one
+            void Close();
+
+            static const std::size_t kGroupBytes = 1 << 20;
+
+            std::size_t GetNRows() const { return fNRows + fNGroupRows; }
+
+        private:
+            void FlushGroup();
+
+            std::ofstream fFile;
+            int fNParams;
+            bool fStoreCovariance;
+            int fRowsPerGroup;
+            std::size_t fNRows = 0;
+            int fNGroupRows = 0;
+            Matrix fGroup;
+        };
+
+        ///\brief Memory-mapped reader for files written by FitResultWriter
+        class FitResultReader {
+        public:
+            explicit FitResultReader(const std::string & path);
+
+            std::size_t GetNRows() const { return fHeader.nrows; }
+            int GetNParams() const { return fHeader.nparams; }
+            bool HasCovariance() const { return fHeader.store_covariance; }
+
+            ///\brief One column for every stored result.
+            /// index selects the parameter, or the packed covariance element (see CovarianceIndex)
+            Array Column(FitResultColumn_t column, int index = 0) const;
+
+            FitResult GetRow(std::size_t row) const;
+
+            ///\brief Position of covariance element (i, j) in the packed upper triangle
+            static int CovarianceIndex(int i, int j, int nparams);
+
+        private:
+            std::size_t ColumnOffset(FitResultColumn_t column, int index) const;
+            const double * Group(std::size_t igroup) const;
+            std::size_t GroupRows(std::size_t igroup) const;
+
+            MappedFile fFile;
+            detail::FitResultStoreHeader fHeader;
+            std::size_t fRowWidth;
+            std::size_t fGroupBytes;
+        };
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include "XSecAna/Fit/IFitter.h"
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+
+namespace xsec {
+    namespace fit {
+        ///\brief A fit configuration that can run concurrently with others on the same templates.
+        // Owns a clone of the calculator and of the fitter, so fixing and releasing templates
+        // or changing fitters in one session doesn't affect the others.
+        // The reduced templates, covariance factorization and design matrix are shared
+        // between the clones, so a session costs little more than its parameter map and
+        // the fitter's workspace.
+        // A single session is not thread-safe; use one session per thread.
+        class FitSession {
+        public:
+            FitSession(const TemplateFitCalculator * fit_calc,
+                       const IFitter * fitter = nullptr);
+
+            FitSession(const FitSession & other);
+            FitSession & operator=(const FitSession & other);
+            FitSession(FitSession && other) = default;
+            FitSession & operator=(FitSession && other) = default;
+
+            void FixTemplate(int template_idx, double at = 1) { fFitCalc->FixTemplate(template_idx, at); ClearWarmStart(); }
+            void ReleaseTemplate(int template_idx) { fFitCalc->ReleaseTemplate(template_idx); ClearWarmStart(); }
+
+            ///\brief Use a clone of fitter for this session's fits
+            void SetFitter(const IFitter * fitter);
+
+            FitResult Fit(const Vector & data, const std::vector<Vector> & seeds = {});
+
+            ///\brief Opt-in cache of the last minimum. When enabled, each fit is warm started
+            /// (IFitter::WarmStart) from the previous one, which saves function calls in toy studies.
+            /// Fixing or releasing templates clears the cache
+            void SetWarmStart(bool opt) { fUseWarmStart = opt; ClearWarmStart(); }
+            void ClearWarmStart() { fWarmStartParams.resize(0); fWarmStartCovariance.resize(0, 0); }
+
+            TemplateFitCalculator * GetFitCalc() const { return fFitCalc.get(); }
+            IFitter * GetFitter() const { return fFitter.get(); }
+
+        private:
+            std::unique_ptr<TemplateFitCalculator> fFitCalc;
+            std::unique_ptr<IFitter> fFitter;
+
+            bool fUseWarmStart = false;
+            Vector fWarmStartParams;
+            Matrix fWarmStartCovariance;
+        };
+    }
+}
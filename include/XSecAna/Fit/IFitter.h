@@ -4,8 +4,13 @@
 #pragma once
 #include <Eigen/Dense>
 #include "XSecAna/IMeasurement.h"
+#include "XSecAna/Parallel.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
 
 namespace xsec {
     namespace fit {
@@ -42,46 +47,129 @@ namespace xsec {
             virtual Vector ToUserParams(const Vector & minimizer_coords) const = 0;
             virtual Vector ToMinimizerParams(const Vector & user_coords) const = 0;
 
-            std::vector<Array> GetRandomSeeds(int n, double lb, double ub) const {
-                std::default_random_engine generator;
-                std::uniform_real_distribution<double> distribution(lb, ub);
+            ///\brief Gradient of fun w.r.t. the minimizer parameters.
+            /// Default implementation uses central finite differences
+            virtual Vector Gradient(const Vector & params,
+                                    const Vector & data) const {
+                Vector gradient(params.size());
+                Vector shifted = params;
+                for (auto i = 0u; i < params.size(); i++) {
+                    double h = 1e-6 * std::max(1., std::abs(params(i)));
+                    shifted(i) = params(i) + h;
+                    double up = this->fun(shifted, data);
+                    shifted(i) = params(i) - h;
+                    double down = this->fun(shifted, data);
+                    shifted(i) = params(i);
+                    gradient(i) = (up - down) / (2 * h);
+                }
+                return gradient;
+            }
+
+            ///\brief Evaluate fun and its gradient together.
+            /// Implementations can override to share work between the two
+            virtual double FunAndGradient(const Vector & params,
+                                          const Vector & data,
+                                          Vector & gradient) const {
+                gradient = this->Gradient(params, data);
+                return this->fun(params, data);
+            }
+
+            ///\brief Hessian of fun w.r.t. the minimizer parameters.
+            /// Default implementation uses central finite differences of the gradient
+            virtual Matrix Hessian(const Vector & params,
+                                   const Vector & data) const {
+                Matrix hessian(params.size(), params.size());
+                Vector shifted = params;
+                for (auto i = 0u; i < params.size(); i++) {
+                    double h = 1e-5 * std::max(1., std::abs(params(i)));
+                    shifted(i) = params(i) + h;
+                    Vector up = this->Gradient(shifted, data);
+                    shifted(i) = params(i) - h;
+                    Vector down = this->Gradient(shifted, data);
+                    shifted(i) = params(i);
+                    hessian.col(i) = (up - down) / (2 * h);
+                }
+                return (hessian + hessian.transpose()) / 2;
+            }
+
+            ///\brief Expand a covariance of the minimizer parameters to the user parameters
+            virtual Array2D ToUserCovariance(const Matrix & minimizer_covariance) const {
+                // user params are affine in the minimizer params
+                Vector offset = this->ToUserParams(Vector::Zero(minimizer_covariance.rows()));
+                Matrix jacobian(offset.size(), minimizer_covariance.rows());
+                for (auto i = 0u; i < jacobian.cols(); i++) {
+                    jacobian.col(i) = this->ToUserParams(Vector::Unit(jacobian.cols(), i)) - offset;
+                }
+                return jacobian * minimizer_covariance * jacobian.transpose();
+            }
 
-                std::vector<Array> seeds(n);
-                for(auto ithrow = 0u; ithrow < n; ithrow++) {
-                    seeds[ithrow] = Array::Ones(this->GetNMinimizerParams());
-                    for (auto iparam = 0u; iparam < seeds[ithrow].size(); iparam++) {
-                        seeds[ithrow](iparam) += distribution(generator);
+            ///\brief Inverse of ToUserCovariance for user covariances of the same form
+            virtual Matrix ToMinimizerCovariance(const Array2D & user_covariance) const {
+                Vector offset = this->ToUserParams(Vector::Zero(this->GetNMinimizerParams()));
+                Matrix jacobian(offset.size(), this->GetNMinimizerParams());
+                for (auto i = 0u; i < jacobian.cols(); i++) {
+                    jacobian.col(i) = this->ToUserParams(Vector::Unit(jacobian.cols(), i)) - offset;
+                }
+                Matrix pinv = jacobian.completeOrthogonalDecomposition().pseudoInverse();
+                return pinv * user_covariance.matrix() * pinv.transpose();
+            }
+
+            ///\brief Latin hypercube sample of n seeds in 1 + [lb, ub) for each minimizer parameter.
+            /// Each parameter's range is split into n strata and every stratum is used once,
+            /// so the throws cover the space more evenly than independent uniform throws.
+            /// The same rng_seed always gives the same seeds.
+            std::vector<Array> GetRandomSeeds(int n, double lb, double ub,
+                                              unsigned int rng_seed = 0) const {
+                std::mt19937_64 generator(rng_seed);
+                std::uniform_real_distribution<double> distribution(0, 1);
+
+                const auto nparams = this->GetNMinimizerParams();
+                std::vector<Array> seeds(n, Array::Ones(nparams));
+                std::vector<int> strata(n);
+                for (auto iparam = 0u; iparam < nparams; iparam++) {
+                    std::iota(strata.begin(), strata.end(), 0);
+                    std::shuffle(strata.begin(), strata.end(), generator);
+                    for (auto ithrow = 0; ithrow < n; ithrow++) {
+                        seeds[ithrow](iparam) += lb + (ub - lb) * (strata[ithrow] + distribution(generator)) / n;
                     }
                 }
                 return seeds;
             }
 
+            ///\brief Evaluate fun at each seed in parallel and return the `take` seeds with the lowest values
             std::vector<Vector> GetBestSeeds(const Vector & data,
                                              const std::vector<Array> & seeds,
-                                             int take) const {
+                                             int take,
+                                             bool verbose = false) const {
                 std::vector<double> chi2(seeds.size());
                 std::vector<int> seed_idx(seeds.size());
-                for(auto i = 0u; i < seeds.size(); i++) {
-                    seed_idx[i] = i;
-                    chi2[i] = this->fun(seeds[i], data);
-                }
+                std::iota(seed_idx.begin(), seed_idx.end(), 0);
+                parallel::For(seeds.size(), [&](std::size_t i) {
+                    chi2[i] = this->fun(seeds[i].matrix(), data);
+                });
 
                 // sort seed_idx based on ascending chi2 values
-                std::sort(seed_idx.begin(), seed_idx.end(),
-                          [&chi2](int a, int b) -> bool {
-                              return chi2[a] < chi2[b];
-                          });
-
-                std::cout << "Seeding fit with the following parameter configurations:" << std::endl;
-                std::cout << "--------------------------------------------------------" << std::endl;
-                std::cout << std::left;
-                std::cout << std::setw(20) << "chi-squared" << "|" << " (seed - 1) l^2 norm / N" << std::endl;
-                std::cout << "--------------------------------------------------------" << std::endl;
+                take = std::min<int>(take, seeds.size());
+                std::partial_sort(seed_idx.begin(), seed_idx.begin() + take, seed_idx.end(),
+                                  [&chi2](int a, int b) -> bool {
+                                      return chi2[a] < chi2[b];
+                                  });
+
                 std::vector<Vector> best_seeds(take);
-                for (auto iseed = 0u; iseed < take; iseed++) {
+                for (auto iseed = 0; iseed < take; iseed++) {
                     best_seeds[iseed] = seeds[seed_idx[iseed]];
-                    std::cout << std::setw(20) << chi2[seed_idx[iseed]] << "| ";
-                    std::cout << (best_seeds[iseed] - Vector::Ones(best_seeds[iseed].size())).lpNorm<2>() / best_seeds[iseed].size()<< std::endl;
+                }
+
+                if (verbose) {
+                    std::cout << "Seeding fit with the following parameter configurations:" << std::endl;
+                    std::cout << "--------------------------------------------------------" << std::endl;
+                    std::cout << std::left;
+                    std::cout << std::setw(20) << "chi-squared" << "|" << " (seed - 1) l^2 norm / N" << std::endl;
+                    std::cout << "--------------------------------------------------------" << std::endl;
+                    for (auto iseed = 0; iseed < take; iseed++) {
+                        std::cout << std::setw(20) << chi2[seed_idx[iseed]] << "| ";
+                        std::cout << (best_seeds[iseed] - Vector::Ones(best_seeds[iseed].size())).lpNorm<2>() / best_seeds[iseed].size() << std::endl;
+                    }
                 }
                 return best_seeds;
             }
@@ -92,6 +180,20 @@ namespace xsec {
             virtual FitResult Fit(IFitCalculator * fit_calc,
                                   const Vector & data,
                                   const std::vector<Vector> seeds={}) = 0;
+
+            ///\brief Hint for the next call to Fit, typically the minimum of a previous fit to similar data.
+            /// Fitters that can use it start from minimizer_params, with minimizer_covariance
+            /// as the initial error matrix, instead of their default starting point.
+            /// The hint is used once. Ignored by default
+            virtual void WarmStart(const Vector & /*minimizer_params*/,
+                                   const Matrix & /*minimizer_covariance*/) {}
+
+            ///\brief Independent copy of this fitter, e.g. for running fits on several threads
+            virtual IFitter * Clone() const {
+                throw std::runtime_error("This IFitter does not implement Clone");
+            }
+
+            virtual ~IFitter() = default;
         };
 
 
@@ -63,7 +63,9 @@ namespace xsec {
             { return fSamples; }
 
             std::string GetConditioningSampleLabel() const { return fConditioningSampleLabel; }
+            ///\brief First of the complimentary samples
             std::string GetComplimentarySampleLabel() const { return fComplimentarySampleLabel; }
+            const std::vector<std::string> & GetComplimentarySampleLabels() const { return fComplimentarySampleLabels; }
 
         private:
             static std::shared_ptr<TH1> _to1d(const std::shared_ptr<TH1> h);
@@ -90,13 +92,17 @@ namespace xsec {
 
             std::string fConditioningSampleLabel;
             std::string fComplimentarySampleLabel;
+            std::vector<std::string> fComplimentarySampleLabels;
             std::map<std::string, const IUserTemplateComponent*> fSamples;
 
         };
 
 
         ///\brief Fitter-level template fit component for simultaneous fitting of multiple
-        // correlated samples
+        // correlated samples.
+        // The parameters are those of the conditioning sample. Parameters of the other,
+        // complimentary, samples follow from the conditional mean of their normalizations
+        // given the conditioning sample normalization.
         class ReducedJointTemplateComponent : public IReducedTemplateComponent {
         public:
             ReducedJointTemplateComponent(std::map<std::string, const IReducedTemplateComponent*> samples,
@@ -110,8 +116,16 @@ namespace xsec {
 
             [[nodiscard]] Vector Predict(const Vector & condi_params) const override;
             [[nodiscard]] Vector PredictProjected(const Vector & condi_params) const override;
+            void PredictAdd(const Vector & condi_params, Eigen::Ref<Vector> prediction) const override;
+            ///\brief Parameters of every complimentary sample, stacked in the order of GetComplimentarySampleLabels
             [[nodiscard]] Vector ComplimentaryParams(const Vector & conditioning_params) const;
+            [[nodiscard]] Vector ComplimentaryParams(const Vector & conditioning_params,
+                                                     const std::string & sample_label) const;
+            ///\brief Conditioning sample parameters that give complimentary_params for sample_label.
+            /// Defaults to the first complimentary sample
             [[nodiscard]] Vector ConditionalParams(const Vector & complimentary_params) const;
+            [[nodiscard]] Vector ConditionalParams(const Vector & complimentary_params,
+                                                   const std::string & sample_label) const;
 
             const ReducedComponent * GetNominal() const override
             { return fJointTemplateMean; }
@@ -144,17 +158,31 @@ namespace xsec {
             { return fConditioningSample; }
 
             const IReducedTemplateComponent * GetComplimentaryComponent() const
-            { return fComplimentarySample; }
+            { return fComplimentarySamples.front(); }
+
+            const IReducedTemplateComponent * GetComplimentaryComponent(const std::string & sample_label) const
+            { return fComplimentarySamples[_complimentary_sample_position(sample_label)]; }
 
             bool IsSingular() const { return fIsSingular; }
 
+            ///\brief First of the complimentary samples
             std::string GetComplimentarySampleLabel() const { return fComplimentarySampleLabel; }
+            const std::vector<std::string> & GetComplimentarySampleLabels() const { return fComplimentarySampleLabels; }
             std::string GetConditioningSampleLabel() const { return fConditioningSampleLabel; }
 
+            ///\brief Covariance of the complimentary sample normalizations given
+            /// the conditioning sample, the Schur complement of the joint covariance
             TH1 * GetPredictionCovariance() const;
 
         private:
             bool _is_singular();
+            int _complimentary_sample_position(const std::string & sample_label) const;
+            void _add_sample_prediction(const IReducedTemplateComponent * sample,
+                                        const ReducedComponent * linear_templates,
+                                        const Vector & params,
+                                        int offset,
+                                        Eigen::Ref<Vector> prediction) const;
+
             const ReducedComponent * fJointTemplateMean;
             std::map<std::string, Systematic<TH1>> fJointTemplateSystematics;
 
@@ -166,22 +194,38 @@ namespace xsec {
 
             TH1 * fJoinedNormTotalCovariance;
             std::map<std::string, TH1*> fJoinedNormCovariances;
-            Matrix fConditioningSampleInvCovariance;
+            // complimentary sample blocks are stacked along the rows
             Matrix fCrossSampleCovariance;
             Matrix fRotationMatrix;
             Matrix fPredictionCovariance;
 
+            // ComplimentaryParams is affine in the conditioning parameters,
+            // comp = fComplimentaryOffset + fComplimentaryResponse * condi,
+            // so the products with the rotation matrix are only done once
+            std::vector<Eigen::CompleteOrthogonalDecomposition<Matrix>> fRotationDecompositions;
+            Vector fComplimentaryOffset;
+            Matrix fComplimentaryResponse;
+
             Array fConditioningSampleNormalization;
             Vector fComplimentarySampleNormalization;
 
             std::string fConditioningSampleLabel;
             std::string fComplimentarySampleLabel;
+            std::vector<std::string> fComplimentarySampleLabels;
+            // position of each sample in the joined normalization, and offset
+            // of its bins in the inner bins of the joined templates
             int fConditioningSampleIdx;
-            int fComplimentarySampleIdx;
+            int fConditioningInnerOffset;
+            std::vector<int> fComplimentarySampleIdx;
+            std::vector<int> fComplimentaryInnerOffsets;
             int fNOuterBins;
 
             const IReducedTemplateComponent * fConditioningSample;
-            const IReducedTemplateComponent * fComplimentarySample;
+            std::vector<const IReducedTemplateComponent *> fComplimentarySamples;
+            // templates of samples whose prediction is the template scaled by the parameters.
+            // nullptr for other kinds of components
+            const ReducedComponent * fConditioningTemplates = nullptr;
+            std::vector<const ReducedComponent *> fComplimentaryTemplates;
             bool fIsSingular;
         };
     }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <limits>
+#include "XSecAna/Fit/IFitter.h"
+
+namespace xsec {
+    namespace fit {
+        ///\brief Limited memory, bound constrained quasi-Newton fitter (L-BFGS-B).
+        // Byrd, Lu, Nocedal and Zhu, SIAM J. Sci. Comput. 16 (1995) 1190.
+        // Only the last `memory` correction pairs are kept, so memory is
+        // linear in the number of parameters, unlike Migrad's dense error matrix.
+        // Uses IFitCalculator::FunAndGradient and only computes
+        // IFitCalculator::Hessian once at the minimum for the parameter covariance.
+        // Parameters are bounded below by 0 like in Minuit2TemplateFitter.
+        class LBFGSBFitter : public IFitter {
+        public:
+            LBFGSBFitter(double up = 1,
+                         int memory = 10,
+                         int max_iterations = 10000,
+                         double gradient_tolerance = 1e-5,
+                         double function_tolerance = 1e-12)
+                    : fUp(up),
+                      fMemory(memory),
+                      fMaxIterations(max_iterations),
+                      fGradientTolerance(gradient_tolerance),
+                      fFunctionTolerance(function_tolerance)
+            {}
+
+            virtual FitResult Fit(IFitCalculator * fit_calc,
+                                  const Vector & data,
+                                  std::vector<Vector> seeds = {}) override;
+
+            virtual IFitter * Clone() const override { return new LBFGSBFitter(*this); }
+
+            ///\brief Start from minimizer_params on the next fit.
+            /// The covariance isn't needed since the Hessian approximation is rebuilt from the iterations
+            virtual void WarmStart(const Vector & minimizer_params,
+                                   const Matrix & /*minimizer_covariance*/) override { fWarmStartParams = minimizer_params; }
+
+            void SetBounds(double lower, double upper) { fLowerBound = lower; fUpperBound = upper; }
+
+            unsigned int GetNIterations() const { return fNIterations; }
+
+        private:
+            ///\brief Result of minimizing from a single starting point
+            struct Minimum {
+                Vector params;
+                double fun_val;
+                bool converged;
+                int iterations;
+            };
+
+            Minimum Minimize(IFitCalculator * fit_calc,
+                             const Vector & data,
+                             const Vector & seed) const;
+
+            double fUp;
+            int fMemory;
+            int fMaxIterations;
+            double fGradientTolerance;
+            double fFunctionTolerance;
+            double fLowerBound = 0;
+            double fUpperBound = std::numeric_limits<double>::infinity();
+            unsigned int fNIterations = 0;
+            Vector fWarmStartParams;
+        };
+    }
+}
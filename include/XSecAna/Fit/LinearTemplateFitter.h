@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include "XSecAna/Fit/IFitter.h"
+
+namespace xsec {
+    namespace fit {
+        ///\brief Fitter for TemplateFitCalculators that exploits the linearity
+        /// of the prediction in the template normalization parameters.
+        // For a fixed covariance the chi2 is quadratic, so the bounded (p >= 0)
+        // generalized least squares problem is solved directly with an active set
+        // NNLS solve of the normal equations. The CNP statistical term depends on the
+        // prediction, so it is frozen at the current estimate and updated until the
+        // parameters stop changing (iteratively reweighted least squares).
+        // With the statistical term included, the fixed point neglects the derivative of the
+        // covariance w.r.t. the parameters. Use it to seed Minuit2TemplateFitter
+        // (see Minuit2TemplateFitter::SetSeedFitter) when the exact minimum is needed.
+        class LinearTemplateFitter : public IFitter {
+        public:
+            LinearTemplateFitter(double up = 1,
+                                 int max_iterations = 100,
+                                 double tolerance = 1e-8)
+                    : fUp(up),
+                      fMaxIterations(max_iterations),
+                      fTolerance(tolerance)
+            {}
+
+            virtual FitResult Fit(IFitCalculator * fit_calc,
+                                  const Vector & data,
+                                  std::vector<Vector> seeds = {}) override;
+
+            virtual IFitter * Clone() const override { return new LinearTemplateFitter(*this); }
+
+            ///\brief Minimize 1/2 x^T H x - f^T x subject to x >= 0
+            /// using the Lawson-Hanson active set method, starting from x0
+            static Vector NNLS(const Matrix & H, const Vector & f, const Vector & x0);
+
+        private:
+            double fUp;
+            int fMaxIterations;
+            double fTolerance;
+        };
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <memory>
 #include "XSecAna/Fit/IFitter.h"
 
 #include "Minuit2/FCNBase.h"
@@ -8,6 +9,7 @@
 #include "Minuit2/FunctionMinimum.h"
 #include "Minuit2/MnMigrad.h"
 #include "Minuit2/MnPrint.h"
+#include "Minuit2/MnUserCovariance.h"
 
 #include "RVersion.h"
 
@@ -29,6 +31,9 @@ namespace xsec {
                       fInitialError(initial_error)
             {}
 
+            ///\brief The copy gets its own clone of the seed fitter
+            Minuit2TemplateFitter(const Minuit2TemplateFitter & other);
+
             // IFitter overrides
             virtual FitResult Fit(IFitCalculator * fit_calc,
                                   const Vector & data,
@@ -41,13 +46,29 @@ namespace xsec {
             void SetPrintLevel(const int & level) const;
             void SetMinosErrors(bool opt) { fMinosErrors = opt; }
 
+            ///\brief Run seed_fitter first and start Migrad from its minimum
+            /// in addition to any user-provided seeds. eg. LinearTemplateFitter.
+            /// Uses a clone of seed_fitter
+            void SetSeedFitter(const IFitter * seed_fitter) { fSeedFitter.reset(seed_fitter ? seed_fitter->Clone() : nullptr); }
+
+            ///\brief Start the first Migrad of the next fit from minimizer_params,
+            /// using minimizer_covariance as the initial error matrix instead of fInitialError
+            virtual void WarmStart(const Vector & minimizer_params,
+                                   const Matrix & minimizer_covariance) override;
+
+            virtual IFitter * Clone() const override { return new Minuit2TemplateFitter(*this); }
+
         private:
+            std::unique_ptr<IFitter> fSeedFitter;
             IFitCalculator * fFitCalc;
             int fMnStrategy;
             double fUp;
             bool fMinosErrors;
             double fInitialError;
             Vector fData;
+
+            Vector fWarmStartParams;
+            Matrix fWarmStartCovariance;
         };
 
     }
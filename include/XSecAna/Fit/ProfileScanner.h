@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include "XSecAna/Fit/IFitter.h"
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+
+namespace xsec {
+    namespace fit {
+        ///\brief Profiles the chi2 over a set of points in a few user parameters
+        // At each point the scanned parameters are fixed and the rest are refit.
+        // Points are grouped into paths. The points of a path are fit one after another,
+        // each warm started (IFitter::WarmStart) from the minimum at the previous point.
+        // Paths run in parallel, each in its own FitSession,
+        // so the ParamMap of the calculator passed in is never modified.
+        class ProfileScanner {
+        public:
+            ProfileScanner(const TemplateFitCalculator * fit_calc,
+                           const IFitter * fitter,
+                           int nthreads = 0)
+                    : fFitCalc(fit_calc),
+                      fFitter(fitter),
+                      fNThreads(nthreads)
+            {}
+
+            ///\brief Returns the profiled fit at each row of points.
+            /// params are the user parameter indices fixed to the values in the columns of points.
+            /// The first point of each path is warm started from start.
+            /// Points where the fit fails have is_valid = false and a NaN fun_val
+            std::vector<FitResult> Scan(const Vector & data,
+                                        const std::vector<int> & params,
+                                        const Matrix & points,
+                                        const std::vector<std::vector<int>> & paths,
+                                        const FitResult & start) const;
+
+            ///\brief Split 1D scan values into npaths contiguous paths.
+            /// Each path runs away from the value closest to origin
+            /// so that it follows the profile outward from the minimum
+            static std::vector<std::vector<int>> SweepPaths(const std::vector<double> & values,
+                                                            double origin,
+                                                            int npaths);
+
+        private:
+            const TemplateFitCalculator * fFitCalc;
+            const IFitter * fFitter;
+            int fNThreads;
+        };
+    }
+}
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "XSecAna/Fit/IFitter.h"
+#include "XSecAna/Parallel.h"
+#include "XSecAna/Fit/CovarianceSolver.h"
 #include "XSecAna/Fit/TemplateFitComponent.h"
 #include "XSecAna/Systematic.h"
 #include <Eigen/Dense>
 #include <cmath>
+#include <memory>
 #include <vector>
 
 namespace xsec {
@@ -15,8 +18,22 @@ namespace xsec {
             TemplateFitCalculator(const ReducedComponentCollection & templates,
                                   const std::vector<int> & dims,
                                   const Matrix & systematic_covariance,
+                                  bool ignore_statistical_uncertainty = false,
+                                  CovarianceStructure_t covariance_structure = kAutoStructure);
+
+            ///\brief Restore a calculator from pieces computed by a previous one,
+            /// e.g. from a TemplateFitSignalEstimator snapshot.
+            /// Skips setting up the design matrix and checking the covariance inversion
+            TemplateFitCalculator(const ReducedComponentCollection & templates,
+                                  std::shared_ptr<const CovarianceSolver> covariance_solver,
+                                  std::shared_ptr<const Eigen::SparseMatrix<double>> design_matrix,
+                                  std::shared_ptr<const Vector> prediction_offset,
                                   bool ignore_statistical_uncertainty = false);
 
+            ///\brief Independent copy that can be fixed, released and fit on another thread.
+            /// Components are shared since they are never modified
+            virtual TemplateFitCalculator * Clone() const { return new TemplateFitCalculator(*this); }
+
             void FixTemplate(const int & template_idx, const double & at = 1);
 
             void ReleaseTemplate(const int & template_idx);
@@ -33,6 +50,9 @@ namespace xsec {
 
             const detail::ParamMap & GetParamMap() const { return fParamMap; }
 
+            ///\brief Values of the fixed templates, 0 for the others
+            const Vector & GetFixedParams() const { return fFixedParams; }
+
             virtual Vector Predict(const Vector & user_params) const;
             virtual Vector PredictComponent(const std::string & component_label, const Vector & user_params) const;
 
@@ -43,23 +63,63 @@ namespace xsec {
             Vector ToMinimizerParams(const Vector & user_coords) const override;
             double fun(const Vector & minimizer_params,
                        const Vector & data) const override;
-                                                              ;
+
+            Vector Gradient(const Vector & minimizer_params,
+                            const Vector & data) const override;
+
+            double FunAndGradient(const Vector & minimizer_params,
+                                  const Vector & data,
+                                  Vector & gradient) const override;
+
+            ///\brief Gauss-Newton approximation, 2 A^T C^-1 A.
+            /// Neglects derivatives of the statistical covariance
+            Matrix Hessian(const Vector & minimizer_params,
+                           const Vector & data) const override;
 
             void AddNoise(double noise);
 
-            Matrix GetSystematicCovariance() const { return fSystematicCovariance; }
+            ///\brief CNP approximation to the statistical variance of each bin
+            Vector StatisticalVariance(const Vector & prediction, const Vector & data) const;
+
+            ///\brief The prediction is affine in the user parameters:
+            /// Predict(p) = GetPredictionOffset() + GetDesignMatrix() * p
+            const Eigen::SparseMatrix<double> & GetDesignMatrix() const { return *fDesignMatrix; }
+            const Vector & GetPredictionOffset() const { return *fPredictionOffset; }
+
+            ///\brief Columns of the design matrix for the free (minimizer) parameters
+            Matrix GetMinimizerDesignMatrix() const;
+
+            ///\brief Expand a minimizer parameter covariance to user parameters.
+            /// Rows and columns of fixed parameters are zero
+            Array2D ToUserCovariance(const Matrix & minimizer_covariance) const override;
+
+            Matrix ToMinimizerCovariance(const Array2D & user_covariance) const override;
+
+            Matrix GetSystematicCovariance() const { return fCovarianceSolver->GetCovariance(); }
+            const CovarianceSolver & GetCovarianceSolver() const { return *fCovarianceSolver; }
+            std::shared_ptr<const CovarianceSolver> GetSharedCovarianceSolver() const { return fCovarianceSolver; }
+
+            ///\brief Override the covariance structure detected at construction
+            void SetCovarianceStructure(CovarianceStructure_t structure);
             Matrix GetTotalCovariance(const Vector & params) const;
 
             void SetIgnoreStatisticalUncertainty(bool ignore) { fIgnoreStatisticalUncertainty = ignore; }
             double GetIgnoreStatisticalUncertainty() const { return fIgnoreStatisticalUncertainty; }
 
         private:
+            void SetupDesignMatrix();
+
+            Vector StatisticalVarianceDerivative(const Vector & prediction, const Vector & data) const;
+
             void SetSystematicDeterminant();
             static double LogDetV(const Eigen::LLT<Matrix> & decomp);
 
             void WarnInversionError() const;
 
-            Matrix fSystematicCovariance;
+            // immutable and shared between clones.
+            // Replaced, never modified, when the covariance changes
+            std::shared_ptr<const CovarianceSolver> fCovarianceSolver;
+            CovarianceStructure_t fCovarianceStructure;
             ReducedComponentCollection fComponents;
             int fNUserParams;
             int fNComponents;
@@ -67,11 +127,13 @@ namespace xsec {
             detail::ParamMap fParamMap;
             Vector fFixedParams;
 
-            mutable unsigned int fNFunCalls;
+            std::shared_ptr<const Eigen::SparseMatrix<double>> fDesignMatrix;
+            std::shared_ptr<const Vector> fPredictionOffset;
+
+            mutable parallel::Counter fNFunCalls;
 
             bool fIgnoreStatisticalUncertainty;
 
-            mutable Eigen::LLT<Matrix> fDecomp;
             double fDetSystematicCovariance;
             //mutable Eigen::PartialPivLU<Matrix> fDecomp;
 
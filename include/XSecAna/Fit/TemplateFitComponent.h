@@ -152,6 +152,12 @@ namespace xsec {
         public:
             [[nodiscard]] virtual Vector Predict(const Vector & component_params) const = 0;
             [[nodiscard]] virtual Vector PredictProjected(const Vector & component_params) const = 0;
+
+            ///\brief Adds Predict(component_params) to prediction.
+            /// Overridden by components that can skip the temporary
+            virtual void PredictAdd(const Vector & component_params, Eigen::Ref<Vector> prediction) const
+            { prediction += this->Predict(component_params); }
+
             virtual const ReducedComponent * GetNominal() const = 0;
             virtual const ReducedComponent * GetNominalForErrorCalculation() const { return this->GetNominal(); }
             virtual const std::map<std::string, Systematic<TH1>> & GetSystematics() const = 0;
@@ -265,6 +271,7 @@ namespace xsec {
 
             [[nodiscard]] Vector Predict(const Vector & component_params) const override;
             [[nodiscard]] Vector PredictProjected(const Vector & component) const override;
+            void PredictAdd(const Vector & component_params, Eigen::Ref<Vector> prediction) const override;
             const ReducedComponent * GetNominal() const override { return fMean; }
             const std::map<std::string, Systematic<TH1>> & GetSystematics() const override { return fSystematics; }
 
@@ -8,10 +8,13 @@
 
 #include <vector>
 #include <typeinfo>
+#include <mutex>
+#include <shared_mutex>
 
 namespace xsec {
     typedef Eigen::ArrayXd Array;
     typedef Eigen::Ref<Array> ArrayRef;
+    typedef Eigen::Ref<Array2D> Array2DRef;
 
     class IMeasurement {
     public:
@@ -36,6 +39,43 @@ namespace xsec {
     };
     typedef xsec::type::LoadFunction<IMeasurement> LoadMeasurementFunc;
 
+    ///\brief Arrays computed once and reused, e.g. the output of a data independent measurement.
+    // Valid arrays are read under a shared lock and written under an exclusive one.
+    // Copies get their own lock.
+    struct EvalCache {
+        EvalCache() = default;
+
+        EvalCache(const EvalCache & other) {
+            std::shared_lock<std::shared_mutex> lock(other.mutex);
+            valid = other.valid;
+            key = other.key;
+            result = other.result;
+            rerror = other.rerror;
+        }
+
+        EvalCache & operator=(const EvalCache & other) {
+            if (this == &other) return *this;
+            std::scoped_lock lock(mutex, other.mutex);
+            valid = other.valid;
+            key = other.key;
+            result = other.result;
+            rerror = other.rerror;
+            return *this;
+        }
+
+        ///\brief True if the arrays were computed from the inputs identified by inputs_key
+        bool IsValidFor(const Array & inputs_key) const {
+            return valid && key.size() == inputs_key.size() && (key == inputs_key).all();
+        }
+
+        mutable std::shared_mutex mutex;
+        bool valid = false;
+        // identifies the inputs the arrays were computed from, if they can change
+        Array key;
+        Array result;
+        Array rerror;
+    };
+
     class IEigenEval : public virtual IMeasurement {
     public:
         std::shared_ptr<TH1> Eval(const TH1 * data) const final {
@@ -48,16 +88,97 @@ namespace xsec {
 
             Array _result(fHistProps.nbins_and_uof);
             Array _rerror(fHistProps.nbins_and_uof);
-            this->_eval_impl(_data, _error,
-                             _result, _rerror);
+            this->_eval(_data, _error,
+                        _result, _rerror);
             return std::shared_ptr<TH1>(root::ToROOT(_result, _rerror, fHistProps));
 
         }
+
+        ///\brief Evaluate every column of data at once, e.g. each universe of a multiverse.
+        /// Rows are the bins of like, including under/overflow
+        std::pair<Array2D, Array2D> EvalBatch(const TH1 * like,
+                                              const Array2D & data,
+                                              const Array2D & error) const {
+            fHistProps = root::TH1Props(like);
+            Array2D result(data.rows(), data.cols());
+            Array2D rerror(data.rows(), data.cols());
+            this->_eval_batch(data, error, result, rerror);
+            return {result, rerror};
+        }
+
+        ///\brief True if the result does not depend on the data, e.g. an efficiency taken from simulation.
+        /// The result is then computed on the first evaluation and reused until InvalidateCache is called.
+        /// Only worth it when _eval_impl costs more than copying its result
+        virtual bool IsDataIndependent() const { return false; }
+
+        ///\brief Drop the cached result of a data independent measurement.
+        /// Call after changing its inputs
+        void InvalidateCache() const {
+            std::unique_lock<std::shared_mutex> lock(fCache.mutex);
+            fCache.valid = false;
+        }
+
+        ///\brief _eval_impl, reusing the cached result if the measurement is data independent
+        void _eval(const Array & data, const Array & error,
+                   ArrayRef result, ArrayRef rerror) const {
+            if (!this->IsDataIndependent()) {
+                this->_eval_impl(data, error, result, rerror);
+                return;
+            }
+            {
+                std::shared_lock<std::shared_mutex> lock(fCache.mutex);
+                if (fCache.valid && fCache.result.size() == data.size()) {
+                    result = fCache.result;
+                    rerror = fCache.rerror;
+                    return;
+                }
+            }
+            std::unique_lock<std::shared_mutex> lock(fCache.mutex);
+            if (!fCache.valid || fCache.result.size() != data.size()) {
+                fCache.result.resize(data.size());
+                fCache.rerror.resize(data.size());
+                this->_eval_impl(data, error, fCache.result, fCache.rerror);
+                fCache.valid = true;
+            }
+            result = fCache.result;
+            rerror = fCache.rerror;
+        }
+
+        ///\brief _eval_batch_impl, replicating the cached result if the measurement is data independent
+        void _eval_batch(const Array2D & data, const Array2D & error,
+                         Array2DRef result, Array2DRef rerror) const {
+            if (!this->IsDataIndependent()) {
+                this->_eval_batch_impl(data, error, result, rerror);
+                return;
+            }
+            if (data.cols() == 0) return;
+            Array col_result(data.rows());
+            Array col_rerror(data.rows());
+            this->_eval(data.col(0), error.col(0), col_result, col_rerror);
+            result = col_result.replicate(1, data.cols());
+            rerror = col_rerror.replicate(1, data.cols());
+        }
+
         virtual ~IEigenEval()= default;
         virtual void _eval_impl(const Array & data, const Array & error,
                                 ArrayRef result, ArrayRef rerror) const = 0;
+
+        ///\brief Batched _eval_impl. Columns are independent inputs.
+        /// Loops over columns unless overridden.
+        /// result and rerror may alias data and error
+        virtual void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                                      Array2DRef result, Array2DRef rerror) const {
+            Array col_result(data.rows());
+            Array col_rerror(data.rows());
+            for (auto i = 0; i < data.cols(); i++) {
+                this->_eval_impl(data.col(i), error.col(i), col_result, col_rerror);
+                result.col(i) = col_result;
+                rerror.col(i) = col_rerror;
+            }
+        }
         const root::TH1Props & GetHistProps() const { return fHistProps; }
     private:
         mutable root::TH1Props fHistProps;
+        mutable EvalCache fCache;
     };
 }
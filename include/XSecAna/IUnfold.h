@@ -33,10 +33,13 @@ namespace xsec {
 
     protected:
         void _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const override;
+        void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                              Array2DRef result, Array2DRef rerror) const override;
         Eigen::MatrixXd fMat;
     };
 
 
+    inline
     void
     IdentityUnfolder::
     _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const {
@@ -44,13 +47,23 @@ namespace xsec {
          rerror = error;
     }
 
+    inline
+    void
+    IdentityUnfolder::
+    _eval_batch_impl(const Array2D & data, const Array2D & error, Array2DRef result, Array2DRef rerror) const {
+        result = (fMat * data.matrix()).array();
+        rerror = error;
+    }
+
     /////////////////////////////////////////////////////////
+    inline
     IdentityUnfolder::
     IdentityUnfolder(int nbins_and_uof) {
         fMat = Eigen::MatrixXd::Identity(nbins_and_uof, nbins_and_uof);
     }
 
     /////////////////////////////////////////////////////////
+    inline
     std::shared_ptr<TH1>
     IdentityUnfolder::
     Truth(const TH1 * reco) const {
@@ -58,6 +71,7 @@ namespace xsec {
     }
 
     /////////////////////////////////////////////////////////
+    inline
     void
     IdentityUnfolder::
     SaveTo(TDirectory * dir, const std::string & subdir) const {
@@ -71,6 +85,7 @@ namespace xsec {
     }
 
     /////////////////////////////////////////////////////////
+    inline
     std::unique_ptr<IMeasurement>
     IdentityUnfolder::
     LoadFrom(TDirectory* dir,
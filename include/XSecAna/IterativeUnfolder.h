@@ -0,0 +1,76 @@
+#pragma once
+
+#include "TDirectory.h"
+#include "TH2.h"
+
+#include "XSecAna/IUnfold.h"
+
+#include <Eigen/Sparse>
+#include <functional>
+
+namespace xsec {
+
+    ///\brief Iterative Bayesian unfolding.
+    // D'Agostini, Nucl. Instrum. Meth. A 362 (1995) 487.
+    // Starting from the truth distribution of the response as the prior, each iteration
+    //   t_j <- t_j * sum_i M_ij d_i / (M t)_i
+    // where M is the migration matrix P(reco i | truth j).
+    // Columns of M are normalized to one since the efficiency correction is applied
+    // separately by the IEfficiency of a cross section.
+    // The response is kept sparse, so an iteration costs O(nonzero migrations).
+    class IterativeUnfolder : public IEigenUnfoldEstimator {
+    public:
+        ///\brief response has reco bins on the x axis and truth bins on the y axis.
+        /// Both axes need the same number of bins so unfolded histograms take the binning of the data
+        IterativeUnfolder(const TH2 * response, int niterations);
+
+        ///\brief response(reco bin, truth bin), including under/overflow bins
+        IterativeUnfolder(const Eigen::SparseMatrix<double> & response, int niterations);
+
+        std::shared_ptr<TH1> Truth(const TH1 * reco) const override;
+
+        ///\brief Unfold every column of reco at once, e.g. all universes of a systematic.
+        /// Rows are reco bins including under/overflow.
+        /// Blocks of columns are unfolded on separate threads
+        Matrix Unfold(const Matrix & reco) const;
+
+        int GetNIterations() const { return fNIterations; }
+
+        const Eigen::SparseMatrix<double> & GetResponse() const { return fResponse; }
+
+        const Eigen::SparseMatrix<double> & GetMigrationMatrix() const { return fMigration; }
+
+        void SaveTo(TDirectory * dir, const std::string & subdir) const override;
+
+        static std::unique_ptr<IMeasurement> LoadFrom(TDirectory * dir, const std::string & subdir);
+
+        virtual ~IterativeUnfolder() = default;
+
+    protected:
+        ///\brief Errors are propagated to first order through the last iteration,
+        /// holding its prior fixed
+        void _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const override;
+        void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                              Array2DRef result, Array2DRef rerror) const override;
+
+    private:
+        static Eigen::SparseMatrix<double> _response_matrix(const TH2 * response);
+
+        ///\brief Iterate on a block of columns. Leaves the prior and folded prior
+        /// of the last iteration in prior and folded
+        Matrix _unfold(const Matrix & reco, Matrix & prior, Matrix & folded) const;
+
+        ///\brief Variance of the unfolded bins from the data errors, given the last prior and folded prior
+        Matrix _variance(const Matrix & prior, const Matrix & folded, const Matrix & error) const;
+
+        ///\brief Call fn(first column, number of columns) for blocks of columns in parallel
+        void _for_column_blocks(std::size_t ncols, const std::function<void(std::size_t, std::size_t)> & fn) const;
+
+        Eigen::SparseMatrix<double> fResponse;
+        Eigen::SparseMatrix<double> fMigration;
+        // transpose is stored to keep both products column major
+        Eigen::SparseMatrix<double> fMigrationT;
+        Vector fPrior;
+        int fNIterations;
+    };
+}
@@ -25,10 +25,22 @@ namespace xsec {
 
         TemplateFitSignalEstimator * GetSampleTemplateFit(const std::string & name) const { return fSampleEstimators.at(name); }
         TemplateFitSignalEstimator * GetJointTemplateFit() const { return fJointEstimator; }
-        TemplateFitSignalEstimator * GetInvertedJointTemplateFit() const { return fJointEstimatorInverse; }
 
+        ///\brief Indices of the reduced template bins of sample_name in the joint template bins.
+        /// The per-sample covariances are covariance(bins, bins) of the joint ones.
+        /// Empty if the per-sample estimators were built on their own
+        std::vector<int> GetSampleBins(const std::string & sample_name) const
+        { return fSampleBins.count(sample_name) ? fSampleBins.at(sample_name) : std::vector<int>(); }
+
+        ///\brief Parameters of the first complimentary sample of each component
         std::map<std::string, TH1*> ComplimentaryParams(const std::map<std::string, TH1*> & condi_params) const;
-        std::map<std::string, TH1*> InvertParams(const std::map<std::string, TH1*> & condi_params) const;
+        ///\brief Parameters of each component in sample_label given the parameters of its conditioning sample
+        std::map<std::string, TH1*> ComplimentaryParams(const std::map<std::string, TH1*> & condi_params,
+                                                        const std::string & sample_label) const;
+        ///\brief Same as ComplimentaryParams(condi_params). Kept for code written against
+        /// two-sample joint fits
+        std::map<std::string, TH1*> InvertParams(const std::map<std::string, TH1*> & condi_params) const
+        { return ComplimentaryParams(condi_params); }
 
         void FixComponent(const std::string & template_name, const double & val=1);
         void ReleaseComponent(const std::string & template_name);
@@ -49,32 +61,20 @@ namespace xsec {
 
         static std::shared_ptr<TH1> JoinData(const std::map<std::string, std::shared_ptr<TH1>> & data_samples);
     private:
+        std::map<std::string, fit::ReducedComponentCollection>
+        _sample_reduced_components(const std::map<std::string, fit::TemplateFitSample> & samples);
+
         std::map<std::string, TemplateFitResult> _joint_fit_result(const TemplateFitResult & condi_sample_fit_result) const;
-        std::map<std::string, TemplateFitResult> _joint_fit_result_run_inverse(TemplateFitResult condi_sample_fit_result,
-                                                                               std::shared_ptr<TH1> inverted_data,
-                                                                               int nrandom_seeds) const;
-        std::map<std::string, TemplateFitResult> _joint_fit_result_run_inverse(TemplateFitResult condi_sample_fit_result,
-                                                                               std::shared_ptr<TH1> inverted_data,
-                                                                               const std::map<std::string, TH1*> & seed) const;
-        void _update_results_with_bias_uncertainty(TemplateFitResult & condi, TemplateFitResult & comp) const;
-
-        void _update_fixed_component_fit_result(TemplateFitResult & result,
-                                                std::string component_label,
-                                                const Systematic<TH1> & prefit_error) const;
-
-        template<class T>
-        std::map<std::string, T> _invert_samples(const std::map<std::string, T> & samples) const;
-        TH1 * _condi_params_to_comp_params(const std::string & name, const TH1 * condi) const;
+
+        TH1 * _condi_params_to_comp_params(const std::string & name,
+                                           const TH1 * condi,
+                                           const std::string & sample_label) const;
         TemplateFitSignalEstimator * fJointEstimator;
-        TemplateFitSignalEstimator * fJointEstimatorInverse;
         std::map<std::string, TemplateFitSignalEstimator*> fSampleEstimators;
+        std::map<std::string, std::vector<int>> fSampleBins;
 
         std::set<std::string> fFixedComponentLabels;
         fit::ComponentReducer fReducer;
-
-        std::string fCondiSampleLabel;
-        std::string fComplimentarySampleLabel;
-
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace xsec {
+    namespace detail {
+        ///\brief Leading member of the header of every file format read through a MappedFile.
+        // Headers and data are stored in native byte order, so files can only be
+        // read on machines with the byte order of the one that wrote them.
+        struct FileSignature {
+            char magic[8];
+            std::uint64_t version;
+        };
+    }
+
+    ///\brief Read-only memory map of a whole file.
+    // The mapping lives as long as the MappedFile, so pointers into it
+    // (e.g. Eigen::Map's over columns) must not outlive it.
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string & path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile && other) noexcept;
+        MappedFile & operator=(MappedFile && other) noexcept;
+
+        const char * data() const { return fData; }
+        std::size_t size() const { return fSize; }
+        const std::string & path() const { return fPath; }
+
+        template<class T>
+        const T * as(std::size_t offset = 0) const { return reinterpret_cast<const T *>(fData + offset); }
+
+        ///\brief Copy of the Header at the start of the file. Header starts with a FileSignature.
+        /// Throws unless the file begins with magic and one of versions.
+        /// description names the format in errors, e.g. "array file"
+        template<class Header>
+        Header ReadHeader(const char * magic,
+                          std::initializer_list<std::uint64_t> versions,
+                          const std::string & description) const;
+
+        ///\brief Blocks of data start on kAlignment byte boundaries so mapped doubles are aligned
+        static const std::size_t kAlignment = 64;
+        static std::size_t Align(std::size_t offset) { return (offset + kAlignment - 1) / kAlignment * kAlignment; }
+
+        ///\brief Signature to write at the start of a file. magic has 8 characters
+        static detail::FileSignature Signature(const char * magic, std::uint64_t version);
+
+        ///\brief Zero pad a file being written up to offset
+        static void PadTo(std::ostream & file, std::size_t offset);
+
+    private:
+        void Unmap();
+        void CheckSignature(const detail::FileSignature & signature,
+                            const char * magic,
+                            std::initializer_list<std::uint64_t> versions,
+                            const std::string & description) const;
+
+        std::string fPath;
+        const char * fData = nullptr;
+        std::size_t fSize = 0;
+    };
+
+    template<class Header>
+    Header
+    MappedFile::
+    ReadHeader(const char * magic,
+               std::initializer_list<std::uint64_t> versions,
+               const std::string & description) const {
+        Header header;
+        if (fSize < sizeof(header)) {
+            throw std::runtime_error(fPath + " is not a valid " + description);
+        }
+        std::memcpy(&header, fData, sizeof(header));
+        CheckSignature(header.signature, magic, versions, description);
+        return header;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "XSecAna/MappedFile.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/Systematic.h"
+
+#include <cstdint>
+#include <string>
+
+namespace xsec {
+    namespace detail {
+        ///\brief File header of a MultiverseFile. Followed by the metadata
+        /// (name and binning), then the shifts.
+        // Uncompressed files hold one contiguous bins x universes block of contents
+        // (column-major, so each universe is contiguous) followed by one of errors.
+        // Compressed files split universes into chunks, each compressed on its own
+        // with ROOT's compression algorithms and listed in an index of
+        // (offset, stored bytes, raw bytes).
+        struct MultiverseFileHeader {
+            FileSignature signature;
+            std::uint64_t type;
+            std::uint64_t nbins;
+            std::uint64_t nuniverses;
+            std::uint64_t has_errors;
+            std::uint64_t compression;
+            std::uint64_t universes_per_chunk;
+            std::uint64_t nchunks;
+            std::uint64_t metadata_offset;
+            std::uint64_t metadata_size;
+            std::uint64_t index_offset;
+            std::uint64_t data_offset;
+        };
+    }
+
+    ///\brief Single file storage of a Systematic<TH1> as one bins x universes block.
+    // An alternative to Systematic::SaveTo for large multiverses, which stores
+    // every universe as a separate histogram. Loaded systematics are backed by a
+    // MultiverseMatrix and can be written back to the ROOT layout with SaveTo.
+    // Ranges of universes or bins can be read without reading the whole file,
+    // and uncompressed files can be used in place through Map.
+    class MultiverseFile {
+    public:
+        explicit MultiverseFile(const std::string & path);
+
+        ///\brief compression follows TFile's convention of 100 * algorithm + level.
+        /// 0 writes an uncompressed, memory-mappable file.
+        /// universes_per_chunk <= 0 picks chunks of a few MB
+        static void Write(const Systematic<TH1> & systematic,
+                          const std::string & path,
+                          int compression = 101,
+                          int universes_per_chunk = 0,
+                          bool store_errors = true);
+
+        const std::string & GetName() const { return fName; }
+        SystType_t GetType() const { return (SystType_t) fHeader.type; }
+        std::size_t GetNBins() const { return fHeader.nbins; }
+        std::size_t GetNUniverses() const { return fHeader.nuniverses; }
+        bool HasErrors() const { return fHeader.has_errors; }
+        bool IsCompressed() const { return fHeader.compression > 0; }
+        const TH1 * GetBinning() const { return fBinning.get(); }
+
+        Systematic<TH1> Load() const;
+
+        std::shared_ptr<MultiverseMatrix> Read() const;
+
+        ///\brief Universes [first, first + n)
+        std::shared_ptr<MultiverseMatrix> ReadUniverses(std::size_t first, std::size_t n) const;
+
+        ///\brief Contents (or errors) of bins [first, first + n) in every universe
+        Matrix ReadBins(std::size_t first, std::size_t n, bool errors = false) const;
+
+        ///\brief Zero-copy view of the contents (or errors) of an uncompressed file.
+        /// Valid for the lifetime of this MultiverseFile
+        Eigen::Map<const Matrix> Map(bool errors = false) const;
+
+    private:
+        struct ChunkIndex {
+            std::uint64_t offset;
+            std::uint64_t stored_bytes;
+            std::uint64_t raw_bytes;
+        };
+
+        ///\brief Contents and errors of universes [first, first + n) from chunks
+        void ReadChunks(std::size_t first, std::size_t n,
+                        Matrix & contents, Matrix & errors, bool read_errors) const;
+
+        MappedFile fFile;
+        detail::MultiverseFileHeader fHeader;
+        std::string fName;
+        std::shared_ptr<TH1> fBinning;
+    };
+}
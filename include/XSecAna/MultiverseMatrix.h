@@ -0,0 +1,57 @@
+#pragma once
+
+#include "XSecAna/Utils.h"
+
+#include <memory>
+#include <vector>
+
+namespace xsec {
+    ///\brief Multiverse of histograms sharing one binning, stored as a single
+    /// bins x universes matrix (bins include under/overflow in ROOT's global bin order).
+    // Universe-wide operations (means, covariances, percentiles) run on the matrix
+    // directly instead of on one TH1 at a time. Histograms are only made on request.
+    class MultiverseMatrix {
+    public:
+        ///\brief binning is only used for its axes. errors may be left empty,
+        /// in which case universes are materialized with ROOT's default sqrt(N) errors
+        MultiverseMatrix(const TH1 * binning,
+                         Matrix universes,
+                         Matrix errors = Matrix());
+
+        explicit MultiverseMatrix(const std::vector<std::shared_ptr<TH1>> & universes);
+
+        std::size_t GetNUniverses() const { return fUniverses.cols(); }
+        std::size_t GetNBins() const { return fUniverses.rows(); }
+
+        const Matrix & GetMatrix() const { return fUniverses; }
+        const Matrix & GetErrors() const { return fErrors; }
+        bool HasErrors() const { return fErrors.size() > 0; }
+        const TH1 * GetBinning() const { return fBinning.get(); }
+
+        std::shared_ptr<TH1> GetUniverse(std::size_t i) const;
+        std::vector<std::shared_ptr<TH1>> ToTH1s() const;
+
+        Vector Mean() const;
+
+        ///\brief Covariance of the universes about their mean
+        Matrix Covariance() const;
+
+        ///\brief Bin by bin, the universe nsigma away from nominal. See MultiverseShift
+        Array Shift(const Array & nominal, double nsigma) const;
+
+        ///\brief New multiverse taking, for each output bin, the row index of this one
+        /// (or -1 for an empty bin). binning defines the axes of the result
+        std::shared_ptr<MultiverseMatrix> Gather(const std::vector<int> & rows,
+                                                 const TH1 * binning,
+                                                 bool keep_errors = true) const;
+
+    private:
+        std::shared_ptr<TH1> fBinning;
+        Matrix fUniverses;
+        Matrix fErrors;
+    };
+
+    ///\brief Bin by bin, the universe nsigma away from nominal, with one universe per column.
+    /// The 1 sigma definition shared by MultiverseMatrix::Shift and SimpleQuadSum::AbsoluteShift
+    Array MultiverseShift(const Matrix & universes, const Array & nominal, double nsigma);
+}
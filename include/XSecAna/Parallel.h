@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xsec {
+    namespace parallel {
+        namespace detail {
+            inline int & NThreadsSetting() {
+                static int nthreads = 0;
+                return nthreads;
+            }
+
+            inline bool & InParallelRegion() {
+                thread_local bool in_region = false;
+                return in_region;
+            }
+        }
+
+        ///\brief Set the default number of worker threads.
+        /// A value <= 0 means use std::thread::hardware_concurrency()
+        inline void SetNThreads(int nthreads) {
+            detail::NThreadsSetting() = nthreads;
+        }
+
+        inline unsigned int GetNThreads() {
+            if (detail::NThreadsSetting() > 0) return detail::NThreadsSetting();
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        ///\brief Thread-safe counter that, unlike std::atomic, can be copied
+        /// so that classes holding one keep their implicit copy constructors
+        class Counter {
+        public:
+            Counter(unsigned int value = 0) : fValue(value) {}
+
+            Counter(const Counter & other) : fValue(other.fValue.load()) {}
+
+            Counter & operator=(const Counter & other) {
+                fValue = other.fValue.load();
+                return *this;
+            }
+
+            Counter & operator=(unsigned int value) {
+                fValue = value;
+                return *this;
+            }
+
+            unsigned int operator++(int) { return fValue++; }
+
+            operator unsigned int() const { return fValue.load(); }
+
+        private:
+            std::atomic<unsigned int> fValue;
+        };
+
+        ///\brief Call fn(i) for every i in [0, n) on a pool of std::threads.
+        /// Indices are handed out dynamically so uneven work balances itself.
+        /// Nested calls run serially on the calling thread so that parallel
+        /// callers of parallel code don't oversubscribe the machine.
+        /// The first exception thrown by fn is rethrown on the calling thread.
+        template<class Function>
+        void For(std::size_t n, Function && fn, int nthreads = 0) {
+            std::size_t nworkers = nthreads > 0 ? nthreads : GetNThreads();
+            nworkers = std::min(nworkers, n);
+            if (nworkers <= 1 || detail::InParallelRegion()) {
+                for (auto i = 0u; i < n; i++) fn(i);
+                return;
+            }
+
+            std::atomic<std::size_t> next(0);
+            std::exception_ptr error = nullptr;
+            std::mutex error_mutex;
+            auto worker = [&]() {
+                detail::InParallelRegion() = true;
+                try {
+                    for (auto i = next++; i < n; i = next++) fn(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = n;
+                }
+                detail::InParallelRegion() = false;
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(nworkers - 1);
+            for (auto i = 1u; i < nworkers; i++) threads.emplace_back(worker);
+            worker();
+            for (auto & thread : threads) thread.join();
+
+            if (error) std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "TDirectory.h"
+#include "TH2.h"
+
+#include "XSecAna/IUnfold.h"
+
+#include <vector>
+
+namespace xsec {
+
+    ///\brief Tikhonov regularized unfolding through the SVD of the response.
+    // Minimizes |A x - d|^2 + tau^2 |L x|^2 where A is the migration matrix
+    // P(reco i | truth j) and L the discrete second derivative with eps subtracted from
+    // the diagonal to make it invertible (Hocker and Kartvelishvili,
+    // Nucl. Instrum. Meth. A 372 (1996) 469).
+    // Substituting x = L^-1 z gives standard form. With A L^-1 = U S V^T,
+    //   x = W diag(s / (s^2 + tau^2)) U^T d,  W = L^-1 V
+    // so once U, s and W are computed, unfolding at any tau is matrix-vector work.
+    // Columns of A are normalized to one since the efficiency correction is applied
+    // separately by the IEfficiency of a cross section.
+    class SVDUnfolder : public IEigenUnfoldEstimator {
+    public:
+        ///\brief Point of a regularization scan.
+        /// residual_norm = |A x - d|, solution_norm = |L x|
+        struct ScanPoint {
+            double tau;
+            double residual_norm;
+            double solution_norm;
+        };
+
+        ///\brief response has reco bins on the x axis and truth bins on the y axis.
+        /// Both axes need the same number of bins so unfolded histograms take the binning of the data
+        SVDUnfolder(const TH2 * response, double tau, double eps = 1e-3);
+
+        ///\brief response(reco bin, truth bin), including under/overflow bins
+        SVDUnfolder(const Matrix & response, double tau, double eps = 1e-3);
+
+        std::shared_ptr<TH1> Truth(const TH1 * reco) const override;
+
+        ///\brief Unfold every column of reco, e.g. all universes of a systematic
+        Matrix Unfold(const Matrix & reco) const { return Unfold(reco, fTau); }
+        Matrix Unfold(const Matrix & reco, double tau) const;
+
+        ///\brief Residual and solution norms for each tau, e.g. to find the corner of the L-curve.
+        /// Evaluated in the singular value basis without unfolding, in parallel over taus
+        std::vector<ScanPoint> ScanTau(const Vector & reco, const std::vector<double> & taus) const;
+
+        void SetTau(double tau);
+        double GetTau() const { return fTau; }
+
+        const Vector & GetSingularValues() const { return fSingularValues; }
+
+        void SaveTo(TDirectory * dir, const std::string & subdir) const override;
+
+        ///\brief Restores the factorization without recomputing the SVD
+        static std::unique_ptr<IMeasurement> LoadFrom(TDirectory * dir, const std::string & subdir);
+
+        virtual ~SVDUnfolder() = default;
+
+    protected:
+        void _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const override;
+        void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                              Array2DRef result, Array2DRef rerror) const override;
+
+    private:
+        SVDUnfolder(Matrix left_singular_vectors,
+                    Vector singular_values,
+                    Matrix solution_basis,
+                    double tau);
+
+        ///\brief s / (s^2 + tau^2)
+        Vector _filter_factors(double tau) const;
+
+        Matrix fLeftSingularVectors;
+        Vector fSingularValues;
+        // L^-1 V
+        Matrix fSolutionBasis;
+        double fTau;
+        // unfolding matrix at fTau, for propagating errors
+        Matrix fUnfoldingMatrix;
+    };
+}
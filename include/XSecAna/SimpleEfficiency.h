@@ -20,6 +20,8 @@ namespace xsec {
 
         const TH1 * GetDenominator() const;
 
+        bool IsDataIndependent() const override { return true; }
+
         virtual ~SimpleEfficiency() = default;
 
     private:
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "XSecAna/Systematic.h"
+#include "XSecAna/MultiverseMatrix.h"
 #include "XSecAna/Math.h"
 
 #include <Eigen/Dense>
@@ -15,6 +16,29 @@ namespace xsec {
     /// in order to transform into a TH1.
     /// The only exception is if type T is type TH1.
     namespace SimpleQuadSum {
+        /// \brief Symmeterized absolute uncertainty of one systematic bin by bin, on contents already in arrays.
+        /// shifts holds one shift (or universe) per column, in the same bins as nominal.
+        // AbsoluteUncertainty maps its histograms to arrays and calls this. Callers that evaluate
+        // many selections of the same samples can call it directly and skip making histograms
+        inline
+        Array
+        AbsoluteShift(const Array & nominal,
+                      const Matrix & shifts,
+                      SystType_t type) {
+            if (shifts.rows() != nominal.size()) {
+                throw std::runtime_error("AbsoluteShift: shifts do not match the nominal binning");
+            }
+            if (type == kMultiverse) {
+                return MaxShift((MultiverseShift(shifts, nominal, 1) - nominal).abs(),
+                                (MultiverseShift(shifts, nominal, -1) - nominal).abs());
+            } else if (type == kTwoSided) {
+                return MaxShift((shifts.col(0).array() - nominal).abs(),
+                                (shifts.col(1).array() - nominal).abs());
+            } else {
+                return (shifts.col(0).array() - nominal).abs();
+            }
+        }
+
         namespace detail {
             /// \brief Evaluate all the T's out to TH1s
             /// Calling Eval on the T's the long way since
@@ -41,27 +65,21 @@ namespace xsec {
             std::pair<const TH1 *, Systematic<TH1>>
             _AbsoluteUncertainty(const TH1 * nominal,
                                  const xsec::Systematic<TH1> & shifted_obj) {
-                std::vector<TH1 *> shifts(shifted_obj.GetShifts().size());
                 root::TH1Props props(nominal);
-                Array up_c(props.nbins_and_uof);
-                Array down_c(props.nbins_and_uof);
-
                 Array nom_c = root::MapContentsToEigen(nominal);
-                // convert multiverse systematic to two-sided by finding 1sigma
-                if (shifted_obj.GetType() == kMultiverse) {
-                    up_c = root::MapContentsToEigen(MultiverseShift(shifted_obj, nominal, 1)) - nom_c;
-                    down_c = root::MapContentsToEigen(MultiverseShift(shifted_obj, nominal, -1)) - nom_c;
-                } else if (shifted_obj.GetType() == kTwoSided) {
-                    up_c = root::MapContentsToEigen(shifted_obj.GetShifts()[0].get());
-                    down_c = root::MapContentsToEigen(shifted_obj.GetShifts()[1].get());
-                    up_c = up_c - nom_c;
-                    down_c = down_c - nom_c;
+                // contents of every shift, or universe, one per column
+                Matrix shift_c;
+                if (shifted_obj.GetType() == kMultiverse && shifted_obj.GetUniverseMatrix()) {
+                    shift_c = shifted_obj.GetUniverseMatrix()->GetMatrix();
                 } else {
-                    up_c = root::MapContentsToEigen(shifted_obj.GetShifts()[0].get());
-                    up_c = up_c - nom_c;
-                    down_c = up_c;
+                    const auto & shifts = shifted_obj.GetShifts();
+                    shift_c.resize(props.nbins_and_uof, shifts.size());
+                    for (auto i = 0u; i < shifts.size(); i++) {
+                        shift_c.col(i) = root::MapContentsToEigen(shifts[i].get()).matrix();
+                    }
                 }
-                auto max_c = MaxShift(up_c.abs(), down_c.abs());
+                // multiverse systematics are converted to two-sided by finding 1sigma
+                Array max_c = AbsoluteShift(nom_c, shift_c, shifted_obj.GetType());
                 auto diff = std::shared_ptr<TH1>(root::ToROOTLike(nominal, max_c, Array::Zero(props.nbins_and_uof)));
                 return {nominal,
                         Systematic<TH1>(shifted_obj.GetName(),
@@ -23,6 +23,8 @@ namespace xsec {
 
     private:
         void _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const override;
+        void _eval_batch_impl(const Array2D & data, const Array2D & error,
+                              Array2DRef result, Array2DRef rerror) const override;
         const TH1 * fBackground;
     };
 }
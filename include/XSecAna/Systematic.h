@@ -10,6 +10,7 @@
 #include <cstdio>
 #include <utility>
 #include <functional>
+#include <mutex>
 
 namespace xsec {
     enum SystType_t {
@@ -19,6 +20,8 @@ namespace xsec {
         kOneOrTwoSided,
     };
 
+    class MultiverseMatrix;
+
     template<class U, class T>
     using ForEachFunction = std::function<std::shared_ptr<U> (const std::shared_ptr<T>)>;
 
@@ -74,6 +77,12 @@ namespace xsec {
                    std::vector<std::shared_ptr<T>> & container,
                    SystType_t type);
 
+        ///\brief Multiverse backed by a single bins x universes matrix.
+        /// Only valid for Systematic<TH1>. The TH1s returned by GetShifts
+        /// are made the first time they're asked for
+        Systematic(std::string name,
+                   std::shared_ptr<const MultiverseMatrix> universes);
+
 
         /*
         Systematic(const Systematic & syst);
@@ -100,6 +109,11 @@ namespace xsec {
 
         const std::vector<std::shared_ptr<T>> & GetShifts() const;
 
+        std::size_t GetNShifts() const;
+
+        ///\brief Matrix backing this multiverse, or nullptr if it is a collection of histograms
+        std::shared_ptr<const MultiverseMatrix> GetUniverseMatrix() const { return fUniverseMatrix; }
+
         const std::shared_ptr<T> Up() const;
 
         const std::shared_ptr<T> Down() const;
@@ -109,11 +123,26 @@ namespace xsec {
         std::string GetName() const;
 
     private:
+        // shifts materialized from fUniverseMatrix. Shared between copies
+        struct ShiftCache {
+            std::once_flag flag;
+            std::vector<std::shared_ptr<T>> shifts;
+        };
+
         std::vector<std::shared_ptr<T>> fContainer;
         SystType_t fType;
         std::string fName;
+        std::shared_ptr<const MultiverseMatrix> fUniverseMatrix;
+        std::shared_ptr<ShiftCache> fShiftCache;
     };
 
+    ///\brief Value found in universes nsigma away from nominal,
+    /// counting from the universe nearest nominal. Sorts universes
+    template<class Scalar>
+    Scalar BinSigma(const double & nsigma,
+                    std::vector<Scalar> & universes,
+                    const Scalar & nominal);
+
     TH1 * MultiverseShift(Systematic<TH1> multiverse,
                           const TH1 * nominal,
                           double nsigma = 1);
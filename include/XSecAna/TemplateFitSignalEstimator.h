@@ -3,8 +3,14 @@
 #include "XSecAna/Fit/TemplateFitCalculator.h"
 #include "XSecAna/ISignalEstimator.h"
 #include "XSecAna/Fit/IFitter.h"
+#include "XSecAna/Fit/FitSession.h"
+#include "XSecAna/ArrayFile.h"
 
 #include "TCanvas.h"
+#include "TGraph.h"
+#include "TH2D.h"
+
+#include <mutex>
 
 namespace xsec {
     struct TemplateFitResult {
@@ -14,6 +20,7 @@ namespace xsec {
         std::map<std::string, TH1*> component_params_error_down;
         TH2D * covariance;
         unsigned int fun_calls;
+        bool is_valid = true;
 
         TemplateFitResult Clone() const;
 
@@ -21,11 +28,22 @@ namespace xsec {
         static std::unique_ptr<TemplateFitResult> LoadFrom(TDirectory * dir, const std::string & subdir);
     };
 
+    class TemplateFitSession;
+
     class TemplateFitSignalEstimator {//}; : public IEigenSignalEstimator {
     public:
         TemplateFitSignalEstimator(const fit::TemplateFitSample & sample,
                                    const TH1 * mask = 0);
 
+        ///\brief Assemble from components reduced elsewhere and the covariance matrix
+        /// of each shape only systematic in the reduced template binning,
+        /// e.g. blocks of the covariances of a joint fit.
+        /// The shape only systematics of sample aren't reduced
+        TemplateFitSignalEstimator(const fit::TemplateFitSample & sample,
+                                   const TH1 * mask,
+                                   const fit::ReducedComponentCollection & reduced_components,
+                                   const std::map<std::string, Matrix> & covariances);
+
         void SetFitter(fit::IFitter * fitter);
         fit::IFitter * GetFitter() const;
         fit::IFitCalculator * GetFitCalc() const;
@@ -36,8 +54,67 @@ namespace xsec {
         TemplateFitResult Fit(const std::shared_ptr<TH1> data, const std::map<std::string, TH1*> & seed) const;
         TemplateFitResult Fit(const std::shared_ptr<TH1> data, fit::IFitter * fitter, const std::map<std::string, TH1*> & seed);
 
+        ///\brief Start the fit from the minimum and covariance of a previous fit to similar data
+        TemplateFitResult Fit(const std::shared_ptr<TH1> data, const TemplateFitResult & previous) const;
+
+        ///\brief chi2 profiled over the other parameters with the normalization of component_label
+        /// in analysis bin outer_bin fixed to each of values.
+        /// Points are fit in parallel on nthreads threads (0 for parallel::GetNThreads())
+        TGraph * ProfileScan(const std::shared_ptr<TH1> data,
+                             const std::string & component_label,
+                             int outer_bin,
+                             const std::vector<double> & values,
+                             int nthreads = 0) const;
+
+        ///\brief Adaptive version of the above. Starts from npoints evenly spaced in [lo, hi],
+        /// then for nrefine rounds bisects the intervals with an end point within
+        /// max_delta_chi2 of the lowest chi2 found so far
+        TGraph * ProfileScan(const std::shared_ptr<TH1> data,
+                             const std::string & component_label,
+                             int outer_bin,
+                             double lo,
+                             double hi,
+                             int npoints,
+                             int nrefine,
+                             double max_delta_chi2 = 4,
+                             int nthreads = 0) const;
+
+        ///\brief chi2 profiled over the other parameters at the bin centers of the returned histogram
+        TH2D * ProfileScan2D(const std::shared_ptr<TH1> data,
+                             const std::string & component_label_x,
+                             int outer_bin_x,
+                             int nx, double xlo, double xhi,
+                             const std::string & component_label_y,
+                             int outer_bin_y,
+                             int ny, double ylo, double yhi,
+                             int nthreads = 0) const;
+
+        ///\brief Independent fit configuration that starts with this estimator's fixed components.
+        /// Sessions share the reduced templates and covariance with the estimator,
+        /// so fits in different sessions can run concurrently.
+        /// Uses a clone of fitter, or of the active fitter if none is given
+        TemplateFitSession NewSession(const fit::IFitter * fitter = nullptr) const;
+
+        ///\brief Number of candidate seeds thrown before taking the best nrandom_seeds.
+        /// rng_seed makes the throws reproducible between fits
+        void SetSeedThrows(int nthrows, unsigned int rng_seed = 0) { fNSeedThrows = nthrows; fSeedRNGSeed = rng_seed; }
+
         void SaveTo(TDirectory * dir, const std::string & name) const;
 
+        ///\brief Write the reduced templates, covariance matrices, design matrix,
+        /// Cholesky factor of the fit covariance and fixed components to a single memory-mappable file
+        void SaveSnapshot(const std::string & path) const;
+
+        ///\brief Restore an estimator from SaveSnapshot without reducing templates,
+        /// computing covariances or factorizing the fit covariance.
+        /// sample and mask must be the ones the snapshot was made from. Only the user level
+        /// components of sample are used; shape only systematics aren't reduced again.
+        /// The fit covariance and its Cholesky factor are used in place, so processes loading
+        /// the same snapshot share them. Covariance histograms are built when first asked for
+        static std::unique_ptr<TemplateFitSignalEstimator> LoadSnapshot(const fit::TemplateFitSample & sample,
+                                                                         const TH1 * mask,
+                                                                         const std::string & path);
+
         void FixComponent(const std::string & template_name, const double & val=1);
         void ReleaseComponent(const std::string & template_name);
 
@@ -88,13 +165,40 @@ namespace xsec {
                           std::map<std::string, TH1 *> & params) const;
         TH1 * ToUserParamsComponent(const fit::Vector & calc_params) const;
 
+        ///\brief Conversions between fit results and their flat form,
+        /// e.g. for storing many toy fits in a fit::FitResultWriter
+        fit::FitResult ToFitResult(const TemplateFitResult & fit_result) const;
+        TemplateFitResult FromFitResult(const fit::FitResult & fit_result) const;
+
         TH1 * GetRandomSampleFakeData(const std::map<std::string, TH1*> & params, int seed = 0) const;
         TH1 * _to_template_binning(const Array & reduced_templates) const;
     protected:
+        TemplateFitSignalEstimator(const fit::TemplateFitSample & sample,
+                                   const TH1 * mask,
+                                   std::shared_ptr<const ArrayFile> snapshot);
+
+        void _setup_binning(const TH1 * mask);
+        TH2D * _covariance_hist(const std::string & title) const;
+        TH1 * _snapshot_covariance(const std::string & entry, const std::string & title) const;
+        static Matrix _covariance_matrix(const TH1 * covariance);
+
         bool _is_component_fixed(std::string label) const;
         void _draw_covariance_helper(TCanvas * c, TH1 * mat, const TemplateFitResult & fit_result) const;
         TemplateFitResult _template_fit_result(const fit::FitResult & fit_result) const;
-        TemplateFitResult _fit(const std::shared_ptr<TH1> data, const std::vector<Vector> & seeds) const;
+        TemplateFitResult _template_fit_result(const fit::FitResult & fit_result,
+                                               const std::map<std::string, const fit::IUserTemplateComponent*> & fixed_components) const;
+        std::vector<Vector> _random_seeds(const fit::IFitCalculator * fit_calc,
+                                          const Vector & data,
+                                          int nrandom_seeds) const;
+        TemplateFitResult _fit(const std::shared_ptr<TH1> data,
+                               const std::vector<Vector> & seeds) const;
+        int _calculator_param_idx(const std::string & component_label, int outer_bin) const;
+        fit::FitResult _profile_start(const Vector & data) const;
+        std::vector<double> _profile_scan(const Vector & data,
+                                          const fit::FitResult & start,
+                                          int param,
+                                          const std::vector<double> & values,
+                                          int nthreads) const;
 
         TH1 * _project_prediction(const Array & prediction) const;
 
@@ -109,9 +213,12 @@ namespace xsec {
         std::map<std::string, const fit::IUserTemplateComponent*> fFixedUserComponents;
         fit::TemplateFitCalculator * fFitCalc;
 
-        std::map<std::string, TH1*> fCovarianceMatrices;
-        TH1 * fTotalCovariance;
+        // estimators loaded from a snapshot fill these from fSnapshot when they're first asked for
+        mutable std::map<std::string, TH1*> fCovarianceMatrices;
+        mutable TH1 * fTotalCovariance;
         TH1 * fInvTotalCovariance;
+        std::shared_ptr<const ArrayFile> fSnapshot;
+        mutable std::mutex fSnapshotMutex;
 
         fit::ComponentReducer fReducer;
 
@@ -121,5 +228,39 @@ namespace xsec {
         fit::detail::ParamMap fInnerBinMap;
 
         fit::IFitter * fFitter = 0;
+
+        int fNSeedThrows = 100;
+        unsigned int fSeedRNGSeed = 0;
+
+        friend class TemplateFitSession;
+    };
+
+    ///\brief Fixed components and fitter of one fit configuration on a TemplateFitSignalEstimator.
+    /// See fit::FitSession. Create with TemplateFitSignalEstimator::NewSession
+    class TemplateFitSession {
+    public:
+        TemplateFitSession(const TemplateFitSignalEstimator * estimator,
+                           const fit::IFitter * fitter = nullptr);
+
+        void FixComponent(const std::string & component_label, const double & val = 1);
+        void ReleaseComponent(const std::string & component_label);
+
+        void SetFitter(const fit::IFitter * fitter) { fSession.SetFitter(fitter); }
+
+        TemplateFitResult Fit(const std::shared_ptr<TH1> data, int nrandom_seeds = -1);
+
+        ///\brief Start the fit from the minimum and covariance of a previous fit to similar data,
+        /// instead of this session's warm start
+        TemplateFitResult Fit(const std::shared_ptr<TH1> data, const TemplateFitResult & previous);
+
+        ///\brief Warm start each fit in this session from the previous minimum. See fit::FitSession::SetWarmStart
+        void SetWarmStart(bool opt) { fSession.SetWarmStart(opt); }
+
+        fit::FitSession & GetFitSession() { return fSession; }
+
+    private:
+        const TemplateFitSignalEstimator * fEstimator;
+        fit::FitSession fSession;
+        std::map<std::string, const fit::IUserTemplateComponent*> fFixedUserComponents;
     };
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include "TH2.h"
 #include "TH3.h"
 #include "TAxis.h"
+#include "TROOT.h"
+#include <atomic>
+#include <mutex>
 #include <unsupported/Eigen/CXX11/Tensor>
 #include "XSecAna/Type.h"
 
@@ -19,10 +22,19 @@ namespace xsec {
     typedef Eigen::Map<const Array> ArrayMap;
     namespace root {
         inline std::string MakeUnique(const std::string & base) {
-            static int N = 0;
+            static std::atomic<int> N(0);
             return base + std::to_string(N++);
         }
 
+        ///\brief Enable ROOT's thread safety before parallel::For workers create histograms.
+        // Only the first call does anything. Workers take the histograms they create
+        // out of gDirectory with SetDirectory(nullptr) rather than changing TH1::AddDirectory,
+        // which is global and would affect histograms made on other threads
+        inline void EnableThreadSafety() {
+            static std::once_flag enabled;
+            std::call_once(enabled, [] { ROOT::EnableThreadSafety(); });
+        }
+
         inline std::unique_ptr<TH1> LoadTH1(TDirectory * dir, const std::string & name) {
             auto ret = std::unique_ptr<TH1>((TH1 *) dir->Get(name.c_str()));
             ret->SetDirectory(0); // Tell dir it doesn't own this object anymore
@@ -338,9 +350,9 @@ namespace xsec {
                 for (auto i = 1; i <= props.axes[0]->GetNbins(); i++) {
                     for (auto j = 1; j <= props.axes[1]->GetNbins(); j++) {
                         for (auto k = 1; k <= props.axes[2]->GetNbins(); k++) {
-                            _bw(i - 1, j - 1, k - 1) = props.axes[0]->GetBinWidth(i) *
-                                                       props.axes[1]->GetBinWidth(j) *
-                                                       props.axes[2]->GetBinWidth(k);
+                            _bw(i, j, k) = props.axes[0]->GetBinWidth(i) *
+                                           props.axes[1]->GetBinWidth(j) *
+                                           props.axes[2]->GetBinWidth(k);
                         }
                     }
                 }
@@ -351,5 +363,18 @@ namespace xsec {
         inline Array MapBinWidthsToEigen(const TH1 * h) {
             return MapBinWidthsToEigen(TH1Props(h, ""));
         }
+
+        ///\brief Number of bins followed by the bin edges of each axis.
+        /// Identifies the binning, e.g. to tell whether something computed from it is still valid
+        inline Array MapBinEdgesToEigen(const TH1Props & props) {
+            std::vector<double> edges;
+            for (auto i = 0; i < props.dims; i++) {
+                edges.push_back(props.axes[i]->GetNbins());
+                for (auto j = 1; j <= props.axes[i]->GetNbins() + 1; j++) {
+                    edges.push_back(props.axes[i]->GetBinLowEdge(j));
+                }
+            }
+            return ArrayMap(edges.data(), edges.size());
+        }
     }
 }
@@ -0,0 +1,120 @@
+import gc
+import threading
+from array import array
+
+import numpy as np
+import pytest
+
+import xsecana
+
+
+def make_hist(contents):
+    return xsecana.TH1(np.arange(len(contents) + 1, dtype=float), contents=np.asarray(contents, dtype=float))
+
+
+def test_contents_are_views():
+    h = make_hist([1, 2, 3])
+    contents = h.contents
+    assert contents.shape == (5,)
+    contents[2] = 10
+    assert h.contents[2] == 10
+    assert np.shares_memory(contents, h.contents)
+    assert np.shares_memory(h.sumw2, h.sumw2)
+
+
+def test_views_keep_owner_alive():
+    contents = make_hist([1, 2, 3]).contents
+    universes = xsecana.Systematic("s", make_hist([1, 2, 3]), np.ones((5, 4))).universe_matrix
+    gc.collect()
+    assert list(contents) == [0, 1, 2, 3, 0]
+    assert not universes.flags.writeable
+    assert universes.sum() == 20
+
+
+def test_histograms_leave_gdirectory():
+    ROOT = pytest.importorskip("ROOT")
+    # importing xsecana doesn't change where other histograms go
+    assert ROOT.TH1.AddDirectoryStatus()
+    f = ROOT.TMemFile("test_histograms_leave_gdirectory.root", "RECREATE")
+    f.cd()
+    h = make_hist([1, 2, 3])
+    result = xsecana.SimpleSignalEstimator(make_hist([0, 1, 1])).eval(h)
+    f.Close()
+    assert list(h.contents) == [0, 1, 2, 3, 0]
+    assert list(result.contents) == [0, 1, 1, 2, 0]
+
+
+# mirrors make_template_fit_sample of test/test_utils.h
+NBINS = (3, 2, 4)
+SHAPES = {
+    "a": lambda x, y, z: 10 + 5 * z + x + y,
+    "b": lambda x, y, z: 30 - 5 * z + 2 * x,
+    "c": lambda x, y, z: 8 + y + (z - 2) * (z - 2),
+}
+
+
+def make_template(ROOT, content):
+    edges = [array("d", range(n + 1)) for n in NBINS]
+    h = ROOT.TH3D(ROOT.TUUID().AsString(), "",
+                  NBINS[0], edges[0], NBINS[1], edges[1], NBINS[2], edges[2])
+    for x in range(NBINS[0] + 2):
+        for y in range(NBINS[1] + 2):
+            for z in range(NBINS[2] + 2):
+                h.SetBinContent(x, y, z, content(x, y, z))
+                h.SetBinError(x, y, z, np.sqrt(content(x, y, z)))
+    return xsecana.TH1.from_root(ROOT.addressof(h))
+
+
+def make_estimator(ROOT):
+    total = lambda x, y, z: sum(shape(x, y, z) for shape in SHAPES.values())
+    universes = [make_template(ROOT, lambda x, y, z, u=u: total(x, y, z) * (1 + 0.01 * (u - 10) * (z - 2)))
+                 for u in range(20)]
+    mask = ROOT.TH2D(ROOT.TUUID().AsString(), "", NBINS[0], 0, NBINS[0], NBINS[1], 0, NBINS[1])
+    for x in range(1, NBINS[0] + 1):
+        for y in range(1, NBINS[1] + 1):
+            mask.SetBinContent(x, y, 1)
+    # only the estimator is kept, so it has to hold on to its components and mask
+    estimator = xsecana.TemplateFitSignalEstimator(
+        {label: xsecana.UserTemplateComponent(make_template(ROOT, shape)) for label, shape in SHAPES.items()},
+        {"tilt": xsecana.Systematic("tilt", universes)},
+        xsecana.TH1.from_root(ROOT.addressof(mask)))
+    estimator.set_fitter(xsecana.LinearTemplateFitter())
+    return estimator
+
+
+def inner_params(params):
+    # projected parameters are indexed by global bin of the analysis bins
+    return params.reshape(NBINS[1] + 2, NBINS[0] + 2)[1:-1, 1:-1]
+
+
+def test_fit():
+    ROOT = pytest.importorskip("ROOT")
+    estimator = make_estimator(ROOT)
+    gc.collect()
+
+    scaled = {"a": 1.2, "b": 1, "c": 1}
+    data = make_template(ROOT, lambda x, y, z: sum(scaled[label] * shape(x, y, z)
+                                                   for label, shape in SHAPES.items()))
+    result = estimator.fit(data)
+    params = result.component_params
+    del result
+    gc.collect()
+    for label, scale in scaled.items():
+        assert np.allclose(inner_params(params[label]), scale)
+
+    warm = estimator.fit(data, estimator.fit(data))
+    assert np.allclose(inner_params(warm.component_params["a"]), 1.2)
+
+    # fits from several threads each run on their own copy of the fitter
+    results = [None] * 4
+
+    def fit(i):
+        results[i] = estimator.fit(data).component_params["a"]
+
+    threads = [threading.Thread(target=fit, args=(i,)) for i in range(len(results))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for params in results:
+        assert np.array_equal(params, results[0])
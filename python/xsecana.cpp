@@ -0,0 +1,478 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "TGraph.h"
+#include "TH1D.h"
+#include "TH2D.h"
+
+#include "XSecAna/CrossSection.h"
+#include "XSecAna/IterativeUnfolder.h"
+#include "XSecAna/IUnfold.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/SimpleEfficiency.h"
+#include "XSecAna/SimpleFlux.h"
+#include "XSecAna/SimpleSignalEstimator.h"
+#include "XSecAna/SVDUnfolder.h"
+#include "XSecAna/Systematic.h"
+#include "XSecAna/TemplateFitSignalEstimator.h"
+#include "XSecAna/Fit/LBFGSBFitter.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/Minuit2TemplateFitter.h"
+
+#include <optional>
+
+namespace py = pybind11;
+using namespace xsec;
+
+// Arrays handed to python are views of the memory owned by the C++ objects
+// whenever that memory is laid out as a plain array: histogram contents and sum of
+// squared weights, universe matrices and fit result parameters and covariances.
+// The owning object is kept alive for as long as any of its views.
+// Views of histograms and results are writable, views of universe matrices are not.
+// Fits and evaluations release the GIL.
+// Histograms handed to python are taken out of gDirectory, so closing a ROOT file
+// opened from python doesn't delete them.
+namespace {
+    py::array_t<double> View(const double * data,
+                             std::vector<py::ssize_t> shape,
+                             std::vector<py::ssize_t> strides,
+                             py::handle owner,
+                             bool writeable = true) {
+        py::array_t<double> view(shape, strides, data, owner);
+        if (!writeable) view.attr("setflags")(py::arg("write") = false);
+        return view;
+    }
+
+    ///\brief Holds a reference to owner for the lifetime of a view
+    template<class T>
+    py::capsule KeepAlive(std::shared_ptr<T> owner) {
+        return py::capsule(new std::shared_ptr<const void>(owner),
+                           [](void * p) { delete static_cast<std::shared_ptr<const void> *>(p); });
+    }
+
+    ///\brief Column major Eigen matrix as a 2D numpy array
+    py::array_t<double> MatrixView(const Matrix & m, py::handle owner, bool writeable) {
+        return View(m.data(),
+                    {m.rows(), m.cols()},
+                    {(py::ssize_t) sizeof(double), (py::ssize_t) (sizeof(double) * m.rows())},
+                    owner,
+                    writeable);
+    }
+
+    ///\brief Bin contents including under/overflow in ROOT's global bin order
+    py::array_t<double> ContentsView(const TH1 * h, py::handle owner) {
+        auto contents = root::MapContentsToEigen(h);
+        return View(contents.data(), {contents.size()}, {(py::ssize_t) sizeof(double)}, owner);
+    }
+
+    ///\brief Inner bins of a 2D histogram, indexed [x, y]
+    py::array_t<double> InnerView2D(const TH2D * h, py::handle owner) {
+        const py::ssize_t nx = h->GetNbinsX();
+        const py::ssize_t ny = h->GetNbinsY();
+        // skip the underflow row and column
+        return View(h->GetArray() + (nx + 2) + 1,
+                    {nx, ny},
+                    {(py::ssize_t) sizeof(double), (py::ssize_t) (sizeof(double) * (nx + 2))},
+                    owner);
+    }
+
+    void CheckDoublePrecision(const TH1 * h) {
+        if (!h->InheritsFrom("TArrayD")) {
+            throw std::runtime_error(std::string(h->ClassName()) +
+                                     " is not supported. Histograms must be TH1D, TH2D or TH3D");
+        }
+    }
+
+    std::shared_ptr<TH1> MakeTH1(const Array & edges,
+                                 const std::optional<Array> & contents,
+                                 const std::optional<Array> & errors) {
+        if (edges.size() < 2) throw std::runtime_error("Need at least two bin edges");
+        const int nbins = edges.size() - 1;
+        auto h = std::make_shared<TH1D>(root::MakeUnique("xsecana").c_str(), "", nbins, edges.data());
+        h->SetDirectory(nullptr);
+        h->Sumw2();
+
+        auto fill = [&](const Array & arr, const std::string & what) {
+            Array ret = Array::Zero(nbins + 2);
+            if (arr.size() == nbins + 2) ret = arr;
+            else if (arr.size() == nbins) ret.segment(1, nbins) = arr;
+            else {
+                throw std::runtime_error("Expected " + std::to_string(nbins) + " or " +
+                                         std::to_string(nbins + 2) + " " + what + ", got " +
+                                         std::to_string(arr.size()));
+            }
+            return ret;
+        };
+        if (contents) h->SetContent(fill(*contents, "contents").data());
+        if (errors) h->SetError(fill(*errors, "errors").data());
+        return h;
+    }
+
+    std::shared_ptr<TH1> OwnTH1(TH1 * h) {
+        h->SetDirectory(nullptr);
+        return std::shared_ptr<TH1>(h);
+    }
+
+    std::shared_ptr<TH1> Detach(std::shared_ptr<TH1> h) {
+        h->SetDirectory(nullptr);
+        return h;
+    }
+
+    TemplateFitResult Detach(TemplateFitResult result) {
+        for (auto params : {&result.component_params,
+                            &result.component_params_error_up,
+                            &result.component_params_error_down}) {
+            for (auto & [label, h]: *params) h->SetDirectory(nullptr);
+        }
+        if (result.covariance) result.covariance->SetDirectory(nullptr);
+        return result;
+    }
+
+    template<class Map>
+    py::dict ParamsViews(const Map & params, py::handle owner) {
+        py::dict ret;
+        for (const auto & [label, h]: params) {
+            ret[py::str(label)] = ContentsView(h, owner);
+        }
+        return ret;
+    }
+
+    template<class Estimator>
+    void DefCrossSection(py::module_ & m, const char * name, const char * doc) {
+        py::class_<Estimator, IMeasurement, std::shared_ptr<Estimator>>(m, name, doc, py::multiple_inheritance())
+                .def(py::init<IMeasurement *, IMeasurement *, IMeasurement *, IMeasurement *, double>(),
+                     py::arg("efficiency"),
+                     py::arg("signal_estimator"),
+                     py::arg("flux"),
+                     py::arg("unfold"),
+                     py::arg("ntargets"),
+                     py::keep_alive<1, 2>(),
+                     py::keep_alive<1, 3>(),
+                     py::keep_alive<1, 4>(),
+                     py::keep_alive<1, 5>());
+    }
+}
+
+PYBIND11_MODULE(xsecana, m) {
+    m.doc() = "Python interface to XSecAna";
+
+    /////////////////////////////////////////////////////////////////////////
+    py::class_<TH1, std::shared_ptr<TH1>>(m, "TH1",
+                                          "ROOT histogram. Arrays include under/overflow bins in ROOT's global bin order")
+            .def(py::init(&MakeTH1),
+                 py::arg("edges"),
+                 py::arg("contents") = py::none(),
+                 py::arg("errors") = py::none(),
+                 "1D histogram. contents and errors may include under/overflow bins or not")
+            .def_static("from_root",
+                        [](std::uintptr_t address) {
+                            auto h = reinterpret_cast<const TH1 *>(address);
+                            CheckDoublePrecision(h);
+                            return OwnTH1((TH1 *) h->Clone(root::MakeUnique("xsecana").c_str()));
+                        },
+                        py::arg("address"),
+                        "Copy of a PyROOT histogram, given ROOT.addressof(h)")
+            .def_property_readonly("address",
+                                   [](const TH1 & self) { return reinterpret_cast<std::uintptr_t>(&self); },
+                                   "For ROOT.bind_object(address, 'TH1D'). Only valid while this object is alive")
+            .def_property_readonly("contents",
+                                   [](py::object self) { return ContentsView(self.cast<const TH1 *>(), self); },
+                                   "View of the bin contents")
+            .def_property_readonly("sumw2",
+                                   [](py::object self) -> py::object {
+                                       auto h = self.cast<const TH1 *>();
+                                       if (h->GetSumw2N() == 0) return py::none();
+                                       return View(h->GetSumw2()->GetArray(),
+                                                   {h->GetSumw2N()},
+                                                   {(py::ssize_t) sizeof(double)},
+                                                   self);
+                                   },
+                                   "View of the sum of squared weights, or None if not stored")
+            .def_property_readonly("errors",
+                                   [](const TH1 & self) { return root::MapErrorsToEigen(&self); },
+                                   "Copy of the bin errors, which ROOT computes from sumw2")
+            .def_property_readonly("dimension", &TH1::GetDimension)
+            .def("edges",
+                 [](const TH1 & self, int axis) {
+                     root::TH1Props props(&self);
+                     if (axis < 0 || axis >= props.dims) throw py::index_error("No axis " + std::to_string(axis));
+                     Array edges(props.axes[axis]->GetNbins() + 1);
+                     for (auto i = 0; i < edges.size(); i++) edges(i) = props.axes[axis]->GetBinLowEdge(i + 1);
+                     return edges;
+                 },
+                 py::arg("axis") = 0);
+
+    /////////////////////////////////////////////////////////////////////////
+    py::enum_<SystType_t>(m, "SystType")
+            .value("OneSided", kOneSided)
+            .value("TwoSided", kTwoSided)
+            .value("Multiverse", kMultiverse)
+            .value("OneOrTwoSided", kOneOrTwoSided);
+
+    py::class_<Systematic<TH1>>(m, "Systematic")
+            .def(py::init<std::string, std::shared_ptr<TH1>>(),
+                 py::arg("name"), py::arg("shift"))
+            .def(py::init<std::string, std::shared_ptr<TH1>, std::shared_ptr<TH1>>(),
+                 py::arg("name"), py::arg("up"), py::arg("down"))
+            .def(py::init([](std::string name, std::vector<std::shared_ptr<TH1>> universes) {
+                     return Systematic<TH1>(name, universes);
+                 }),
+                 py::arg("name"), py::arg("universes"))
+            .def(py::init([](std::string name, const TH1 * binning, Matrix universes, std::optional<Matrix> errors) {
+                     CheckDoublePrecision(binning);
+                     return Systematic<TH1>(name,
+                                            std::make_shared<const MultiverseMatrix>(binning,
+                                                                                     std::move(universes),
+                                                                                     errors ? std::move(*errors) : Matrix()));
+                 }),
+                 py::arg("name"), py::arg("binning"), py::arg("universes"), py::arg("errors") = py::none(),
+                 "Multiverse backed by a bins x universes matrix")
+            .def_property_readonly("name", &Systematic<TH1>::GetName)
+            .def_property_readonly("type", &Systematic<TH1>::GetType)
+            .def_property_readonly("shifts", &Systematic<TH1>::GetShifts)
+            .def("__len__", &Systematic<TH1>::GetNShifts)
+            .def("up", &Systematic<TH1>::Up)
+            .def("down", &Systematic<TH1>::Down)
+            .def_property_readonly("universe_matrix",
+                                   [](const Systematic<TH1> & self) -> py::object {
+                                       auto universes = self.GetUniverseMatrix();
+                                       if (!universes) return py::none();
+                                       return MatrixView(universes->GetMatrix(), KeepAlive(universes), false);
+                                   },
+                                   "Read only view of the bins x universes matrix, or None if not backed by one")
+            .def("covariance_matrix",
+                 [](const Systematic<TH1> & self, const TH1 * nominal) {
+                     return OwnTH1(self.CovarianceMatrix(nominal));
+                 },
+                 py::arg("nominal"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("random_sample",
+                 [](const Systematic<TH1> & self, const TH1 * nominal, double seed) {
+                     return OwnTH1(self.RandomSample(nominal, seed));
+                 },
+                 py::arg("nominal"), py::arg("seed") = 0);
+
+    /////////////////////////////////////////////////////////////////////////
+    py::class_<IMeasurement, std::shared_ptr<IMeasurement>>(m, "IMeasurement")
+            .def("eval",
+                 [](const IMeasurement & self, const TH1 * data) { return Detach(self.Eval(data)); },
+                 py::arg("data"),
+                 py::call_guard<py::gil_scoped_release>());
+
+    py::class_<IEigenEval, IMeasurement, std::shared_ptr<IEigenEval>>(m, "IEigenEval", py::multiple_inheritance())
+            .def("eval_batch", &IEigenEval::EvalBatch,
+                 py::arg("like"), py::arg("data"), py::arg("error"),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Evaluate every column of data, e.g. each universe of a multiverse. Returns (result, error)")
+            .def("is_data_independent", &IEigenEval::IsDataIndependent)
+            .def("invalidate_cache", &IEigenEval::InvalidateCache);
+
+    py::class_<Systematic<IMeasurement>>(m, "MeasurementSystematic")
+            .def(py::init<std::string, std::shared_ptr<IMeasurement>>(),
+                 py::arg("name"), py::arg("shift"))
+            .def(py::init<std::string, std::shared_ptr<IMeasurement>, std::shared_ptr<IMeasurement>>(),
+                 py::arg("name"), py::arg("up"), py::arg("down"))
+            .def(py::init([](std::string name, std::vector<std::shared_ptr<IMeasurement>> universes) {
+                     return Systematic<IMeasurement>(name, universes);
+                 }),
+                 py::arg("name"), py::arg("universes"))
+            .def_property_readonly("name", &Systematic<IMeasurement>::GetName)
+            .def_property_readonly("type", &Systematic<IMeasurement>::GetType)
+            .def("__len__", &Systematic<IMeasurement>::GetNShifts)
+            .def("eval",
+                 [](const Systematic<IMeasurement> & self, const TH1 * data, const std::string & new_name) {
+                     auto ret = self.Eval(data, new_name);
+                     for (const auto & shift : ret.GetShifts()) shift->SetDirectory(nullptr);
+                     return ret;
+                 },
+                 py::arg("data"), py::arg("new_name") = "",
+                 py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SimpleEfficiency, IEigenEval, std::shared_ptr<SimpleEfficiency>>(m, "SimpleEfficiency",
+                                                                                 py::multiple_inheritance())
+            .def(py::init<const TH1 *, const TH1 *>(),
+                 py::arg("numerator"), py::arg("denominator"),
+                 py::keep_alive<1, 2>(), py::keep_alive<1, 3>());
+
+    py::class_<SimpleFlux, IEigenEval, std::shared_ptr<SimpleFlux>>(m, "SimpleFlux", py::multiple_inheritance())
+            .def(py::init<const TH1 *>(), py::arg("flux"), py::keep_alive<1, 2>())
+            .def("integrated_flux",
+                 [](const SimpleFlux & self) {
+                     // hand pybind11 the most derived pointer, IMeasurement is a virtual base
+                     return std::shared_ptr<SimpleIntegratedFlux>(
+                             dynamic_cast<SimpleIntegratedFlux *>(self.IntegratedFlux()));
+                 },
+                 py::keep_alive<0, 1>());
+
+    py::class_<SimpleIntegratedFlux, IEigenEval, std::shared_ptr<SimpleIntegratedFlux>>(m, "SimpleIntegratedFlux",
+                                                                                         py::multiple_inheritance())
+            .def(py::init<const TH1 *>(), py::arg("flux"), py::keep_alive<1, 2>());
+
+    py::class_<SimpleSignalEstimator, IEigenEval, std::shared_ptr<SimpleSignalEstimator>>(m, "SimpleSignalEstimator",
+                                                                                           py::multiple_inheritance())
+            .def(py::init<const TH1 *>(), py::arg("background"), py::keep_alive<1, 2>());
+
+    py::class_<IdentityUnfolder, IEigenEval, std::shared_ptr<IdentityUnfolder>>(m, "IdentityUnfolder",
+                                                                                 py::multiple_inheritance())
+            .def(py::init<int>(), py::arg("nbins_and_uof"));
+
+    py::class_<IterativeUnfolder, IEigenEval, std::shared_ptr<IterativeUnfolder>>(m, "IterativeUnfolder",
+                                                                                   py::multiple_inheritance())
+            .def(py::init([](const TH1 * response, int niterations) {
+                     auto response2d = dynamic_cast<const TH2 *>(response);
+                     if (!response2d) throw std::runtime_error("IterativeUnfolder: response must be a TH2");
+                     return std::make_shared<IterativeUnfolder>(response2d, niterations);
+                 }),
+                 py::arg("response"), py::arg("niterations"))
+            .def(py::init<const Eigen::SparseMatrix<double> &, int>(),
+                 py::arg("response"), py::arg("niterations"),
+                 "response(reco bin, truth bin) including under/overflow, e.g. a scipy.sparse matrix")
+            .def("unfold", &IterativeUnfolder::Unfold,
+                 py::arg("reco"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def_property_readonly("niterations", &IterativeUnfolder::GetNIterations);
+
+    py::class_<SVDUnfolder, IEigenEval, std::shared_ptr<SVDUnfolder>> svd(m, "SVDUnfolder", py::multiple_inheritance());
+    py::class_<SVDUnfolder::ScanPoint>(svd, "ScanPoint")
+            .def_readonly("tau", &SVDUnfolder::ScanPoint::tau)
+            .def_readonly("residual_norm", &SVDUnfolder::ScanPoint::residual_norm)
+            .def_readonly("solution_norm", &SVDUnfolder::ScanPoint::solution_norm);
+    svd
+            .def(py::init([](const TH1 * response, double tau, double eps) {
+                     auto response2d = dynamic_cast<const TH2 *>(response);
+                     if (!response2d) throw std::runtime_error("SVDUnfolder: response must be a TH2");
+                     return std::make_shared<SVDUnfolder>(response2d, tau, eps);
+                 }),
+                 py::arg("response"), py::arg("tau"), py::arg("eps") = 1e-3)
+            .def(py::init<const Matrix &, double, double>(),
+                 py::arg("response"), py::arg("tau"), py::arg("eps") = 1e-3)
+            .def("unfold", py::overload_cast<const Matrix &, double>(&SVDUnfolder::Unfold, py::const_),
+                 py::arg("reco"), py::arg("tau"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("unfold", py::overload_cast<const Matrix &>(&SVDUnfolder::Unfold, py::const_),
+                 py::arg("reco"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("scan_tau", &SVDUnfolder::ScanTau,
+                 py::arg("reco"), py::arg("taus"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def_property("tau", &SVDUnfolder::GetTau, &SVDUnfolder::SetTau)
+            .def_property_readonly("singular_values",
+                                   [](py::object self) {
+                                       const Vector & s = self.cast<const SVDUnfolder &>().GetSingularValues();
+                                       return View(s.data(), {s.size()}, {(py::ssize_t) sizeof(double)}, self, false);
+                                   });
+
+    DefCrossSection<EigenCrossSectionEstimator>(m, "EigenCrossSectionEstimator",
+                                                "Cross section of IEigenEval components");
+    DefCrossSection<EigenDifferentialCrossSectionEstimator>(m, "EigenDifferentialCrossSectionEstimator",
+                                                            "Cross section per unit bin width of IEigenEval components");
+    DefCrossSection<CrossSectionEstimator>(m, "CrossSectionEstimator",
+                                           "Cross section of arbitrary IMeasurement components");
+    DefCrossSection<DifferentialCrossSectionEstimator>(m, "DifferentialCrossSectionEstimator",
+                                                       "Cross section per unit bin width of arbitrary IMeasurement components");
+
+    /////////////////////////////////////////////////////////////////////////
+    py::class_<fit::IFitter, std::shared_ptr<fit::IFitter>>(m, "IFitter");
+    py::class_<fit::Minuit2TemplateFitter, fit::IFitter, std::shared_ptr<fit::Minuit2TemplateFitter>>(m, "Minuit2TemplateFitter")
+            .def(py::init<int, double, bool, double>(),
+                 py::arg("strategy") = 2, py::arg("up") = 1, py::arg("minos_errors") = true, py::arg("initial_error") = 0.01);
+    py::class_<fit::LinearTemplateFitter, fit::IFitter, std::shared_ptr<fit::LinearTemplateFitter>>(m, "LinearTemplateFitter")
+            .def(py::init<double, int, double>(),
+                 py::arg("up") = 1, py::arg("max_iterations") = 100, py::arg("tolerance") = 1e-8);
+    py::class_<fit::LBFGSBFitter, fit::IFitter, std::shared_ptr<fit::LBFGSBFitter>>(m, "LBFGSBFitter")
+            .def(py::init<double, int, int, double, double>(),
+                 py::arg("up") = 1, py::arg("memory") = 10, py::arg("max_iterations") = 10000,
+                 py::arg("gradient_tolerance") = 1e-5, py::arg("function_tolerance") = 1e-12);
+
+    py::class_<fit::IUserTemplateComponent, std::shared_ptr<fit::IUserTemplateComponent>>(m, "IUserTemplateComponent")
+            .def_property_readonly("nominal", &fit::IUserTemplateComponent::GetNominal);
+    py::class_<fit::UserTemplateComponent, fit::IUserTemplateComponent,
+               std::shared_ptr<fit::UserTemplateComponent>>(m, "UserTemplateComponent")
+            .def(py::init<std::shared_ptr<TH1>, std::map<std::string, Systematic<TH1>>>(),
+                 py::arg("mean"), py::arg("systematics") = std::map<std::string, Systematic<TH1>>());
+
+    py::class_<TemplateFitResult>(m, "TemplateFitResult",
+                                  "Arrays are views into the result's histograms, including under/overflow bins")
+            .def_readonly("fun_val", &TemplateFitResult::fun_val)
+            .def_readonly("fun_calls", &TemplateFitResult::fun_calls)
+            .def_property_readonly("component_params",
+                                   [](py::object self) {
+                                       return ParamsViews(self.cast<const TemplateFitResult &>().component_params, self);
+                                   })
+            .def_property_readonly("component_params_error_up",
+                                   [](py::object self) {
+                                       return ParamsViews(self.cast<const TemplateFitResult &>().component_params_error_up, self);
+                                   })
+            .def_property_readonly("component_params_error_down",
+                                   [](py::object self) {
+                                       return ParamsViews(self.cast<const TemplateFitResult &>().component_params_error_down, self);
+                                   })
+            .def_property_readonly("covariance",
+                                   [](py::object self) {
+                                       return InnerView2D(self.cast<const TemplateFitResult &>().covariance, self);
+                                   },
+                                   "Covariance of the parameters, without under/overflow bins");
+
+    py::class_<TemplateFitSignalEstimator, std::shared_ptr<TemplateFitSignalEstimator>>(
+            m, "TemplateFitSignalEstimator",
+            "fit and profile_scan run on their own copy of the fitter and fixed components, so they can be "
+            "called from several python threads at once. Configure the estimator with set_fitter, "
+            "fix_component and release_component before that")
+            .def(py::init([](const std::map<std::string, std::shared_ptr<fit::IUserTemplateComponent>> & components,
+                             std::map<std::string, Systematic<TH1>> shape_only_systematics,
+                             std::shared_ptr<TH1> mask) {
+                     std::map<std::string, const fit::IUserTemplateComponent *> raw;
+                     for (const auto & [label, component]: components) raw[label] = component.get();
+                     // the estimator holds components and mask by pointer,
+                     // so they're released along with it
+                     return std::shared_ptr<TemplateFitSignalEstimator>(
+                             new TemplateFitSignalEstimator(fit::TemplateFitSample(raw, std::move(shape_only_systematics)),
+                                                            mask.get()),
+                             [components, mask](TemplateFitSignalEstimator * estimator) { delete estimator; });
+                 }),
+                 py::arg("components"),
+                 py::arg("shape_only_systematics") = std::map<std::string, Systematic<TH1>>(),
+                 py::arg("mask") = py::none())
+            .def("set_fitter", &TemplateFitSignalEstimator::SetFitter,
+                 py::arg("fitter"),
+                 py::keep_alive<1, 2>())
+            .def("fit",
+                 [](const TemplateFitSignalEstimator & self, std::shared_ptr<TH1> data, int nrandom_seeds) {
+                     return Detach(self.NewSession().Fit(data, nrandom_seeds));
+                 },
+                 py::arg("data"), py::arg("nrandom_seeds") = -1,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("fit",
+                 [](const TemplateFitSignalEstimator & self, std::shared_ptr<TH1> data, const TemplateFitResult & previous) {
+                     return Detach(self.NewSession().Fit(data, previous));
+                 },
+                 py::arg("data"), py::arg("previous"),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Start from the minimum and covariance of a previous fit")
+            .def("chi2",
+                 [](const TemplateFitSignalEstimator & self, std::shared_ptr<TH1> data) { return self.Chi2(data); },
+                 py::arg("data"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("profile_scan",
+                 [](const TemplateFitSignalEstimator & self,
+                    std::shared_ptr<TH1> data,
+                    const std::string & component_label,
+                    int outer_bin,
+                    const std::vector<double> & values,
+                    int nthreads) {
+                     std::unique_ptr<TGraph> graph(self.ProfileScan(data, component_label, outer_bin, values, nthreads));
+                     return Vector(Eigen::Map<const Vector>(graph->GetY(), graph->GetN()));
+                 },
+                 py::arg("data"), py::arg("component_label"), py::arg("outer_bin"), py::arg("values"),
+                 py::arg("nthreads") = 0,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Profiled chi2 at each of values")
+            .def("fix_component", &TemplateFitSignalEstimator::FixComponent,
+                 py::arg("component_label"), py::arg("value") = 1)
+            .def("release_component", &TemplateFitSignalEstimator::ReleaseComponent,
+                 py::arg("component_label"))
+            .def("systematic_labels", &TemplateFitSignalEstimator::GetSystematicLabels)
+            .def("save_snapshot", &TemplateFitSignalEstimator::SaveSnapshot, py::arg("path"));
+}
@@ -0,0 +1,232 @@
+#include "XSecAna/Analysis.h"
+#include "XSecAna/Parallel.h"
+
+#include "RVersion.h"
+#include "TROOT.h"
+#include "ROOT/TBufferMerger.hxx"
+
+namespace xsec {
+    namespace {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 26, 0)
+        typedef ROOT::TBufferMerger BufferMerger;
+#else
+        typedef ROOT::Experimental::TBufferMerger BufferMerger;
+#endif
+    }
+
+    void
+    SaveAnalysis(xsec::IMeasurement * nominal,
+                 const std::vector<xsec::Systematic<xsec::IMeasurement>> & systematics,
+                 const TH1 * data,
+                 const std::string & filename,
+                 const std::string & subdir,
+                 int nthreads) {
+        ROOT::EnableThreadSafety();
+        TDirectory * tmp = gDirectory;
+        {
+            BufferMerger merger(filename.c_str(), "RECREATE");
+            // the last task writes the nominal and data.
+            // gDirectory is thread-local once thread safety is enabled
+            parallel::For(systematics.size() + 1, [&](std::size_t i) {
+                auto file = merger.GetFile();
+                auto dir = file->mkdir(subdir.c_str());
+                auto syst_dir = dir->mkdir("Systematics");
+                if (i == systematics.size()) {
+                    detail::SaveAnalysisHeader(nominal, systematics.size(), data, dir);
+                }
+                else {
+                    systematics[i].SaveTo(syst_dir, std::to_string(i));
+                }
+                file->Write();
+            }, nthreads);
+        } // merger writes out and closes filename on destruction
+        tmp->cd();
+    }
+
+    LazyAnalysis::
+    LazyAnalysis(xsec::type::LoadFunction<xsec::IMeasurement> load,
+                 const std::string & filename,
+                 const std::string & subdir)
+            : fLoad(load) {
+        // the I/O thread reads while the caller works with its own histograms
+        ROOT::EnableThreadSafety();
+        TDirectory * tmp = gDirectory;
+
+        fFile.reset(TFile::Open(filename.c_str()));
+        if (!fFile || fFile->IsZombie()) {
+            throw std::runtime_error("Unable to open " + filename);
+        }
+        auto dir = fFile->GetDirectory(subdir.c_str());
+        if (!dir) {
+            throw std::runtime_error(filename + " has no directory " + subdir);
+        }
+
+        auto ptag = (TObjString *) dir->Get("type");
+        assert(ptag->GetString() == "Analysis" && "Type does not match Analysis");
+        delete ptag;
+
+        fData = root::LoadTH1(dir, "Data");
+        fNominal = load(dir, "Nominal");
+
+        fSystematicsDir = dir->GetDirectory("Systematics");
+        auto nsysts = std::atoi(((TObjString *) dir->Get("NSystematics"))->GetString().Data());
+        fSystematics.resize(nsysts);
+        for (auto i = 0; i < nsysts; i++) {
+            auto syst_dir = fSystematicsDir->GetDirectory(std::to_string(i).c_str());
+            auto & info = fSystematics[i];
+            info.name = ((TObjString *) syst_dir->Get("fName"))->GetString().Data();
+            info.type = (SystType_t) std::atoi(((TObjString *) syst_dir->Get("fType"))->GetString().Data());
+            info.shifts.resize(std::atoi(((TObjString *) syst_dir->Get("NShifts"))->GetString().Data()));
+        }
+        tmp->cd();
+
+        fIOThread = std::thread(&LazyAnalysis::_io_loop, this);
+    }
+
+    LazyAnalysis::
+    ~LazyAnalysis() {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStop = true;
+        }
+        fWakeIO.notify_one();
+        fIOThread.join();
+
+        // nothing outstanding should wait forever
+        for (auto & request : fQueue) {
+            request.promise->set_exception(std::make_exception_ptr(
+                    std::runtime_error("LazyAnalysis destroyed before the shift was loaded")));
+        }
+    }
+
+    void
+    LazyAnalysis::
+    _io_loop() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(fMutex);
+                fWakeIO.wait(lock, [this]() { return fStop || !fQueue.empty(); });
+                if (fStop) return;
+                request = fQueue.front();
+                fQueue.pop_front();
+            }
+            try {
+                auto container_dir = fSystematicsDir->GetDirectory((std::to_string(request.isyst) + "/fContainer").c_str());
+                std::shared_ptr<IMeasurement> shift = fLoad(container_dir, std::to_string(request.ishift));
+                request.promise->set_value(shift);
+            }
+            catch (...) {
+                request.promise->set_exception(std::current_exception());
+            }
+        }
+    }
+
+    LazyAnalysis::Slot &
+    LazyAnalysis::
+    _request(std::size_t isyst, std::size_t ishift, bool urgent) {
+        auto & slot = fSystematics.at(isyst).shifts.at(ishift);
+        if (slot.valid()) {
+            if (urgent && slot.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                // move an already queued prefetch to the front
+                for (auto it = fQueue.begin(); it != fQueue.end(); it++) {
+                    if (it->isyst == isyst && it->ishift == ishift) {
+                        auto request = *it;
+                        fQueue.erase(it);
+                        fQueue.push_front(request);
+                        break;
+                    }
+                }
+            }
+            return slot;
+        }
+
+        auto promise = std::make_shared<std::promise<std::shared_ptr<IMeasurement>>>();
+        slot = promise->get_future().share();
+        if (urgent) fQueue.push_front({isyst, ishift, promise});
+        else fQueue.push_back({isyst, ishift, promise});
+        return slot;
+    }
+
+    std::shared_ptr<IMeasurement>
+    LazyAnalysis::
+    GetShift(std::size_t isyst, std::size_t ishift) {
+        Slot slot;
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            slot = _request(isyst, ishift, true);
+        }
+        fWakeIO.notify_one();
+        return slot.get();
+    }
+
+    Systematic<IMeasurement>
+    LazyAnalysis::
+    GetSystematic(std::size_t isyst) {
+        std::vector<Slot> slots;
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            const auto nshifts = fSystematics.at(isyst).shifts.size();
+            // push_front in reverse so the shifts are read in order
+            for (auto i = nshifts; i-- > 0;) {
+                slots.push_back(_request(isyst, i, true));
+            }
+        }
+        fWakeIO.notify_one();
+
+        std::vector<std::shared_ptr<IMeasurement>> container(slots.size());
+        for (auto i = 0u; i < slots.size(); i++) {
+            container[slots.size() - 1 - i] = slots[i].get();
+        }
+        return Systematic<IMeasurement>(fSystematics[isyst].name,
+                                        container,
+                                        fSystematics[isyst].type);
+    }
+
+    void
+    LazyAnalysis::
+    Prefetch(std::size_t isyst) {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            for (auto i = 0u; i < fSystematics.at(isyst).shifts.size(); i++) {
+                _request(isyst, i, false);
+            }
+        }
+        fWakeIO.notify_one();
+    }
+
+    bool
+    LazyAnalysis::
+    IsLoaded(std::size_t isyst) const {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (const auto & slot : fSystematics.at(isyst).shifts) {
+            if (!slot.valid() || slot.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void
+    LazyAnalysis::
+    Drop(std::size_t isyst, std::size_t ishift) {
+        std::lock_guard<std::mutex> lock(fMutex);
+        auto & slot = fSystematics.at(isyst).shifts.at(ishift);
+        // shifts still in flight are left to finish
+        if (slot.valid() && slot.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            slot = Slot();
+        }
+    }
+
+    void
+    LazyAnalysis::
+    Drop(std::size_t isyst) {
+        for (auto i = 0u; i < GetNShifts(isyst); i++) Drop(isyst, i);
+    }
+
+    void
+    LazyAnalysis::
+    DropAll() {
+        for (auto i = 0u; i < GetNSystematics(); i++) Drop(i);
+    }
+}
@@ -0,0 +1,164 @@
+#include "XSecAna/ArrayFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace xsec {
+    namespace {
+        const char kMagic[8] = {'X', 'S', 'A', 'R', 'R', 'A', 'Y', 'S'};
+        const std::uint64_t kVersion = 1;
+    }
+
+    void
+    ArrayFileWriter::
+    AddEntry(const std::string & name, Entry entry) {
+        if (fEntries.count(name)) {
+            throw std::runtime_error("ArrayFileWriter: duplicate entry " + name);
+        }
+        fEntries[name] = std::move(entry);
+    }
+
+    void
+    ArrayFileWriter::
+    Add(const std::string & name, const Matrix & matrix) {
+        AddEntry(name, {ArrayFile::kMatrix,
+                        (std::uint64_t) matrix.rows(),
+                        (std::uint64_t) matrix.cols(),
+                        std::string(reinterpret_cast<const char *>(matrix.data()),
+                                    matrix.size() * sizeof(double))});
+    }
+
+    void
+    ArrayFileWriter::
+    Add(const std::string & name, const std::vector<int> & ints) {
+        AddEntry(name, {ArrayFile::kInts,
+                        ints.size(),
+                        1,
+                        std::string(reinterpret_cast<const char *>(ints.data()),
+                                    ints.size() * sizeof(int))});
+    }
+
+    void
+    ArrayFileWriter::
+    Add(const std::string & name, const std::string & value) {
+        AddEntry(name, {ArrayFile::kString, value.size(), 1, value});
+    }
+
+    void
+    ArrayFileWriter::
+    Write(const std::string & path) const {
+        detail::ArrayFileHeader header;
+        header.signature = MappedFile::Signature(kMagic, kVersion);
+        header.nentries = fEntries.size();
+        header.index_offset = sizeof(header);
+
+        std::string names;
+        std::vector<detail::ArrayFileEntry> index;
+        for (const auto & entry : fEntries) {
+            detail::ArrayFileEntry e;
+            e.name_offset = names.size();
+            e.name_size = entry.first.size();
+            e.type = entry.second.type;
+            e.rows = entry.second.rows;
+            e.cols = entry.second.cols;
+            e.nbytes = entry.second.bytes.size();
+            names.append(entry.first);
+            index.push_back(e);
+        }
+        header.names_offset = header.index_offset + index.size() * sizeof(detail::ArrayFileEntry);
+        header.names_size = names.size();
+
+        std::size_t offset = MappedFile::Align(header.names_offset + header.names_size);
+        for (auto & e : index) {
+            e.offset = offset;
+            offset = MappedFile::Align(offset + e.nbytes);
+        }
+
+        // write to a temporary and rename so readers never map a partial file
+        auto tmp_path = path + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw std::runtime_error("Unable to open " + tmp_path + " for writing");
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(detail::ArrayFileEntry));
+            file.write(names.data(), names.size());
+            auto ientry = 0u;
+            for (const auto & entry : fEntries) {
+                MappedFile::PadTo(file, index[ientry++].offset);
+                file.write(entry.second.bytes.data(), entry.second.bytes.size());
+            }
+            MappedFile::PadTo(file, offset);
+            if (!file) {
+                throw std::runtime_error("ArrayFileWriter: failed to write " + tmp_path);
+            }
+        }
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("ArrayFileWriter: unable to move " + tmp_path + " to " + path);
+        }
+    }
+
+    ArrayFile::
+    ArrayFile(const std::string & path)
+            : fFile(path) {
+        auto header = fFile.ReadHeader<detail::ArrayFileHeader>(kMagic, {kVersion}, "array file");
+        if (header.names_offset + header.names_size > fFile.size() ||
+            header.index_offset + header.nentries * sizeof(detail::ArrayFileEntry) > header.names_offset) {
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        auto index = fFile.as<detail::ArrayFileEntry>(header.index_offset);
+        for (auto i = 0u; i < header.nentries; i++) {
+            const auto & e = index[i];
+            if (e.name_offset + e.name_size > header.names_size ||
+                e.offset + e.nbytes > fFile.size()) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            fEntries[std::string(fFile.data() + header.names_offset + e.name_offset, e.name_size)] = e;
+        }
+    }
+
+    std::vector<std::string>
+    ArrayFile::
+    GetNames() const {
+        std::vector<std::string> names;
+        for (const auto & entry : fEntries) names.push_back(entry.first);
+        return names;
+    }
+
+    const detail::ArrayFileEntry &
+    ArrayFile::
+    Find(const std::string & name, Type_t type) const {
+        auto it = fEntries.find(name);
+        if (it == fEntries.end()) {
+            throw std::runtime_error(fFile.path() + ": no entry named " + name);
+        }
+        if (it->second.type != (std::uint64_t) type) {
+            throw std::runtime_error(fFile.path() + ": entry " + name + " has the wrong type");
+        }
+        return it->second;
+    }
+
+    Eigen::Map<const Matrix>
+    ArrayFile::
+    GetMatrix(const std::string & name) const {
+        const auto & e = Find(name, kMatrix);
+        return Eigen::Map<const Matrix>(fFile.as<double>(e.offset), e.rows, e.cols);
+    }
+
+    Eigen::Map<const Eigen::VectorXi>
+    ArrayFile::
+    GetInts(const std::string & name) const {
+        const auto & e = Find(name, kInts);
+        return Eigen::Map<const Eigen::VectorXi>(fFile.as<int>(e.offset), e.rows);
+    }
+
+    std::string
+    ArrayFile::
+    GetString(const std::string & name) const {
+        const auto & e = Find(name, kString);
+        return std::string(fFile.data() + e.offset, e.nbytes);
+    }
+}
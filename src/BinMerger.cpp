@@ -0,0 +1,206 @@
+#include "XSecAna/BinMerger.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/Parallel.h"
+#include "XSecAna/SimpleQuadSum.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace xsec {
+    namespace {
+        const double kInfinity = std::numeric_limits<double>::infinity();
+
+        ///\brief Fine edges of a 1D histogram
+        Array FineEdges(const TH1 * h) {
+            if (h->GetDimension() != 1) {
+                throw std::runtime_error("BinMerger: only 1D histograms can be merged");
+            }
+            Array edges(h->GetNbinsX() + 1);
+            for (auto i = 0u; i < edges.size(); i++) {
+                edges(i) = h->GetXaxis()->GetBinLowEdge(i + 1);
+            }
+            return edges;
+        }
+    }
+
+    BinMerger::
+    BinMerger(const TH1 * nominal,
+              const std::map<std::string, Systematic<TH1>> & systematics,
+              MergeConstraints constraints,
+              MergeCost cost) {
+        fEdges = FineEdges(nominal);
+        auto nfine = GetNFineBins();
+        if (!cost) cost = [](double, double fractional_uncertainty) {
+            return fractional_uncertainty * fractional_uncertainty;
+        };
+
+        Array contents = root::MapContentsToEigen(nominal);
+        fNominal = Array::Zero(nfine + 1);
+        for (auto i = 0u; i < nfine; i++) fNominal(i + 1) = fNominal(i) + contents(i + 1);
+
+        struct Sums {
+            SystType_t type;
+            // cumulative sums of every shift, one per column
+            Matrix shifts;
+        };
+        std::vector<Sums> sums;
+        for (const auto & syst : systematics) {
+            auto universes = syst.second.GetUniverseMatrix();
+            if (!universes) universes = std::make_shared<MultiverseMatrix>(syst.second.GetShifts());
+            if (universes->GetNBins() != nfine + 2) {
+                throw std::runtime_error("BinMerger: " + syst.first + " does not match the nominal binning");
+            }
+            Matrix shifts = Matrix::Zero(nfine + 1, universes->GetNUniverses());
+            for (auto i = 0u; i < nfine; i++) {
+                shifts.row(i + 1) = shifts.row(i) + universes->GetMatrix().row(i + 1);
+            }
+            sums.push_back({syst.second.GetType(), std::move(shifts)});
+        }
+
+        fFractional = Matrix::Constant(nfine + 1, nfine + 1, std::numeric_limits<double>::quiet_NaN());
+        fCost = Matrix::Constant(nfine + 1, nfine + 1, kInfinity);
+        // every merged bin ending at last at once. Each worker fills its own column
+        parallel::For(nfine, [&](std::size_t i) {
+            auto last = i + 1;
+            Array merged = fNominal(last) - fNominal.head(last);
+            Array total2 = Array::Zero(last);
+            for (const auto & syst : sums) {
+                Matrix shifts = (-syst.shifts.topRows(last)).rowwise() + syst.shifts.row(last);
+                total2 += SimpleQuadSum::AbsoluteShift(merged, shifts, syst.type).square();
+            }
+            Array fractional = total2.sqrt() / merged;
+            Array width = fEdges(last) - fEdges.head(last);
+
+            for (auto first = 0u; first < last; first++) {
+                fFractional(first, last) = fractional(first);
+                if (merged(first) < constraints.min_content ||
+                    width(first) < constraints.min_width ||
+                    !(fractional(first) <= constraints.max_fractional_uncertainty)) {
+                    continue;
+                }
+                auto value = cost(merged(first), fractional(first));
+                if (std::isfinite(value)) fCost(first, last) = value;
+            }
+        });
+    }
+
+    double
+    BinMerger::
+    Content(std::size_t first, std::size_t last) const {
+        return fNominal(last) - fNominal(first);
+    }
+
+    double
+    BinMerger::
+    FractionalUncertainty(std::size_t first, std::size_t last) const {
+        return fFractional(first, last);
+    }
+
+    void
+    BinMerger::
+    _partition(std::size_t max_bins, Matrix & best, Eigen::MatrixXi & from) const {
+        auto nfine = GetNFineBins();
+        best = Matrix::Constant(max_bins + 1, nfine + 1, kInfinity);
+        from = Eigen::MatrixXi::Constant(max_bins + 1, nfine + 1, -1);
+        best(0, 0) = 0;
+        for (auto k = 1u; k <= max_bins; k++) {
+            // k bins need at least k fine bins
+            parallel::For(nfine + 1 - k, [&](std::size_t i) {
+                auto last = i + k;
+                for (auto first = k - 1; first < last; first++) {
+                    auto value = best(k - 1, first) + fCost(first, last);
+                    if (value < best(k, last)) {
+                        best(k, last) = value;
+                        from(k, last) = first;
+                    }
+                }
+            });
+        }
+    }
+
+    Array
+    BinMerger::
+    _edges(const Eigen::MatrixXi & from, std::size_t nbins) const {
+        Array edges(nbins + 1);
+        std::size_t last = GetNFineBins();
+        edges(nbins) = fEdges(last);
+        for (auto k = nbins; k > 0; k--) {
+            last = from(k, last);
+            edges(k - 1) = fEdges(last);
+        }
+        return edges;
+    }
+
+    Array
+    BinMerger::
+    Optimize(std::size_t nbins) const {
+        if (nbins == 0 || nbins > GetNFineBins()) {
+            throw std::runtime_error("BinMerger: can't make " + std::to_string(nbins) +
+                                     " bins from " + std::to_string(GetNFineBins()) + " fine bins");
+        }
+        Matrix best;
+        Eigen::MatrixXi from;
+        _partition(nbins, best, from);
+        if (!std::isfinite(best(nbins, GetNFineBins()))) {
+            throw std::runtime_error("BinMerger: no binning with " + std::to_string(nbins) +
+                                     " bins meets the constraints");
+        }
+        return _edges(from, nbins);
+    }
+
+    Array
+    BinMerger::
+    Finest() const {
+        Matrix best;
+        Eigen::MatrixXi from;
+        _partition(GetNFineBins(), best, from);
+        for (auto nbins = GetNFineBins(); nbins > 0; nbins--) {
+            if (std::isfinite(best(nbins, GetNFineBins()))) return _edges(from, nbins);
+        }
+        throw std::runtime_error("BinMerger: no binning meets the constraints");
+    }
+
+    std::shared_ptr<TH1>
+    BinMerger::
+    Rebin(const TH1 * fine, const Array & edges) {
+        if (edges.size() < 2) throw std::runtime_error("BinMerger: need at least two edges");
+        Array fine_edges = FineEdges(fine);
+        auto nfine = fine_edges.size() - 1;
+        auto nbins = edges.size() - 1;
+
+        // merged bin i holds fine bins [boundaries[i], boundaries[i + 1]), counting under/overflow
+        std::vector<int> boundaries(nbins + 3);
+        boundaries.front() = 0;
+        boundaries.back() = nfine + 2;
+        auto tolerance = 1e-9 * (fine_edges(nfine) - fine_edges(0));
+        for (auto i = 0u; i < edges.size(); i++) {
+            Eigen::Index ifine;
+            auto distance = (fine_edges - edges(i)).abs().minCoeff(&ifine);
+            if (distance > tolerance) {
+                throw std::runtime_error("BinMerger: " + std::to_string(edges(i)) +
+                                         " is not an edge of the fine bins");
+            }
+            boundaries[i + 1] = ifine + 1;
+            if (i > 0 && boundaries[i + 1] <= boundaries[i]) {
+                throw std::runtime_error("BinMerger: edges must be increasing");
+            }
+        }
+
+        Array fine_contents = root::MapContentsToEigen(fine);
+        Array fine_errors2 = root::MapErrorsToEigen(fine).square();
+        Array contents(nbins + 2);
+        Array errors2(nbins + 2);
+        for (auto i = 0u; i < nbins + 2; i++) {
+            auto n = boundaries[i + 1] - boundaries[i];
+            contents(i) = fine_contents.segment(boundaries[i], n).sum();
+            errors2(i) = fine_errors2.segment(boundaries[i], n).sum();
+        }
+
+        TH1D binning(root::MakeUnique("binning").c_str(), "", nbins, edges.data());
+        return std::shared_ptr<TH1>(root::ToROOT(contents,
+                                                 errors2.sqrt(),
+                                                 root::TH1Props(&binning,
+                                                                root::MakeUnique(fine->GetName()).c_str())));
+    }
+}
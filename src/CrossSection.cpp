@@ -88,6 +88,51 @@ namespace xsec {
         return result;
     }
 
+    namespace {
+        ///\brief Cross section of each column
+        const Array2D
+        CalculateCrossSectionBatch(const Array2D & unfolded_selected_signal,
+                                   const Array2D & efficiency,
+                                   const Array2D & flux,
+                                   const double ntargets,
+                                   const Array & bin_widths) {
+            Array2D denom = (efficiency * flux * ntargets / 1e4).colwise() * bin_widths;
+
+            Array2D result = unfolded_selected_signal / denom;
+            result = (denom == 0).select(0, result);
+            return result;
+        }
+
+        ///\brief Signal, unfolded signal, efficiency and flux of every column, then the cross section
+        void EvalCrossSectionBatch(const IMeasurement * signal_estimator,
+                                   const IMeasurement * unfold,
+                                   const IMeasurement * efficiency,
+                                   const IMeasurement * flux,
+                                   const double ntargets,
+                                   const Array & bin_widths,
+                                   const Array2D & data, const Array2D & error,
+                                   Array2DRef result, Array2DRef rerror) {
+            Array2D signal_c(data.rows(), data.cols()), signal_e(data.rows(), data.cols());
+            dynamic_cast<const IEigenSignalEstimator *>(signal_estimator)->_eval_batch(data, error, signal_c, signal_e);
+            dynamic_cast<const IEigenUnfoldEstimator *>(unfold)->_eval_batch(signal_c, signal_e, signal_c, signal_e);
+
+            Array2D eff_c(data.rows(), data.cols()), eff_e(data.rows(), data.cols());
+            dynamic_cast<const IEigenEfficiencyEstimator *>(efficiency)->_eval_batch(data, error, eff_c, eff_e);
+
+            Array2D flux_c(data.rows(), data.cols()), flux_e(data.rows(), data.cols());
+            dynamic_cast<const IEigenFluxEstimator *>(flux)->_eval_batch(data, error, flux_c, flux_e);
+
+            result = CalculateCrossSectionBatch(signal_c,
+                                                eff_c,
+                                                flux_c,
+                                                ntargets,
+                                                bin_widths);
+            rerror = ((signal_e / signal_c).square() +
+                      (flux_e / flux_c).square() +
+                      (eff_e / eff_c).square()).sqrt() * result;
+        }
+    }
+
     const std::shared_ptr<TH1>
     CalculateCrossSection(const TH1 * unfolded_selected_signal,
                           const TH1 * efficiency,
@@ -96,35 +141,27 @@ namespace xsec {
                           const bool is_differential) {
 
         root::TH1Props prop(unfolded_selected_signal);
-        Array bin_widths = Array::Ones(prop.nbins_and_uof);
-
-        Array result = CalculateCrossSection(root::MapContentsToEigen(unfolded_selected_signal),
-                                             root::MapContentsToEigen(efficiency),
-                                             root::MapContentsToEigen(flux),
+        Array bin_widths = is_differential ?
+                           root::MapBinWidthsToEigen(prop) :
+                           Array::Ones(prop.nbins_and_uof);
+
+        // contents are mapped in place, not copied
+        ArrayMap signal = root::MapContentsToEigen(unfolded_selected_signal);
+        ArrayMap eff = root::MapContentsToEigen(efficiency);
+        ArrayMap flx = root::MapContentsToEigen(flux);
+        Array result = CalculateCrossSection(signal,
+                                             eff,
+                                             flx,
                                              ntargets,
                                              bin_widths);
-        auto hresult = std::shared_ptr<TH1>(root::ToROOT(result, prop));
-        if(is_differential) {
-            hresult->Scale(1, "width");
-        }
-        for (auto x = 1; x <= hresult->GetNbinsX(); x++) {
-            for (auto y = 1; y <= hresult->GetNbinsY(); y++) {
-                for (auto z = 1; z <= hresult->GetNbinsZ(); z++) {
-                    double r = hresult->GetBinContent(x, y, z);
-                    if (!r) continue;
-
-                    double deff = efficiency->GetBinError(x, y, z) / efficiency->GetBinContent(x, y, z);
-                    double dflux = flux->GetBinError(x, y, z) / flux->GetBinContent(x, y, z);
-                    double dsig = unfolded_selected_signal->GetBinError(x, y, z) /
-                                  unfolded_selected_signal->GetBinContent(x, y, z);
-
-                    double e = std::sqrt(deff * deff +
-                                         dflux * dflux +
-                                         dsig * dsig);
-                    hresult->SetBinError(x, y, z, e * r);
-                }
-            }
-        }
+
+        // result is nonzero only where every input is, so relative errors are finite there
+        Array relative_error = ((root::MapErrorsToEigen(efficiency) / eff).square() +
+                                (root::MapErrorsToEigen(flux) / flx).square() +
+                                (root::MapErrorsToEigen(unfolded_selected_signal) / signal).square()).sqrt();
+        Array error = (result == 0).select(0, relative_error * result);
+
+        auto hresult = std::shared_ptr<TH1>(root::ToROOT(result, error, prop));
         return hresult;
     }
 
@@ -170,21 +207,41 @@ namespace xsec {
     }
 
 
+    ////////////////////////////////////////////////
+    Array
+    EigenDifferentialCrossSectionEstimator::
+    _bin_widths() const {
+        const auto & props = this->GetHistProps();
+        Array key = root::MapBinEdgesToEigen(props);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(fBinWidths.mutex);
+            if (fBinWidths.IsValidFor(key)) return fBinWidths.result;
+        }
+        std::unique_lock<std::shared_mutex> lock(fBinWidths.mutex);
+        if (!fBinWidths.IsValidFor(key)) {
+            fBinWidths.key = key;
+            fBinWidths.result = root::MapBinWidthsToEigen(props);
+            fBinWidths.valid = true;
+        }
+        return fBinWidths.result;
+    }
+
     ////////////////////////////////////////////////
     void
     EigenCrossSectionEstimator::
     _eval_impl(const Array & data, const Array & error,
                ArrayRef result, ArrayRef rerror) const {
         Array signal_c(data.size()), signal_e(data.size());
-        dynamic_cast<IEigenSignalEstimator *>(fSignalEstimator)->_eval_impl(data, error, signal_c, signal_e);
-        dynamic_cast<IEigenUnfoldEstimator *>(fUnfold)->_eval_impl(signal_c, signal_e, signal_c, signal_e);
+        dynamic_cast<IEigenSignalEstimator *>(fSignalEstimator)->_eval(data, error, signal_c, signal_e);
+        dynamic_cast<IEigenUnfoldEstimator *>(fUnfold)->_eval(signal_c, signal_e, signal_c, signal_e);
 
 
         Array eff_c(data.size()), eff_e(data.size());
-        dynamic_cast<IEigenEfficiencyEstimator *>(fEfficiency)->_eval_impl(data, error, eff_c, eff_e);
+        dynamic_cast<IEigenEfficiencyEstimator *>(fEfficiency)->_eval(data, error, eff_c, eff_e);
 
         Array flux_c(data.size()), flux_e(data.size());
-        dynamic_cast<IEigenFluxEstimator *>(fFlux)->_eval_impl(data, error, flux_c, flux_e);
+        dynamic_cast<IEigenFluxEstimator *>(fFlux)->_eval(data, error, flux_c, flux_e);
 
         result = CalculateCrossSection(signal_c,
                                        eff_c,
@@ -202,17 +259,17 @@ namespace xsec {
     _eval_impl(const Array & data, const Array & error,
                ArrayRef result, ArrayRef rerror) const {
         Array signal_c(data.size()), signal_e(data.size());
-        dynamic_cast<IEigenSignalEstimator *>(fSignalEstimator)->_eval_impl(data, error, signal_c, signal_e);
-        dynamic_cast<IEigenUnfoldEstimator *>(fUnfold)->_eval_impl(signal_c, signal_e, signal_c, signal_e);
+        dynamic_cast<IEigenSignalEstimator *>(fSignalEstimator)->_eval(data, error, signal_c, signal_e);
+        dynamic_cast<IEigenUnfoldEstimator *>(fUnfold)->_eval(signal_c, signal_e, signal_c, signal_e);
 
 
         Array eff_c(data.size()), eff_e(data.size());
-        dynamic_cast<IEigenEfficiencyEstimator *>(fEfficiency)->_eval_impl(data, error, eff_c, eff_e);
+        dynamic_cast<IEigenEfficiencyEstimator *>(fEfficiency)->_eval(data, error, eff_c, eff_e);
 
         Array flux_c(data.size()), flux_e(data.size());
-        dynamic_cast<IEigenFluxEstimator *>(fFlux)->_eval_impl(data, error, flux_c, flux_e);
+        dynamic_cast<IEigenFluxEstimator *>(fFlux)->_eval(data, error, flux_c, flux_e);
 
-        auto bin_widths = root::MapBinWidthsToEigen(this->GetHistProps());
+        auto bin_widths = _bin_widths();
 
         result = CalculateCrossSection(signal_c,
                                        eff_c,
@@ -225,6 +282,26 @@ namespace xsec {
                   (eff_e / eff_c).pow(2)).sqrt() * result;
     }
 
+    ////////////////////////////////////////////////
+    void
+    EigenCrossSectionEstimator::
+    _eval_batch_impl(const Array2D & data, const Array2D & error,
+                     Array2DRef result, Array2DRef rerror) const {
+        EvalCrossSectionBatch(fSignalEstimator, fUnfold, fEfficiency, fFlux, fNTargets,
+                              Array::Ones(data.rows()),
+                              data, error, result, rerror);
+    }
+
+    ////////////////////////////////////////////////
+    void
+    EigenDifferentialCrossSectionEstimator::
+    _eval_batch_impl(const Array2D & data, const Array2D & error,
+                     Array2DRef result, Array2DRef rerror) const {
+        EvalCrossSectionBatch(fSignalEstimator, fUnfold, fEfficiency, fFlux, fNTargets,
+                              _bin_widths(),
+                              data, error, result, rerror);
+    }
+
     ////////////////////////////////////////////////
     void
     ICrossSection::
@@ -0,0 +1,165 @@
+#include "XSecAna/CutScanner.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/Parallel.h"
+#include "XSecAna/SimpleQuadSum.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace xsec {
+    namespace {
+        ///\brief Contents of every shift of a systematic, one per column
+        Matrix ShiftContents(const Systematic<TH1> & systematic, std::size_t nbins_and_uof) {
+            if (systematic.GetUniverseMatrix()) {
+                if (systematic.GetUniverseMatrix()->GetNBins() != nbins_and_uof) {
+                    throw std::runtime_error("CutScanner: " + systematic.GetName() +
+                                             " does not match the nominal binning");
+                }
+                return systematic.GetUniverseMatrix()->GetMatrix();
+            }
+            const auto & shifts = systematic.GetShifts();
+            Matrix contents(nbins_and_uof, shifts.size());
+            for (auto i = 0u; i < shifts.size(); i++) {
+                if (root::TH1Props(shifts[i].get()).nbins_and_uof != nbins_and_uof) {
+                    throw std::runtime_error("CutScanner: " + systematic.GetName() +
+                                             " does not match the nominal binning");
+                }
+                contents.col(i) = root::MapContentsToEigen(shifts[i].get()).matrix();
+            }
+            return contents;
+        }
+    }
+
+    CutScanner::
+    CutScanner(const TH1 * nominal,
+               const std::map<std::string, Systematic<TH1>> & systematics,
+               CutDirection_t direction)
+            : fDirection(direction) {
+        root::TH1Props props(nominal);
+        fNX = nominal->GetNbinsX();
+        fNBins = props.nbins_and_uof / (fNX + 2);
+
+        fCutValues.resize(fNX + 1);
+        for (auto k = 0u; k <= fNX; k++) {
+            fCutValues(k) = nominal->GetXaxis()->GetBinLowEdge(k + 1);
+        }
+
+        if (props.dims == 1) {
+            fInner = {0};
+        } else {
+            std::size_t ny = nominal->GetNbinsY();
+            std::size_t nz = props.dims == 3 ? nominal->GetNbinsZ() : 0;
+            for (auto ibin = 0u; ibin < fNBins; ibin++) {
+                auto iy = ibin % (ny + 2);
+                auto iz = ibin / (ny + 2);
+                if (iy < 1 || iy > ny) continue;
+                if (props.dims == 3 && (iz < 1 || iz > nz)) continue;
+                fInner.push_back(ibin);
+            }
+        }
+
+        fNominal = _cumulative(root::MapContentsToEigen(nominal).matrix());
+        for (const auto & syst : systematics) {
+            Sample sample;
+            sample.type = syst.second.GetType();
+            auto contents = ShiftContents(syst.second, props.nbins_and_uof);
+            sample.nshifts = contents.cols();
+            sample.selected = _cumulative(contents);
+            fSystematics[syst.first] = std::move(sample);
+        }
+    }
+
+    Matrix
+    CutScanner::
+    _cumulative(const Matrix & contents) const {
+        Matrix result(contents.cols() * fNBins, fNX + 1);
+        for (auto ishift = 0u; ishift < contents.cols(); ishift++) {
+            // x runs down the rows in ROOT's global bin order
+            Eigen::Map<const Matrix> bins(contents.col(ishift).data(), fNX + 2, fNBins);
+            auto selected = result.middleRows(ishift * fNBins, fNBins);
+            Vector sum = Vector::Zero(fNBins);
+            if (fDirection == kKeepAbove) {
+                // cut k keeps x bins k+1 through overflow
+                for (int k = fNX; k >= 0; k--) {
+                    sum += bins.row(k + 1).transpose();
+                    selected.col(k) = sum;
+                }
+            } else {
+                // cut k keeps underflow through x bin k
+                for (auto k = 0u; k <= fNX; k++) {
+                    sum += bins.row(k).transpose();
+                    selected.col(k) = sum;
+                }
+            }
+        }
+        return result;
+    }
+
+    Array
+    CutScanner::
+    SelectedNominal(std::size_t icut) const {
+        return fNominal.col(icut).array();
+    }
+
+    Matrix
+    CutScanner::
+    SelectedShifts(const std::string & systematic, std::size_t icut) const {
+        auto it = fSystematics.find(systematic);
+        if (it == fSystematics.end()) {
+            throw std::runtime_error("CutScanner: no systematic named " + systematic);
+        }
+        return Eigen::Map<const Matrix>(it->second.selected.col(icut).data(),
+                                        fNBins,
+                                        it->second.nshifts);
+    }
+
+    Array
+    CutScanner::
+    _fractional_uncertainty(std::size_t icut) const {
+        Array nominal = SelectedNominal(icut);
+        Array total2 = Array::Zero(fNBins);
+        for (const auto & syst : fSystematics) {
+            total2 += SimpleQuadSum::AbsoluteShift(nominal,
+                                                   SelectedShifts(syst.first, icut),
+                                                   syst.second.type).square();
+        }
+        return total2.sqrt() / nominal;
+    }
+
+    Matrix
+    CutScanner::
+    TotalFractionalUncertainty() const {
+        Matrix result(fNBins, GetNCuts());
+        parallel::For(GetNCuts(), [&](std::size_t icut) {
+            result.col(icut) = _fractional_uncertainty(icut).matrix();
+        });
+        return result;
+    }
+
+    Array
+    CutScanner::
+    _inner(const Array & arr) const {
+        Array inner(fInner.size());
+        for (auto i = 0u; i < fInner.size(); i++) inner(i) = arr(fInner[i]);
+        return inner;
+    }
+
+    distributed::OptimizationResult
+    CutScanner::
+    Scan(const CutObjective & objective) const {
+        std::vector<double> values(GetNCuts());
+        parallel::For(GetNCuts(), [&](std::size_t icut) {
+            values[icut] = objective(_inner(SelectedNominal(icut)),
+                                     _inner(_fractional_uncertainty(icut)));
+        });
+        return distributed::Minimum(std::move(values));
+    }
+
+    distributed::OptimizationResult
+    CutScanner::
+    Scan() const {
+        return Scan([](const Array &, const Array & fractional_uncertainty) {
+            return std::sqrt(fractional_uncertainty.square().sum());
+        });
+    }
+}
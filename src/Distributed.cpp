@@ -0,0 +1,269 @@
+#include "XSecAna/Distributed.h"
+#include "XSecAna/Parallel.h"
+#include "XSecAna/SimpleQuadSum.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace xsec {
+    namespace distributed {
+        namespace {
+            // sent from a forked worker for each candidate. Small enough for writes to a pipe to be atomic
+            struct Record {
+                std::uint64_t index;
+                double value;
+            };
+
+            // index of the record a worker sends if its objective throws
+            const std::uint64_t kFailed = std::numeric_limits<std::uint64_t>::max();
+
+            bool WriteAll(int fd, const void * buf, std::size_t size) {
+                auto p = static_cast<const char *>(buf);
+                while (size > 0) {
+                    auto n = write(fd, p, size);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) return false;
+                    p += n;
+                    size -= n;
+                }
+                return true;
+            }
+
+            ///\brief Returns false at end of file
+            bool ReadAll(int fd, void * buf, std::size_t size) {
+                auto p = static_cast<char *>(buf);
+                while (size > 0) {
+                    auto n = read(fd, p, size);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n < 0) throw std::runtime_error(std::string("ForkDriver: ") + std::strerror(errno));
+                    if (n == 0) return false;
+                    p += n;
+                    size -= n;
+                }
+                return true;
+            }
+        }
+
+        std::vector<double>
+        ThreadDriver::
+        Evaluate(std::size_t ncandidates, const std::function<double(std::size_t)> & objective) {
+            std::vector<double> values(ncandidates);
+            parallel::For(ncandidates, [&](std::size_t i) { values[i] = objective(i); }, fNThreads);
+            return values;
+        }
+
+        std::vector<double>
+        ForkDriver::
+        Evaluate(std::size_t ncandidates, const std::function<double(std::size_t)> & objective) {
+            std::size_t nworkers = fNWorkers > 0 ? fNWorkers : parallel::GetNThreads();
+            nworkers = std::min(nworkers, ncandidates);
+            std::vector<double> values(ncandidates, std::numeric_limits<double>::quiet_NaN());
+            if (nworkers <= 1) {
+                for (auto i = 0u; i < ncandidates; i++) values[i] = objective(i);
+                return values;
+            }
+
+            std::vector<pid_t> pids;
+            std::vector<int> fds;
+            // if a pipe or fork fails partway, stop the workers already started before giving up
+            auto abort_workers = [&pids, &fds](const std::string & reason) {
+                for (auto fd : fds) close(fd);
+                for (auto pid : pids) {
+                    kill(pid, SIGKILL);
+                    while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR);
+                }
+                throw std::runtime_error("ForkDriver: " + reason);
+            };
+            for (auto iworker = 0u; iworker < nworkers; iworker++) {
+                int fd[2];
+                if (pipe(fd) != 0) abort_workers(std::strerror(errno));
+                pid_t pid = fork();
+                if (pid < 0) {
+                    std::string reason = std::strerror(errno);
+                    close(fd[0]);
+                    close(fd[1]);
+                    abort_workers(reason);
+                }
+                if (pid == 0) {
+                    close(fd[0]);
+                    // pipes of earlier workers belong to the parent
+                    for (auto other : fds) close(other);
+                    int status = 0;
+                    bool threw = true;
+                    try {
+                        for (std::size_t i = iworker; i < ncandidates; i += nworkers) {
+                            Record record{i, objective(i)};
+                            if (!WriteAll(fd[1], &record, sizeof(record))) {
+                                status = 1;
+                                break;
+                            }
+                        }
+                        threw = false;
+                    }
+                    catch (std::exception & e) {
+                        std::cerr << "ForkDriver: worker " << iworker << ": " << e.what() << std::endl;
+                    }
+                    catch (...) {
+                        std::cerr << "ForkDriver: worker " << iworker << ": unknown exception" << std::endl;
+                    }
+                    if (threw) {
+                        Record record{kFailed, 0};
+                        WriteAll(fd[1], &record, sizeof(record));
+                        status = 1;
+                    }
+                    close(fd[1]);
+                    // skip the parent's atexit handlers and static destructors
+                    _exit(status);
+                }
+                close(fd[1]);
+                pids.push_back(pid);
+                fds.push_back(fd[0]);
+            }
+
+            // a worker only blocks on its own pipe, so reading them in turn can't deadlock
+            bool failed = false;
+            std::size_t nreceived = 0;
+            for (auto fd : fds) {
+                Record record;
+                while (ReadAll(fd, &record, sizeof(record))) {
+                    if (record.index == kFailed || record.index >= ncandidates) {
+                        failed = true;
+                        continue;
+                    }
+                    values[record.index] = record.value;
+                    nreceived++;
+                }
+                close(fd);
+            }
+            for (auto pid : pids) {
+                int status;
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+            }
+            if (failed || nreceived != ncandidates) {
+                throw std::runtime_error("ForkDriver: a worker failed to evaluate its candidates");
+            }
+            return values;
+        }
+
+#ifdef XSECANA_USE_MPI
+        namespace {
+            void FinalizeMPI() {
+                int finalized;
+                MPI_Finalized(&finalized);
+                if (!finalized) MPI_Finalize();
+            }
+        }
+
+        MPIDriver::
+        MPIDriver(MPI_Comm comm) {
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (finalized) {
+                throw std::runtime_error("MPIDriver: MPI has already been finalized and can't be initialized again");
+            }
+            int initialized;
+            MPI_Initialized(&initialized);
+            if (!initialized) {
+                // finalizing at exit rather than with this driver lets later drivers use MPI too
+                MPI_Init(nullptr, nullptr);
+                std::atexit(FinalizeMPI);
+            }
+            MPI_Comm_dup(comm, &fComm);
+            MPI_Comm_rank(fComm, &fRank);
+            MPI_Comm_size(fComm, &fSize);
+        }
+
+        MPIDriver::
+        ~MPIDriver() {
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized) MPI_Comm_free(&fComm);
+        }
+
+        std::vector<double>
+        MPIDriver::
+        Evaluate(std::size_t ncandidates, const std::function<double(std::size_t)> & objective) {
+            // every value is computed by exactly one rank, so summing zeros from the others combines them
+            std::vector<double> values(ncandidates, 0);
+            int status = 0;
+            try {
+                for (auto i = (std::size_t) fRank; i < ncandidates; i += fSize) values[i] = objective(i);
+            }
+            catch (std::exception & e) {
+                std::cerr << "MPIDriver: rank " << fRank << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            catch (...) {
+                // the other ranks are waiting in MPI_Allreduce, so this rank has to get there too
+                std::cerr << "MPIDriver: rank " << fRank << ": unknown exception" << std::endl;
+                status = 1;
+            }
+            int any_failed;
+            MPI_Allreduce(&status, &any_failed, 1, MPI_INT, MPI_MAX, fComm);
+            if (any_failed) throw std::runtime_error("MPIDriver: a rank failed to evaluate its candidates");
+
+            MPI_Allreduce(MPI_IN_PLACE, values.data(), (int) ncandidates, MPI_DOUBLE, MPI_SUM, fComm);
+            return values;
+        }
+#endif
+
+        OptimizationResult
+        Minimum(std::vector<double> values) {
+            OptimizationResult result{0, std::numeric_limits<double>::quiet_NaN(), std::move(values)};
+            for (auto i = 0u; i < result.values.size(); i++) {
+                if (std::isnan(result.values[i])) continue;
+                if (std::isnan(result.value) || result.values[i] < result.value) {
+                    result.best = i;
+                    result.value = result.values[i];
+                }
+            }
+            if (std::isnan(result.value)) {
+                throw std::runtime_error("Minimum: no candidate has a valid objective");
+            }
+            return result;
+        }
+
+        double
+        TotalFractionalUncertainty(const AnalysisSpec & analysis) {
+            const TH1 * data = analysis.data.get();
+            auto total = std::get<1>(SimpleQuadSum::TotalFractionalUncertainty(analysis.nominal.get(),
+                                                                                analysis.systematics,
+                                                                                data));
+            return std::sqrt(root::MapContentsToEigenInner(total.Up().get()).square().sum());
+        }
+
+        OptimizationResult
+        OptimizeBinning(IDriver & driver,
+                        const std::vector<Array> & candidate_edges,
+                        const std::function<AnalysisSpec(const Array &)> & make_analysis,
+                        const AnalysisObjective & objective) {
+            return Minimum(driver.Evaluate(candidate_edges.size(), [&](std::size_t i) {
+                return objective(make_analysis(candidate_edges[i]));
+            }));
+        }
+
+        OptimizationResult
+        OptimizeCut(IDriver & driver,
+                    double lo,
+                    double hi,
+                    int nsteps,
+                    const std::function<AnalysisSpec(double)> & make_analysis,
+                    const AnalysisObjective & objective) {
+            Array cuts = Array::LinSpaced(nsteps, lo, hi);
+            return Minimum(driver.Evaluate(nsteps, [&](std::size_t i) {
+                return objective(make_analysis(cuts(i)));
+            }));
+        }
+    }
+}
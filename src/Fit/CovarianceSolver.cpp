@@ -0,0 +1,350 @@
+#include "XSecAna/Fit/CovarianceSolver.h"
+#include "XSecAna/Parallel.h"
+#include <Eigen/OrderingMethods>
+#include <numeric>
+
+namespace xsec {
+    namespace fit {
+        constexpr double CovarianceSolver::kMaxSparseDensity;
+        constexpr double CovarianceSolver::kMaxBandFraction;
+        constexpr double CovarianceSolver::kMinParallelBlockWork;
+
+        namespace {
+            bool IsNonZero(const Eigen::Ref<const Matrix> & m, int i, int j, double zero_threshold) {
+                if (zero_threshold <= 0) return m(i, j) != 0;
+                return std::abs(m(i, j)) > zero_threshold * std::sqrt(std::abs(m(i, i) * m(j, j)));
+            }
+
+            int FindRoot(std::vector<int> & parent, int i) {
+                while (parent[i] != i) {
+                    parent[i] = parent[parent[i]];
+                    i = parent[i];
+                }
+                return i;
+            }
+        }
+
+        CovarianceSolver::
+        CovarianceSolver(const Matrix & covariance,
+                         CovarianceStructure_t structure,
+                         double zero_threshold)
+                : fCovariance(covariance) {
+            assert(covariance.rows() == covariance.cols());
+            DetectStructure(zero_threshold);
+            if (structure != kAutoStructure) fStructure = structure;
+
+            switch (fStructure) {
+                case kBlockDiagonalStructure:
+                    SetupBlocks();
+                    break;
+                case kSparseStructure:
+                    SetupSparse(zero_threshold);
+                    break;
+                default:
+                    fDecomp.compute(fCovariance);
+                    break;
+            }
+        }
+
+        CovarianceSolver::
+        CovarianceSolver(Eigen::Map<const Matrix> covariance,
+                         const double * lower_factor,
+                         std::shared_ptr<const void> owner)
+                : fMappedCovariance(covariance.data()),
+                  fNMappedBins(covariance.rows()),
+                  fFactor(lower_factor),
+                  fFactorOwner(owner) {
+            assert(covariance.rows() == covariance.cols());
+            DetectStructure(0);
+            fStructure = kDenseStructure;
+        }
+
+        Matrix
+        CovarianceSolver::
+        GetCholeskyFactor() const {
+            if (fStructure != kDenseStructure) return Matrix();
+            if (fFactor) return Eigen::Map<const Matrix>(fFactor, fNMappedBins, fNMappedBins);
+            return fDecomp.matrixL();
+        }
+
+        void
+        CovarianceSolver::
+        DetectStructure(double zero_threshold) {
+            auto covariance = GetCovariance();
+            const int n = covariance.rows();
+            std::vector<int> parent(n);
+            std::iota(parent.begin(), parent.end(), 0);
+
+            long nnonzero = 0;
+            fBandwidth = 0;
+            for (auto j = 0; j < n; j++) {
+                for (auto i = j + 1; i < n; i++) {
+                    if (!IsNonZero(covariance, i, j, zero_threshold)) continue;
+                    nnonzero++;
+                    fBandwidth = std::max(fBandwidth, i - j);
+                    int ri = FindRoot(parent, i);
+                    int rj = FindRoot(parent, j);
+                    if (ri != rj) parent[std::max(ri, rj)] = std::min(ri, rj);
+                }
+            }
+            fDensity = n ? (2. * nnonzero + n) / ((double) n * n) : 1;
+
+            // group connected bins. Blocks are ordered by their first bin
+            std::vector<int> block_of_root(n, -1);
+            fBlocks.clear();
+            for (auto i = 0; i < n; i++) {
+                int root = FindRoot(parent, i);
+                if (block_of_root[root] < 0) {
+                    block_of_root[root] = fBlocks.size();
+                    fBlocks.emplace_back();
+                }
+                fBlocks[block_of_root[root]].push_back(i);
+            }
+
+            if (fBlocks.size() > 1) {
+                fStructure = kBlockDiagonalStructure;
+            }
+            else if (n > 1 && (fDensity <= kMaxSparseDensity ||
+                               fBandwidth <= kMaxBandFraction * n)) {
+                fStructure = kSparseStructure;
+            }
+            else {
+                fStructure = kDenseStructure;
+            }
+        }
+
+        void
+        CovarianceSolver::
+        SetupBlocks() {
+            fDiagonalIdx.clear();
+            fMultiBinBlocks.clear();
+            fBlockCovariances.clear();
+            fBlockDecomps.clear();
+            fBlockWork = 0;
+            for (auto i = 0u; i < fBlocks.size(); i++) {
+                if (fBlocks[i].size() == 1) {
+                    fDiagonalIdx.push_back(fBlocks[i][0]);
+                }
+                else {
+                    fMultiBinBlocks.push_back(i);
+                    fBlockCovariances.push_back(fCovariance(fBlocks[i], fBlocks[i]));
+                    fBlockDecomps.emplace_back(fBlockCovariances.back());
+                    fBlockWork += std::pow(fBlocks[i].size(), 3) / 3.;
+                }
+            }
+            fDiagonalVariance = fCovariance.diagonal()(fDiagonalIdx);
+        }
+
+        void
+        CovarianceSolver::
+        SetupSparse(double zero_threshold) {
+            auto covariance = GetCovariance();
+            const int n = covariance.rows();
+            std::vector<Eigen::Triplet<double>> triplets;
+            for (auto j = 0; j < n; j++) {
+                // keep the diagonal even if zero so the statistical term
+                // can always be added in place
+                triplets.emplace_back(j, j, covariance(j, j));
+                for (auto i = j + 1; i < n; i++) {
+                    if (IsNonZero(covariance, i, j, zero_threshold)) {
+                        triplets.emplace_back(i, j, covariance(i, j));
+                        triplets.emplace_back(j, i, covariance(i, j));
+                    }
+                }
+            }
+            SparseMatrix full(n, n);
+            full.setFromTriplets(triplets.begin(), triplets.end());
+
+            // banded matrices don't fill in under natural ordering,
+            // otherwise reduce fill-in with an approximate minimum degree ordering
+            if (fBandwidth <= kMaxBandFraction * n) {
+                fPermutation.setIdentity(n);
+            }
+            else {
+                Eigen::AMDOrdering<int> ordering;
+                Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> pinv;
+                ordering(full, pinv);
+                fPermutation = pinv.inverse();
+            }
+
+            fSparseCovariance = SparseMatrix(n, n);
+            fSparseCovariance.selfadjointView<Eigen::Lower>() =
+                    full.selfadjointView<Eigen::Lower>().twistedBy(fPermutation);
+            fSparseCovariance.makeCompressed();
+
+            fSparseDiagonalIdx.resize(n);
+            for (auto j = 0; j < n; j++) {
+                for (SparseMatrix::InnerIterator it(fSparseCovariance, j); it; ++it) {
+                    if (it.row() == j) {
+                        fSparseDiagonalIdx[j] = &it.value() - fSparseCovariance.valuePtr();
+                        break;
+                    }
+                }
+            }
+
+            fSparseDecomp = std::make_shared<SparseLLT>(fSparseCovariance);
+        }
+
+        double
+        CovarianceSolver::
+        Chi2(const Vector & v, const Vector & diagonal) const {
+            switch (fStructure) {
+                case kBlockDiagonalStructure:
+                    return BlockChi2(v, diagonal, false);
+                case kSparseStructure:
+                    return SparseChi2(v, diagonal);
+                default:
+                    Matrix total_covariance = GetCovariance();
+                    total_covariance.diagonal() += diagonal;
+                    Eigen::LLT<Matrix> decomp(total_covariance);
+                    return v.dot(decomp.solve(v));
+            }
+        }
+
+        double
+        CovarianceSolver::
+        Chi2(const Vector & v) const {
+            switch (fStructure) {
+                case kBlockDiagonalStructure:
+                    return BlockChi2(v, Vector(), true);
+                case kSparseStructure: {
+                    Vector vp = fPermutation * v;
+                    return vp.dot(fSparseDecomp->solve(vp));
+                }
+                default:
+                    if (fFactor) {
+                        // v^T (L L^T)^-1 v = |L^-1 v|^2
+                        Eigen::Map<const Matrix> L(fFactor, fNMappedBins, fNMappedBins);
+                        return L.triangularView<Eigen::Lower>().solve(v).squaredNorm();
+                    }
+                    return v.dot(fDecomp.solve(v));
+            }
+        }
+
+        double
+        CovarianceSolver::
+        BlockChi2(const Vector & v, const Vector & diagonal, bool cached) const {
+            double chi2 = 0;
+            if (!fDiagonalIdx.empty()) {
+                Vector variance = fDiagonalVariance;
+                if (!cached) variance += diagonal(fDiagonalIdx);
+                chi2 += (v(fDiagonalIdx).array().square() / variance.array()).sum();
+            }
+
+            std::vector<double> block_chi2(fMultiBinBlocks.size(), 0);
+            auto solve_block = [&](std::size_t i) {
+                const auto & idx = fBlocks[fMultiBinBlocks[i]];
+                Vector vb = v(idx);
+                if (cached) {
+                    block_chi2[i] = vb.dot(fBlockDecomps[i].solve(vb));
+                }
+                else {
+                    Matrix cb = fBlockCovariances[i];
+                    cb.diagonal() += diagonal(idx);
+                    Eigen::LLT<Matrix> decomp(cb);
+                    block_chi2[i] = vb.dot(decomp.solve(vb));
+                }
+            };
+            if (!cached && fBlockWork >= kMinParallelBlockWork) {
+                parallel::For(fMultiBinBlocks.size(), solve_block);
+            }
+            else {
+                for (auto i = 0u; i < fMultiBinBlocks.size(); i++) solve_block(i);
+            }
+
+            // sum in a fixed order so results don't depend on scheduling
+            for (const auto & c : block_chi2) chi2 += c;
+            return chi2;
+        }
+
+        double
+        CovarianceSolver::
+        SparseChi2(const Vector & v, const Vector & diagonal) const {
+            SparseMatrix total_covariance = fSparseCovariance;
+            Vector dp = fPermutation * diagonal;
+            for (auto j = 0u; j < fSparseDiagonalIdx.size(); j++) {
+                total_covariance.valuePtr()[fSparseDiagonalIdx[j]] += dp(j);
+            }
+            SparseLLT decomp(total_covariance);
+            Vector vp = fPermutation * v;
+            return vp.dot(decomp.solve(vp));
+        }
+    
+        Matrix
+        CovarianceSolver::
+        Solve(const Matrix & b, const Vector & diagonal) const {
+            switch (fStructure) {
+                case kBlockDiagonalStructure:
+                    return BlockSolve(b, diagonal, false);
+                case kSparseStructure: {
+                    SparseMatrix total_covariance = fSparseCovariance;
+                    Vector dp = fPermutation * diagonal;
+                    for (auto j = 0u; j < fSparseDiagonalIdx.size(); j++) {
+                        total_covariance.valuePtr()[fSparseDiagonalIdx[j]] += dp(j);
+                    }
+                    SparseLLT decomp(total_covariance);
+                    Matrix x = decomp.solve(fPermutation * b);
+                    return fPermutation.transpose() * x;
+                }
+                default:
+                    Matrix total_covariance = GetCovariance();
+                    total_covariance.diagonal() += diagonal;
+                    return Eigen::LLT<Matrix>(total_covariance).solve(b);
+            }
+        }
+
+        Matrix
+        CovarianceSolver::
+        Solve(const Matrix & b) const {
+            switch (fStructure) {
+                case kBlockDiagonalStructure:
+                    return BlockSolve(b, Vector(), true);
+                case kSparseStructure: {
+                    Matrix x = fSparseDecomp->solve(fPermutation * b);
+                    return fPermutation.transpose() * x;
+                }
+                default:
+                    if (fFactor) {
+                        Eigen::Map<const Matrix> L(fFactor, fNMappedBins, fNMappedBins);
+                        Matrix x = L.triangularView<Eigen::Lower>().solve(b);
+                        L.transpose().triangularView<Eigen::Upper>().solveInPlace(x);
+                        return x;
+                    }
+                    return fDecomp.solve(b);
+            }
+        }
+
+        Matrix
+        CovarianceSolver::
+        BlockSolve(const Matrix & b, const Vector & diagonal, bool cached) const {
+            Matrix x(b.rows(), b.cols());
+            if (!fDiagonalIdx.empty()) {
+                Vector variance = fDiagonalVariance;
+                if (!cached) variance += diagonal(fDiagonalIdx);
+                x(fDiagonalIdx, Eigen::all) = b(fDiagonalIdx, Eigen::all).array().colwise() / variance.array();
+            }
+
+            // blocks write to disjoint rows of x
+            auto solve_block = [&](std::size_t i) {
+                const auto & idx = fBlocks[fMultiBinBlocks[i]];
+                Matrix xb = b(idx, Eigen::all);
+                if (cached) {
+                    fBlockDecomps[i].solveInPlace(xb);
+                }
+                else {
+                    Matrix cb = fBlockCovariances[i];
+                    cb.diagonal() += diagonal(idx);
+                    Eigen::LLT<Matrix>(cb).solveInPlace(xb);
+                }
+                x(idx, Eigen::all) = xb;
+            };
+            if (fBlockWork * std::max<long>(1, b.cols()) >= kMinParallelBlockWork) {
+                parallel::For(fMultiBinBlocks.size(), solve_block);
+            }
+            else {
+                for (auto i = 0u; i < fMultiBinBlocks.size(); i++) solve_block(i);
+            }
+            return x;
+        }
+    }
+}
@@ -0,0 +1,240 @@
+#include "XSecAna/Fit/FitResultStore.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+
+namespace xsec {
+    namespace fit {
+        namespace {
+            const char kMagic[8] = {'X', 'S', 'F', 'I', 'T', 'R', 'E', 'S'};
+            const std::uint64_t kVersion = 1;
+
+            int DefaultRowsPerGroup(std::size_t row_width) {
+                return std::max<std::size_t>(1, FitResultWriter::kGroupBytes / (row_width * sizeof(double)));
+            }
+        }
+
+        FitResultWriter::
+        FitResultWriter(const std::string & path,
+                        int nparams,
+                        bool store_covariance,
+                        int rows_per_group)
+                : fFile(path, std::ios::binary | std::ios::trunc),
+                  fNParams(nparams),
+                  fStoreCovariance(store_covariance),
+                  fRowsPerGroup(rows_per_group) {
+            auto row_width = detail::FitResultRowWidth(nparams, store_covariance);
+            if (fRowsPerGroup <= 0) fRowsPerGroup = DefaultRowsPerGroup(row_width);
+            fGroup = Matrix::Zero(fRowsPerGroup, row_width);
+            if (!fFile) {
+                throw std::runtime_error("Unable to open " + path + " for writing");
+            }
+            detail::FitResultStoreHeader header;
+            header.signature = MappedFile::Signature(kMagic, kVersion);
+            header.nparams = nparams;
+            header.store_covariance = store_covariance;
+            header.rows_per_group = fRowsPerGroup;
+            header.nrows = 0;
+            fFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        }
+
+        FitResultWriter::
+        ~FitResultWriter() {
+            try {
+                Close();
+            }
+            catch (std::exception & e) {
+                std::cerr << "FitResultWriter: " << e.what() << std::endl;
+            }
+        }
+
+        void
+        FitResultWriter::
+        Append(const FitResult & result) {
+            if (!fFile.is_open()) {
+                throw std::runtime_error("FitResultWriter is closed");
+            }
+            if (result.params.size() != fNParams) {
+                throw std::runtime_error("FitResultWriter: expected " + std::to_string(fNParams) +
+                                         " parameters, got " + std::to_string(result.params.size()));
+            }
+            auto row = fGroup.row(fNGroupRows);
+            const auto n = fNParams;
+            row(0) = result.fun_val;
+            row(1) = result.fun_calls;
+            row(2) = result.is_valid;
+            row.segment(3, n) = result.params;
+            row.segment(3 + n, n) = result.params_error_up.size() == n ? Vector(result.params_error_up) : Vector::Zero(n);
+            row.segment(3 + 2 * n, n) = result.params_error_down.size() == n ? Vector(result.params_error_down) : Vector::Zero(n);
+            if (fStoreCovariance) {
+                bool has_covariance = result.covariance.rows() == n && result.covariance.cols() == n;
+                auto k = 3 + 3 * n;
+                for (auto i = 0; i < n; i++) {
+                    for (auto j = i; j < n; j++) {
+                        row(k++) = has_covariance ? result.covariance(i, j) : 0;
+                    }
+                }
+            }
+
+            if (++fNGroupRows == fRowsPerGroup) FlushGroup();
+        }
+
+        void
+        FitResultWriter::
+        FlushGroup() {
+            std::uint64_t group_rows = fNGroupRows;
+            fFile.write(reinterpret_cast<const char *>(&group_rows), sizeof(group_rows));
+            // only the filled rows of each column, so a partial last group isn't padded
+            for (auto icol = 0; icol < fGroup.cols(); icol++) {
+                fFile.write(reinterpret_cast<const char *>(fGroup.col(icol).data()),
+                            fNGroupRows * sizeof(double));
+            }
+            fNRows += fNGroupRows;
+            fNGroupRows = 0;
+            fGroup.setZero();
+
+            // keep the row count in the header current
+            auto end = fFile.tellp();
+            std::uint64_t nrows = fNRows;
+            fFile.seekp(offsetof(detail::FitResultStoreHeader, nrows));
+            fFile.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows));
+            fFile.seekp(end);
+            if (!fFile) {
+                throw std::runtime_error("FitResultWriter: write failed");
+            }
+        }
+
+        void
+        FitResultWriter::
+        Close() {
+            if (!fFile.is_open()) return;
+            if (fNGroupRows > 0) FlushGroup();
+            fFile.close();
+        }
+
+        FitResultReader::
+        FitResultReader(const std::string & path)
+                : fFile(path) {
+            fHeader = fFile.ReadHeader<detail::FitResultStoreHeader>(kMagic, {kVersion}, "fit result store");
+            fRowWidth = detail::FitResultRowWidth(fHeader.nparams, fHeader.store_covariance);
+            fGroupBytes = sizeof(std::uint64_t) + fHeader.rows_per_group * fRowWidth * sizeof(double);
+
+            auto ngroups = (fHeader.nrows + fHeader.rows_per_group - 1) / fHeader.rows_per_group;
+            std::size_t bytes = sizeof(fHeader);
+            if (ngroups > 0) {
+                bytes += (ngroups - 1) * fGroupBytes + sizeof(std::uint64_t) +
+                         GroupRows(ngroups - 1) * fRowWidth * sizeof(double);
+            }
+            if (fFile.size() < bytes) {
+                throw std::runtime_error(path + " is truncated");
+            }
+        }
+
+        int
+        FitResultReader::
+        CovarianceIndex(int i, int j, int nparams) {
+            if (i > j) std::swap(i, j);
+            // rows before i hold nparams + (nparams - 1) + ... + (nparams - i + 1) elements
+            return i * nparams - i * (i - 1) / 2 + (j - i);
+        }
+
+        std::size_t
+        FitResultReader::
+        ColumnOffset(FitResultColumn_t column, int index) const {
+            const std::size_t n = fHeader.nparams;
+            auto check_index = [&](std::size_t size) {
+                if (index < 0 || (std::size_t) index >= size) {
+                    throw std::out_of_range("Fit result store column index " + std::to_string(index) +
+                                            " out of range");
+                }
+                return (std::size_t) index;
+            };
+            switch (column) {
+                case kFunValColumn:
+                    return 0;
+                case kFunCallsColumn:
+                    return 1;
+                case kIsValidColumn:
+                    return 2;
+                case kParamsColumn:
+                    return 3 + check_index(n);
+                case kParamsErrorUpColumn:
+                    return 3 + n + check_index(n);
+                case kParamsErrorDownColumn:
+                    return 3 + 2 * n + check_index(n);
+                case kCovarianceColumn:
+                    if (!fHeader.store_covariance) {
+                        throw std::runtime_error("This fit result store has no covariance");
+                    }
+                    return 3 + 3 * n + check_index(n * (n + 1) / 2);
+            }
+            throw std::runtime_error("Unknown fit result column");
+        }
+
+        const double *
+        FitResultReader::
+        Group(std::size_t igroup) const {
+            return fFile.as<double>(sizeof(fHeader) + igroup * fGroupBytes + sizeof(std::uint64_t));
+        }
+
+        std::size_t
+        FitResultReader::
+        GroupRows(std::size_t igroup) const {
+            return std::min<std::size_t>(fHeader.rows_per_group,
+                                         fHeader.nrows - igroup * fHeader.rows_per_group);
+        }
+
+        Array
+        FitResultReader::
+        Column(FitResultColumn_t column, int index) const {
+            auto icolumn = ColumnOffset(column, index);
+            Array values(fHeader.nrows);
+            std::size_t filled = 0;
+            for (auto igroup = 0u; filled < fHeader.nrows; igroup++) {
+                auto nrows = GroupRows(igroup);
+                values.segment(filled, nrows) = Eigen::Map<const Array>(Group(igroup) + icolumn * nrows,
+                                                                        nrows);
+                filled += nrows;
+            }
+            return values;
+        }
+
+        FitResult
+        FitResultReader::
+        GetRow(std::size_t row) const {
+            if (row >= fHeader.nrows) {
+                throw std::out_of_range("Fit result store row " + std::to_string(row) + " out of range");
+            }
+            const std::size_t igroup = row / fHeader.rows_per_group;
+            const std::size_t stride = GroupRows(igroup);
+            const double * values = Group(igroup) + row % fHeader.rows_per_group;
+            auto value = [&](std::size_t icolumn) { return values[icolumn * stride]; };
+
+            const int n = fHeader.nparams;
+            FitResult result;
+            result.fun_val = value(0);
+            result.fun_calls = value(1);
+            result.is_valid = value(2);
+            result.params.resize(n);
+            result.params_error_up.resize(n);
+            result.params_error_down.resize(n);
+            for (auto i = 0; i < n; i++) {
+                result.params(i) = value(3 + i);
+                result.params_error_up(i) = value(3 + n + i);
+                result.params_error_down(i) = value(3 + 2 * n + i);
+            }
+            if (fHeader.store_covariance) {
+                result.covariance.resize(n, n);
+                auto k = 3 + 3 * n;
+                for (auto i = 0; i < n; i++) {
+                    for (auto j = i; j < n; j++) {
+                        result.covariance(i, j) = result.covariance(j, i) = value(k++);
+                    }
+                }
+            }
+            return result;
+        }
+    }
+}
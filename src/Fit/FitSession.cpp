@@ -0,0 +1,57 @@
+#include "XSecAna/Fit/FitSession.h"
+
+namespace xsec {
+    namespace fit {
+        FitSession::
+        FitSession(const TemplateFitCalculator * fit_calc,
+                   const IFitter * fitter)
+                : fFitCalc(fit_calc->Clone()),
+                  fFitter(fitter ? fitter->Clone() : nullptr)
+        {}
+
+        FitSession::
+        FitSession(const FitSession & other)
+                : fFitCalc(other.fFitCalc->Clone()),
+                  fFitter(other.fFitter ? other.fFitter->Clone() : nullptr),
+                  fUseWarmStart(other.fUseWarmStart),
+                  fWarmStartParams(other.fWarmStartParams),
+                  fWarmStartCovariance(other.fWarmStartCovariance)
+        {}
+
+        FitSession &
+        FitSession::
+        operator=(const FitSession & other) {
+            if (this != &other) {
+                fFitCalc.reset(other.fFitCalc->Clone());
+                fFitter.reset(other.fFitter ? other.fFitter->Clone() : nullptr);
+                fUseWarmStart = other.fUseWarmStart;
+                fWarmStartParams = other.fWarmStartParams;
+                fWarmStartCovariance = other.fWarmStartCovariance;
+            }
+            return *this;
+        }
+
+        void
+        FitSession::
+        SetFitter(const IFitter * fitter) {
+            fFitter.reset(fitter ? fitter->Clone() : nullptr);
+        }
+
+        FitResult
+        FitSession::
+        Fit(const Vector & data, const std::vector<Vector> & seeds) {
+            if (!fFitter) {
+                throw std::runtime_error("This FitSession does not have an IFitter");
+            }
+            if (fUseWarmStart && fWarmStartParams.size() == fFitCalc->GetNMinimizerParams()) {
+                fFitter->WarmStart(fWarmStartParams, fWarmStartCovariance);
+            }
+            auto result = fFitter->Fit(fFitCalc.get(), data, seeds);
+            if (fUseWarmStart) {
+                fWarmStartParams = fFitCalc->ToMinimizerParams(result.params);
+                fWarmStartCovariance = fFitCalc->ToMinimizerCovariance(result.covariance);
+            }
+            return result;
+        }
+    }
+}
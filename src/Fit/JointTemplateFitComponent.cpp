@@ -2,120 +2,140 @@
 #include "XSecAna/Fit/JointTemplateFitComponent.h"
 #include "XSecAna/Utils.h"
 #include "XSecAna/Systematic.h"
+#include "XSecAna/MultiverseMatrix.h"
 
+#include <algorithm>
 #include <functional>
 
 namespace xsec {
     namespace fit {
         namespace detail {
-            std::shared_ptr<TH1>
-            _join(const std::shared_ptr<TH1> lhs,
-                  const std::shared_ptr<TH1> rhs) {
-                std::shared_ptr<TH1> ret;
-                if (lhs->GetDimension() == 1) {
-                    int njoined = lhs->GetNbinsX() + rhs->GetNbinsX();
-                    ret = std::make_shared<TH1D>("", "",
-                                                 njoined, 0, njoined);
-                    for (int x = 1; x <= lhs->GetNbinsX(); x++) {
-                        ret->SetBinContent(x, lhs->GetBinContent(x));
-                        ret->SetBinError(x, lhs->GetBinError(x));
-                    }
-                    for (int x = 1; x <= rhs->GetNbinsX(); x++) {
-                        ret->SetBinContent(x + lhs->GetNbinsX(), rhs->GetBinContent(x));
-                        ret->SetBinError(x + lhs->GetNbinsX(), rhs->GetBinError(x));
-                    }
-                } else if (lhs->GetDimension() == 2) {
-                    int njoined = lhs->GetNbinsY() + rhs->GetNbinsY();
-                    if (lhs->GetXaxis()->IsVariableBinSize()) {
-                        std::vector<double> ybins(njoined + 1);
-                        for (int i = 0; i < njoined + 1; i++) ybins[i] = i;
-                        ret = std::make_shared<TH2D>("", "",
-                                                     lhs->GetXaxis()->GetNbins(),
-                                                     lhs->GetXaxis()->GetXbins()->GetArray(),
-                                                     njoined,
-                                                     &ybins[0]);
-                    } else {
-                        ret = std::make_shared<TH2D>("", "",
-                                                     lhs->GetNbinsX(),
-                                                     lhs->GetXaxis()->GetBinLowEdge(1),
-                                                     lhs->GetXaxis()->GetBinLowEdge(lhs->GetNbinsX() + 1),
-                                                     njoined,
-                                                     0,
-                                                     njoined);
-                    }
-                    ret->GetXaxis()->SetTitle(lhs->GetXaxis()->GetTitle());
-                    ret->GetYaxis()->SetTitle("Joined Template Bins");
-                    for (auto x = 1; x <= lhs->GetNbinsX(); x++) {
-                        for (auto y = 1; y <= lhs->GetNbinsY(); y++) {
-                            ret->SetBinContent(x,
-                                               y,
-                                               lhs->GetBinContent(x, y));
-                            ret->SetBinError(x,
-                                             y,
-                                             lhs->GetBinError(x, y));
-                        }
-                        for (auto y = 1; y <= rhs->GetNbinsY(); y++) {
-                            ret->SetBinContent(x,
-                                               y + lhs->GetNbinsY(),
-                                               rhs->GetBinContent(x, y));
-                            ret->SetBinError(x,
-                                             y + lhs->GetNbinsY(),
-                                             rhs->GetBinError(x, y));
+            namespace {
+                ///\brief Number of bins along the axis samples are joined on,
+                /// the last axis of the histogram
+                int _njoin_axis_bins(const TH1 * h) {
+                    if (h->GetDimension() == 1) return h->GetNbinsX();
+                    else if (h->GetDimension() == 2) return h->GetNbinsY();
+                    else return h->GetNbinsZ();
+                }
+
+                ///\brief Empty histogram with the leading axes of like and njoined bins on the last axis
+                std::shared_ptr<TH1> _joined_binning(const TH1 * like, int njoined) {
+                    std::shared_ptr<TH1> ret;
+                    if (like->GetDimension() == 1) {
+                        ret = std::make_shared<TH1D>("", "",
+                                                     njoined, 0, njoined);
+                    } else if (like->GetDimension() == 2) {
+                        if (like->GetXaxis()->IsVariableBinSize()) {
+                            std::vector<double> ybins(njoined + 1);
+                            for (int i = 0; i < njoined + 1; i++) ybins[i] = i;
+                            ret = std::make_shared<TH2D>("", "",
+                                                         like->GetXaxis()->GetNbins(),
+                                                         like->GetXaxis()->GetXbins()->GetArray(),
+                                                         njoined,
+                                                         &ybins[0]);
+                        } else {
+                            ret = std::make_shared<TH2D>("", "",
+                                                         like->GetNbinsX(),
+                                                         like->GetXaxis()->GetBinLowEdge(1),
+                                                         like->GetXaxis()->GetBinLowEdge(like->GetNbinsX() + 1),
+                                                         njoined,
+                                                         0,
+                                                         njoined);
                         }
-                    }
-                } else {
-                    int njoined = lhs->GetNbinsZ() + rhs->GetNbinsZ();
-                    if (lhs->GetXaxis()->IsVariableBinSize() ||
-                        lhs->GetYaxis()->IsVariableBinSize()) {
-                        std::vector<double> zbins(njoined + 1);
-                        for (int i = 0; i < njoined + 1; i++) zbins[i] = i;
-                        ret = std::make_shared<TH3D>("", "",
-                                                     lhs->GetNbinsX(),
-                                                     lhs->GetXaxis()->GetXbins()->GetArray(),
-                                                     lhs->GetNbinsY(),
-                                                     lhs->GetYaxis()->GetXbins()->GetArray(),
-                                                     njoined,
-                                                     &zbins[0]);
+                        ret->GetXaxis()->SetTitle(like->GetXaxis()->GetTitle());
+                        ret->GetYaxis()->SetTitle("Joined Template Bins");
                     } else {
-                        ret = std::make_shared<TH3D>("", "",
-                                                     lhs->GetNbinsX(),
-                                                     lhs->GetXaxis()->GetBinLowEdge(1),
-                                                     lhs->GetXaxis()->GetBinLowEdge(lhs->GetNbinsX() + 1),
-                                                     lhs->GetNbinsY(),
-                                                     lhs->GetYaxis()->GetBinLowEdge(1),
-                                                     lhs->GetYaxis()->GetBinLowEdge(lhs->GetNbinsY() + 1),
-                                                     njoined,
-                                                     0,
-                                                     njoined);
-                    }
-                    for (int x = 1; x <= lhs->GetNbinsX(); x++) {
-                        for (int y = 1; y <= lhs->GetNbinsY(); y++) {
-                            for (auto z = 1; z <= lhs->GetNbinsZ(); z++) {
-                                ret->SetBinContent(x,
-                                                   y,
-                                                   z,
-                                                   lhs->GetBinContent(x, y, z));
-                                ret->SetBinError(x,
-                                                 y,
-                                                 z,
-                                                 lhs->GetBinError(x, y, z));
-                            }
-                            for (auto z = 1; z <= rhs->GetNbinsZ(); z++) {
-                                ret->SetBinContent(x,
-                                                   y,
-                                                   z + rhs->GetNbinsZ(),
-                                                   rhs->GetBinContent(x, y, z));
-                                ret->SetBinError(x,
-                                                 y,
-                                                 z + rhs->GetNbinsZ(),
-                                                 rhs->GetBinError(x, y, z));
-                            }
+                        if (like->GetXaxis()->IsVariableBinSize() ||
+                            like->GetYaxis()->IsVariableBinSize()) {
+                            std::vector<double> zbins(njoined + 1);
+                            for (int i = 0; i < njoined + 1; i++) zbins[i] = i;
+                            ret = std::make_shared<TH3D>("", "",
+                                                         like->GetNbinsX(),
+                                                         like->GetXaxis()->GetXbins()->GetArray(),
+                                                         like->GetNbinsY(),
+                                                         like->GetYaxis()->GetXbins()->GetArray(),
+                                                         njoined,
+                                                         &zbins[0]);
+                        } else {
+                            ret = std::make_shared<TH3D>("", "",
+                                                         like->GetNbinsX(),
+                                                         like->GetXaxis()->GetBinLowEdge(1),
+                                                         like->GetXaxis()->GetBinLowEdge(like->GetNbinsX() + 1),
+                                                         like->GetNbinsY(),
+                                                         like->GetYaxis()->GetBinLowEdge(1),
+                                                         like->GetYaxis()->GetBinLowEdge(like->GetNbinsY() + 1),
+                                                         njoined,
+                                                         0,
+                                                         njoined);
                         }
+                        ret->GetXaxis()->SetTitle(like->GetXaxis()->GetTitle());
+                        ret->GetYaxis()->SetTitle(like->GetYaxis()->GetTitle());
+                        ret->GetZaxis()->SetTitle("Joined Template Bins");
+                    }
+                    // joint components are reduced on parallel::For workers
+                    ret->SetDirectory(nullptr);
+                    return ret;
+                }
+
+                ///\brief Concatenate blocks of rows of per-sample arrays along the joined axis.
+                // ROOT orders global bins with the last axis slowest, so the bins of one
+                // last-axis slice are contiguous and each sample is a single block of rows
+                // (excluding its under/overflow slices). Under/overflow of the result are zero.
+                Matrix _join_rows(const std::vector<const Matrix *> & blocks,
+                                  const std::vector<int> & njoin_axis_bins,
+                                  int slice_size) {
+                    int njoined = 0;
+                    for (auto n : njoin_axis_bins) njoined += n;
+                    Matrix ret = Matrix::Zero(slice_size * (njoined + 2), blocks[0]->cols());
+                    int row = slice_size;
+                    for (auto i = 0u; i < blocks.size(); i++) {
+                        auto nrows = slice_size * njoin_axis_bins[i];
+                        ret.middleRows(row, nrows) = blocks[i]->middleRows(slice_size, nrows);
+                        row += nrows;
                     }
-                    ret->GetXaxis()->SetTitle(lhs->GetXaxis()->GetTitle());
-                    ret->GetYaxis()->SetTitle(lhs->GetYaxis()->GetTitle());
-                    ret->GetZaxis()->SetTitle("Joined Template Bins");
+                    return ret;
+                }
+            }
+
+            std::shared_ptr<TH1>
+            _join(const std::shared_ptr<TH1> lhs,
+                  const std::shared_ptr<TH1> rhs) {
+                return _join(std::vector<std::shared_ptr<TH1>>{lhs, rhs});
+            }
+
+            std::shared_ptr<TH1>
+            _join(const std::vector<std::shared_ptr<TH1>> & samples) {
+                if (samples.size() == 1) {
+                    auto ret = std::shared_ptr<TH1>((TH1 *) samples[0]->Clone());
+                    ret->SetDirectory(nullptr);
+                    return ret;
                 }
+
+                std::vector<int> nbins;
+                std::vector<Matrix> contents;
+                std::vector<Matrix> errors;
+                int njoined = 0;
+                for (const auto & sample : samples) {
+                    nbins.push_back(_njoin_axis_bins(sample.get()));
+                    contents.push_back(root::MapContentsToEigen(sample.get()).matrix());
+                    errors.push_back(root::MapErrorsToEigen(sample.get()).matrix());
+                    njoined += nbins.back();
+                }
+                const int slice_size = contents[0].size() / (nbins[0] + 2);
+
+                std::vector<const Matrix *> content_blocks;
+                std::vector<const Matrix *> error_blocks;
+                for (auto i = 0u; i < samples.size(); i++) {
+                    content_blocks.push_back(&contents[i]);
+                    error_blocks.push_back(&errors[i]);
+                }
+
+                auto ret = _joined_binning(samples[0].get(), njoined);
+                Matrix joined_contents = _join_rows(content_blocks, nbins, slice_size);
+                Matrix joined_errors = _join_rows(error_blocks, nbins, slice_size);
+                ret->SetContent(joined_contents.data());
+                ret->SetError(joined_errors.data());
                 return ret;
             }
 
@@ -150,32 +170,49 @@ namespace xsec {
             Systematic<TH1>
             _join(const Systematic<TH1> & lhs,
                   const Systematic<TH1> & rhs) {
-                std::vector<std::shared_ptr<TH1>> joined;
-                for (auto i = 0u; i < lhs.GetShifts().size(); i++) {
-                    joined.push_back(_join(lhs.GetShifts()[i], rhs.GetShifts()[i]));
-                }
-                return Systematic<TH1>(lhs.GetName(), joined, lhs.GetType());
+                return _join(std::vector<Systematic<TH1>>{lhs, rhs});
             }
 
-            std::shared_ptr<TH1>
-            _join(const std::vector<std::shared_ptr<TH1>> & samples) {
-                std::shared_ptr<TH1> ret = nullptr;
-                for (auto sample: samples) {
-                    if (!ret) ret = std::shared_ptr<TH1>((TH1 *) sample->Clone());
-                    else {
-                        ret = _join(ret, sample);
+            Systematic<TH1>
+            _join(const std::vector<Systematic<TH1>> & samples) {
+                if (samples.size() == 1) return samples[0];
+
+                bool matrix_backed = true;
+                bool keep_errors = true;
+                for (const auto & sample : samples) {
+                    matrix_backed &= (bool) sample.GetUniverseMatrix();
+                    keep_errors &= matrix_backed && sample.GetUniverseMatrix()->HasErrors();
+                }
+
+                if (matrix_backed) {
+                    // join every universe at once without making histograms
+                    std::vector<int> nbins;
+                    std::vector<const Matrix *> universes;
+                    std::vector<const Matrix *> errors;
+                    int njoined = 0;
+                    for (const auto & sample : samples) {
+                        const auto & matrix = *sample.GetUniverseMatrix();
+                        nbins.push_back(_njoin_axis_bins(matrix.GetBinning()));
+                        universes.push_back(&matrix.GetMatrix());
+                        errors.push_back(&matrix.GetErrors());
+                        njoined += nbins.back();
                     }
+                    const int slice_size = universes[0]->rows() / (nbins[0] + 2);
+                    auto binning = _joined_binning(samples[0].GetUniverseMatrix()->GetBinning(), njoined);
+                    return Systematic<TH1>(samples[0].GetName(),
+                                           std::make_shared<const MultiverseMatrix>(
+                                                   binning.get(),
+                                                   _join_rows(universes, nbins, slice_size),
+                                                   keep_errors ? _join_rows(errors, nbins, slice_size) : Matrix()));
                 }
-                return ret;
-            }
 
-            Systematic<TH1>
-            _join(const std::vector<Systematic<TH1>> & samples) {
-                auto ret = samples[0];
-                for (auto i = 1u; i < samples.size(); i++) {
-                    ret = _join(ret, samples[i]);
+                std::vector<std::shared_ptr<TH1>> joined(samples[0].GetShifts().size());
+                for (auto i = 0u; i < joined.size(); i++) {
+                    std::vector<std::shared_ptr<TH1>> shifts;
+                    for (const auto & sample : samples) shifts.push_back(sample.GetShifts()[i]);
+                    joined[i] = _join(shifts);
                 }
-                return ret;
+                return Systematic<TH1>(samples[0].GetName(), joined, samples[0].GetType());
             }
         }
 
@@ -345,12 +382,12 @@ namespace xsec {
             }
 
             fConditioningSampleLabel = conditioning_sample_label;
-            for(auto sample : fSamples) {
+            for(const auto & sample : fSamples) {
                 if(sample.first != fConditioningSampleLabel) {
-                    fComplimentarySampleLabel = sample.first;
-                    break;
+                    fComplimentarySampleLabels.push_back(sample.first);
                 }
             }
+            fComplimentarySampleLabel = fComplimentarySampleLabels.front();
         }
 
         IReducedTemplateComponent *
@@ -426,20 +463,27 @@ namespace xsec {
                   fSampleNormalizationsForErrorCalc(sample_norm_means_for_error_calc),
                   fJointNormSystematics(joint_norm_systematics),
                   fNOuterBins(joined_template_mean->GetNOuterBins()) {
-            assert(sample_norm_means.size() == 2 && "Implementation only supports 2 sample joint fits");
+            assert(sample_norm_means.size() >= 2 && "Joint fits need at least two samples");
             fConditioningSampleLabel = conditioning_sample_label;
+            // samples are joined in map order, both in the normalization bins
+            // and in the inner bins of each outer bin of the joined templates
             int idx = 0;
-            // some ineligant book keeping.
-            // Samples would be better contained in a vector
+            int inner_offset = 0;
             for(const auto & s : samples) {
-                if(s.first != fConditioningSampleLabel) {
-                    fComplimentarySampleLabel = s.first;
-                    fComplimentarySampleIdx = idx;
-                    break;
+                if(s.first == fConditioningSampleLabel) {
+                    fConditioningSampleIdx = idx;
+                    fConditioningInnerOffset = inner_offset;
+                }
+                else {
+                    fComplimentarySampleLabels.push_back(s.first);
+                    fComplimentarySampleIdx.push_back(idx);
+                    fComplimentaryInnerOffsets.push_back(inner_offset);
+                    fComplimentarySamples.push_back(s.second);
                 }
+                inner_offset += s.second->GetNominal()->GetNInnerBins();
                 idx++;
             }
-            fConditioningSampleIdx = 1 - fComplimentarySampleIdx;
+            fComplimentarySampleLabel = fComplimentarySampleLabels.front();
 
             for(const auto & syst : samples.begin()->second->GetSystematics()) {
                 std::vector<Systematic<TH1>> vsysts;
@@ -454,6 +498,7 @@ namespace xsec {
                 fJoinedNormCovariances[syst.first] = syst.second.CovarianceMatrix(fJointNormalizationForErrorCalc.get());
                 if (!fJoinedNormTotalCovariance) {
                     fJoinedNormTotalCovariance = (TH1 *) fJoinedNormCovariances.at(syst.first)->Clone();
+                    fJoinedNormTotalCovariance->SetDirectory(nullptr);
                 } else {
                     fJoinedNormTotalCovariance->Add(fJoinedNormCovariances.at(syst.first));
                 }
@@ -476,52 +521,87 @@ namespace xsec {
             fConditioningSampleNormalization = root::MapContentsToEigenInner(fSampleNormalizations.at(fConditioningSampleLabel).get());
             fConditioningSample = samples.at(fConditioningSampleLabel);
 
-            fComplimentarySampleNormalization = root::MapContentsToEigenInner(fSampleNormalizations.at(fComplimentarySampleLabel).get());
-            fComplimentarySample = samples.at(fComplimentarySampleLabel);
+            const int ncomp = fComplimentarySampleLabels.size();
+            fComplimentarySampleNormalization.resize(ncomp * fNOuterBins);
+            for(auto i = 0; i < ncomp; i++) {
+                fComplimentarySampleNormalization.segment(i * fNOuterBins, fNOuterBins) =
+                        root::MapContentsToEigenInner(fSampleNormalizations.at(fComplimentarySampleLabels[i]).get()).matrix();
+            }
 
             if(_is_singular()) {
                 // If covariance matrix is singular, treat samples as 100% correlated
-                // We can do this by fudging the covariance matrices
+                // so each complimentary sample scales with the conditioning sample
                 Array inverse = 1. / fConditioningSampleNormalization;
                 // replace infinities with 0
                 inverse = (fConditioningSampleNormalization == 0).select(0, inverse);
-                fConditioningSampleInvCovariance = inverse.matrix().asDiagonal();
-                fCrossSampleCovariance = fComplimentarySampleNormalization.asDiagonal();
-
-                fPredictionCovariance = Matrix::Zero(fCrossSampleCovariance.rows(),
-                                                     fCrossSampleCovariance.cols());
+                fCrossSampleCovariance = Matrix::Zero(ncomp * fNOuterBins, fNOuterBins);
+                fRotationMatrix = Matrix::Zero(ncomp * fNOuterBins, fNOuterBins);
+                for(auto i = 0; i < ncomp; i++) {
+                    auto comp_norm = fComplimentarySampleNormalization.segment(i * fNOuterBins, fNOuterBins);
+                    fCrossSampleCovariance.middleRows(i * fNOuterBins, fNOuterBins) = comp_norm.asDiagonal();
+                    fRotationMatrix.middleRows(i * fNOuterBins, fNOuterBins) =
+                            (comp_norm.array() * inverse).matrix().asDiagonal();
+                }
+                fPredictionCovariance = Matrix::Zero(ncomp * fNOuterBins, ncomp * fNOuterBins);
             }
             else {
                 Matrix total_covariance = root::MapContentsToEigenInner(fJoinedNormTotalCovariance)
                     .reshaped(fJoinedNormTotalCovariance->GetNbinsX(),
                               fJoinedNormTotalCovariance->GetNbinsX());
+                auto block = [&](int row_sample, int col_sample) {
+                    return total_covariance.block(row_sample * fNOuterBins, col_sample * fNOuterBins,
+                                                  fNOuterBins, fNOuterBins);
+                };
+
+                // Conditional distribution of the complimentary samples given the conditioning sample.
+                // Only the conditioning block is factorized and the cross blocks are solved against it,
+                // so the cost grows with the number of samples instead of the joint dimension cubed
+                //   R = V_cd V_dd^-1,  V_pred = V_cc - V_cd V_dd^-1 V_dc
+                Eigen::LDLT<Matrix> conditioning_decomposition(block(fConditioningSampleIdx, fConditioningSampleIdx));
+                if (conditioning_decomposition.info() != Eigen::Success) {
+                    throw std::runtime_error("ReducedJointTemplateComponent: unable to factorize the covariance of " +
+                                             fConditioningSampleLabel);
+                }
+                fCrossSampleCovariance.resize(ncomp * fNOuterBins, fNOuterBins);
+                for(auto i = 0; i < ncomp; i++) {
+                    fCrossSampleCovariance.middleRows(i * fNOuterBins, fNOuterBins) =
+                            block(fComplimentarySampleIdx[i], fConditioningSampleIdx);
+                }
+                // V_dd^-1 V_dc
+                Matrix solved_cross = conditioning_decomposition.solve(fCrossSampleCovariance.transpose());
+                fRotationMatrix = solved_cross.transpose();
+
+                fPredictionCovariance.resize(ncomp * fNOuterBins, ncomp * fNOuterBins);
+                for(auto i = 0; i < ncomp; i++) {
+                    for(auto j = 0; j < ncomp; j++) {
+                        fPredictionCovariance.block(i * fNOuterBins, j * fNOuterBins, fNOuterBins, fNOuterBins) =
+                                block(fComplimentarySampleIdx[i], fComplimentarySampleIdx[j]) -
+                                fCrossSampleCovariance.middleRows(i * fNOuterBins, fNOuterBins) *
+                                solved_cross.middleCols(j * fNOuterBins, fNOuterBins);
+                    }
+                }
+            }
+
+            for(auto i = 0; i < ncomp; i++) {
+                fRotationDecompositions.emplace_back(fRotationMatrix.middleRows(i * fNOuterBins, fNOuterBins));
+            }
 
-                fConditioningSampleInvCovariance =
-                        total_covariance.block(fConditioningSampleIdx * fNOuterBins,
-                                               fConditioningSampleIdx * fNOuterBins,
-                                               fNOuterBins,
-                                               fNOuterBins).inverse();
-                fCrossSampleCovariance =
-                        total_covariance.block(fComplimentarySampleIdx * fNOuterBins,
-                                               fConditioningSampleIdx * fNOuterBins,
-                                               fNOuterBins,
-                                               fNOuterBins);
-
-                Matrix complimentary_block = total_covariance.block(fComplimentarySampleIdx * fNOuterBins,
-                                                                    fComplimentarySampleIdx * fNOuterBins,
-                                                                    fNOuterBins,
-                                                                    fNOuterBins);
-                Matrix off_diag_block = total_covariance.block(fConditioningSampleIdx * fNOuterBins, // 0
-                                                               fComplimentarySampleIdx * fNOuterBins, //fNOuterBins,
-                                                               fNOuterBins,
-                                                               fNOuterBins);
-                fPredictionCovariance = complimentary_block -
-                                        fCrossSampleCovariance *
-                                        fConditioningSampleInvCovariance *
-                                        off_diag_block;
-            }
-
-            fRotationMatrix = fCrossSampleCovariance * fConditioningSampleInvCovariance;
+            Array comp_norm = fComplimentarySampleNormalization.array();
+            Array inv_comp_norm = (comp_norm == 0).select(0, 1. / comp_norm);
+            fComplimentaryOffset = (inv_comp_norm *
+                                    (comp_norm - (fRotationMatrix * fConditioningSampleNormalization.matrix()).array())
+                                   ).matrix();
+            fComplimentaryResponse = inv_comp_norm.matrix().asDiagonal() *
+                                     fRotationMatrix *
+                                     fConditioningSampleNormalization.matrix().asDiagonal();
+
+            if (dynamic_cast<const ReducedTemplateComponent *>(fConditioningSample)) {
+                fConditioningTemplates = fConditioningSample->GetNominal();
+            }
+            for (const auto * sample : fComplimentarySamples) {
+                fComplimentaryTemplates.push_back(dynamic_cast<const ReducedTemplateComponent *>(sample) ?
+                                                  sample->GetNominal() : nullptr);
+            }
         }
 
         TH1 *
@@ -538,75 +618,103 @@ namespace xsec {
         bool
         ReducedJointTemplateComponent::
         _is_singular() {
-            fIsSingular = false;
-            for(int i = 0; i < fComplimentarySampleNormalization.size(); i++) {
-                if(fComplimentarySampleNormalization(i) == 0) fIsSingular = true;
-                if(fConditioningSampleNormalization(i) == 0) fIsSingular = true;
-            }
+            fIsSingular = (fComplimentarySampleNormalization.array() == 0).any() ||
+                          (fConditioningSampleNormalization == 0).any();
             return fIsSingular;
         }
 
+        int
+        ReducedJointTemplateComponent::
+        _complimentary_sample_position(const std::string & sample_label) const {
+            auto it = std::find(fComplimentarySampleLabels.begin(), fComplimentarySampleLabels.end(), sample_label);
+            if (it == fComplimentarySampleLabels.end()) {
+                throw std::runtime_error(sample_label + " is not a complimentary sample of this joint component");
+            }
+            return it - fComplimentarySampleLabels.begin();
+        }
+
         Vector
         ReducedJointTemplateComponent::
         ComplimentaryParams(const Vector & conditioning_params) const {
-            auto rescaled_condi_sample = fConditioningSampleNormalization * conditioning_params.array();
-            Array rescaled_comp_sample =
-                    fComplimentarySampleNormalization +
-                    fCrossSampleCovariance * fConditioningSampleInvCovariance *
-                    (rescaled_condi_sample - fConditioningSampleNormalization).matrix();
-            Array complimentary_params = rescaled_comp_sample / fComplimentarySampleNormalization.array();
-            complimentary_params = (fComplimentarySampleNormalization.array() == 0).select(0, complimentary_params);
-            //complimentary_params = (complimentary_params.array() < 0).select(0, complimentary_params);
-            return complimentary_params;
+            return fComplimentaryOffset + fComplimentaryResponse * conditioning_params;
+        }
+
+        Vector
+        ReducedJointTemplateComponent::
+        ComplimentaryParams(const Vector & conditioning_params, const std::string & sample_label) const {
+            auto rows = Eigen::seqN(_complimentary_sample_position(sample_label) * fNOuterBins, fNOuterBins);
+            return fComplimentaryOffset(rows) + fComplimentaryResponse(rows, Eigen::all) * conditioning_params;
         }
 
         Vector
         ReducedJointTemplateComponent::
         ConditionalParams(const Vector & complimentary_params) const {
-            Array complimentary_diff = fComplimentarySampleNormalization.array() *
-                                       complimentary_params.array() -
-                                       fComplimentarySampleNormalization.array();
-            Vector conditional_diff = fRotationMatrix.completeOrthogonalDecomposition().solve(complimentary_diff.matrix());
+            return ConditionalParams(complimentary_params, fComplimentarySampleLabel);
+        }
+
+        Vector
+        ReducedJointTemplateComponent::
+        ConditionalParams(const Vector & complimentary_params, const std::string & sample_label) const {
+            auto pos = _complimentary_sample_position(sample_label);
+            auto comp_norm = fComplimentarySampleNormalization.segment(pos * fNOuterBins, fNOuterBins).array();
+            Array complimentary_diff = comp_norm * complimentary_params.array() - comp_norm;
+            Vector conditional_diff = fRotationDecompositions[pos].solve(complimentary_diff.matrix());
             Array rescaled_condi_sample = (conditional_diff.array() + fConditioningSampleNormalization);
             Array conditioning_params = rescaled_condi_sample.array() / fConditioningSampleNormalization;
             return (fConditioningSampleNormalization.array() == 0).select(0, conditioning_params);
         }
-        
+
+        void
+        ReducedJointTemplateComponent::
+        _add_sample_prediction(const IReducedTemplateComponent * sample,
+                               const ReducedComponent * linear_templates,
+                               const Vector & params,
+                               int offset,
+                               Eigen::Ref<Vector> prediction) const {
+            auto ninner = sample->GetNominal()->GetNInnerBins();
+            auto joint = prediction.reshaped(fJointTemplateMean->GetNInnerBins(), fNOuterBins)
+                    .middleRows(offset, ninner);
+            if (linear_templates) {
+                joint += linear_templates->GetArray().reshaped(ninner, fNOuterBins) * params.asDiagonal();
+            } else {
+                joint += sample->Predict(params).reshaped(ninner, fNOuterBins);
+            }
+        }
+
+        void
+        ReducedJointTemplateComponent::
+        PredictAdd(const Vector & condi_params, Eigen::Ref<Vector> prediction) const {
+            // sample predictions are written straight into their rows of the joint template
+            Vector comp_params = this->ComplimentaryParams(condi_params);
+            _add_sample_prediction(fConditioningSample, fConditioningTemplates, condi_params,
+                                   fConditioningInnerOffset, prediction);
+            for (auto i = 0u; i < fComplimentarySamples.size(); i++) {
+                _add_sample_prediction(fComplimentarySamples[i], fComplimentaryTemplates[i],
+                                       comp_params.segment(i * fNOuterBins, fNOuterBins),
+                                       fComplimentaryInnerOffsets[i], prediction);
+            }
+        }
 
         Vector
         ReducedJointTemplateComponent::
         Predict(const Vector & condi_params) const {
-            Vector comp_params = this->ComplimentaryParams(condi_params);
-            Matrix condi_prediction = fConditioningSample->Predict(condi_params)
-                    .reshaped(fConditioningSample->GetNominal()->GetNInnerBins(), fNOuterBins);
-            Matrix comp_prediction = fComplimentarySample->Predict(comp_params)
-                    .reshaped(fComplimentarySample->GetNominal()->GetNInnerBins(), fNOuterBins);
-
-            Matrix joint_prediction(condi_prediction.rows() + comp_prediction.rows(),
-                                    fNOuterBins);
-            joint_prediction.block(fConditioningSampleIdx * comp_prediction.rows(),
-                                   0,
-                                   condi_prediction.rows(), fNOuterBins) = condi_prediction;
-            joint_prediction.block(fComplimentarySampleIdx * condi_prediction.rows(),
-                                   0,
-                                   comp_prediction.rows(), fNOuterBins) = comp_prediction;
-            //joint_prediction << condi_prediction, comp_prediction;
-            return joint_prediction.reshaped();
+            Vector joint_prediction = Vector::Zero(fJointTemplateMean->GetNInnerBins() * fNOuterBins);
+            this->PredictAdd(condi_params, joint_prediction);
+            return joint_prediction;
         }
 
         Vector
         ReducedJointTemplateComponent::
         PredictProjected(const Vector & condi_params) const {
             Vector comp_params = this->ComplimentaryParams(condi_params);
-            Vector joint_projection(condi_params.size() + comp_params.size());
+            Vector joint_projection((fComplimentarySamples.size() + 1) * fNOuterBins);
 
-            joint_projection(Eigen::seqN(fComplimentarySampleIdx * condi_params.size(), comp_params.size())) =
-                    fComplimentarySample->PredictProjected(comp_params);
-            joint_projection(Eigen::seqN(fConditioningSampleIdx * comp_params.size(), condi_params.size())) =
+            joint_projection.segment(fConditioningSampleIdx * fNOuterBins, fNOuterBins) =
                     fConditioningSample->PredictProjected(condi_params);
-
-            //joint_projection << fConditioningSample->PredictProjected(condi_params),
-            //fComplimentarySample->PredictProjected(comp_params);
+            for (auto i = 0u; i < fComplimentarySamples.size(); i++) {
+                joint_projection.segment(fComplimentarySampleIdx[i] * fNOuterBins, fNOuterBins) =
+                        fComplimentarySamples[i]->PredictProjected(comp_params.segment(i * fNOuterBins, fNOuterBins));
+            }
             return joint_projection;
         }
 
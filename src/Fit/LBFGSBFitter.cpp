@@ -0,0 +1,336 @@
+#include "XSecAna/Fit/LBFGSBFitter.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace xsec {
+    namespace fit {
+        namespace {
+            ///\brief Compact representation of the limited memory BFGS matrix
+            /// B = theta I - W M W^T, where W = [Y, theta S]
+            class CompactBFGS {
+            public:
+                CompactBFGS(int nparams, int memory)
+                        : fS(nparams, memory),
+                          fY(nparams, memory),
+                          fMemory(memory)
+                {}
+
+                void Reset() {
+                    fK = 0;
+                    fTheta = 1;
+                }
+
+                ///\brief Add the correction pair (s, y).
+                /// Pairs that don't satisfy the curvature condition are skipped
+                bool Update(const Vector & s, const Vector & y) {
+                    double sy = s.dot(y);
+                    double yy = y.squaredNorm();
+                    if (sy <= std::numeric_limits<double>::epsilon() * yy) return false;
+
+                    if (fK == fMemory) {
+                        fS.leftCols(fMemory - 1) = fS.rightCols(fMemory - 1).eval();
+                        fY.leftCols(fMemory - 1) = fY.rightCols(fMemory - 1).eval();
+                        fK--;
+                    }
+                    fS.col(fK) = s;
+                    fY.col(fK) = y;
+                    fK++;
+                    fTheta = yy / sy;
+
+                    // K = [ -D   L^T       ]
+                    //     [  L   theta S^TS ]
+                    auto S = fS.leftCols(fK);
+                    auto Y = fY.leftCols(fK);
+                    Matrix SY = S.transpose() * Y;
+                    Matrix K = Matrix::Zero(2 * fK, 2 * fK);
+                    K.topLeftCorner(fK, fK).diagonal() = -SY.diagonal();
+                    K.bottomLeftCorner(fK, fK) = SY.triangularView<Eigen::StrictlyLower>();
+                    K.topRightCorner(fK, fK) = K.bottomLeftCorner(fK, fK).transpose();
+                    K.bottomRightCorner(fK, fK) = fTheta * S.transpose() * S;
+                    fMiddle = Eigen::PartialPivLU<Matrix>(K);
+                    return true;
+                }
+
+                int Size() const { return fK; }
+
+                double Theta() const { return fTheta; }
+
+                ///\brief M v
+                Vector M(const Vector & v) const {
+                    if (fK == 0) return Vector::Zero(0);
+                    return fMiddle.solve(v);
+                }
+
+                Matrix M(const Matrix & v) const {
+                    if (fK == 0) return Matrix::Zero(0, v.cols());
+                    return fMiddle.solve(v);
+                }
+
+                ///\brief Row i of W
+                Vector WRow(int i) const {
+                    Vector w(2 * fK);
+                    w.head(fK) = fY.row(i).head(fK);
+                    w.tail(fK) = fTheta * fS.row(i).head(fK);
+                    return w;
+                }
+
+                ///\brief W^T v
+                Vector Wt(const Vector & v) const {
+                    Vector w(2 * fK);
+                    w.head(fK) = fY.leftCols(fK).transpose() * v;
+                    w.tail(fK) = fTheta * fS.leftCols(fK).transpose() * v;
+                    return w;
+                }
+
+                ///\brief Rows of W for the given parameters, transposed
+                Matrix WtRows(const std::vector<int> & idx) const {
+                    Matrix w(2 * fK, idx.size());
+                    w.topRows(fK) = fY(idx, Eigen::seqN(0, fK)).transpose();
+                    w.bottomRows(fK) = fTheta * fS(idx, Eigen::seqN(0, fK)).transpose();
+                    return w;
+                }
+
+            private:
+                Matrix fS;
+                Matrix fY;
+                int fMemory;
+                int fK = 0;
+                double fTheta = 1;
+                Eigen::PartialPivLU<Matrix> fMiddle;
+            };
+
+            ///\brief Generalized Cauchy point along the projected steepest descent path.
+            /// Returns the Cauchy point and c = W^T (xcp - x)
+            void CauchyPoint(const CompactBFGS & bfgs,
+                             const Vector & x,
+                             const Vector & g,
+                             double lower,
+                             double upper,
+                             Vector & xcp,
+                             Vector & c) {
+                const int n = x.size();
+                const double inf = std::numeric_limits<double>::infinity();
+                const double theta = bfgs.Theta();
+
+                Vector t(n);
+                Vector d = -g;
+                for (auto i = 0; i < n; i++) {
+                    if (g(i) < 0) t(i) = upper == inf ? inf : (x(i) - upper) / g(i);
+                    else if (g(i) > 0) t(i) = lower == -inf ? inf : (x(i) - lower) / g(i);
+                    else t(i) = inf;
+                    if (t(i) == 0) d(i) = 0;
+                }
+
+                std::vector<int> breakpoints;
+                for (auto i = 0; i < n; i++) {
+                    if (t(i) > 0 && t(i) < inf) breakpoints.push_back(i);
+                }
+                std::sort(breakpoints.begin(), breakpoints.end(),
+                          [&t](int a, int b) { return t(a) < t(b); });
+
+                xcp = x;
+                Vector p = bfgs.Wt(d);
+                c = Vector::Zero(p.size());
+                double f1 = g.dot(d);
+                double f2 = -theta * f1 - p.dot(bfgs.M(p));
+                const double f2_org = f2;
+                double dt_min = -f1 / f2;
+                double t_old = 0;
+
+                for (const auto & b : breakpoints) {
+                    double dt = t(b) - t_old;
+                    if (dt_min < dt) break;
+
+                    // variable b hits its bound
+                    xcp(b) = d(b) > 0 ? upper : lower;
+                    double zb = xcp(b) - x(b);
+                    c += dt * p;
+                    Vector wb = bfgs.WRow(b);
+                    double gb = g(b);
+
+                    f1 += dt * f2 + gb * gb + theta * gb * zb - gb * wb.dot(bfgs.M(c));
+                    f2 -= theta * gb * gb + 2 * gb * wb.dot(bfgs.M(p)) + gb * gb * wb.dot(bfgs.M(wb));
+                    f2 = std::max(std::numeric_limits<double>::epsilon() * f2_org, f2);
+                    p += gb * wb;
+                    d(b) = 0;
+                    dt_min = -f1 / f2;
+                    t_old = t(b);
+                }
+
+                dt_min = std::max(dt_min, 0.);
+                t_old += dt_min;
+                for (auto i = 0; i < n; i++) {
+                    if (d(i) != 0) xcp(i) = x(i) + t_old * d(i);
+                }
+                c += dt_min * p;
+            }
+
+            ///\brief Minimize the quadratic model over the variables that are free at the Cauchy point,
+            /// then step back into the feasible region
+            Vector SubspaceMinimization(const CompactBFGS & bfgs,
+                                        const Vector & x,
+                                        const Vector & g,
+                                        const Vector & xcp,
+                                        const Vector & c,
+                                        double lower,
+                                        double upper) {
+                std::vector<int> free;
+                for (auto i = 0; i < x.size(); i++) {
+                    if (xcp(i) > lower && xcp(i) < upper) free.push_back(i);
+                }
+                if (free.empty()) return xcp;
+
+                const double theta = bfgs.Theta();
+                Vector reduced_gradient = g + theta * (xcp - x);
+                if (bfgs.Size()) {
+                    Vector Mc = bfgs.M(c);
+                    for (auto i : free) reduced_gradient(i) -= bfgs.WRow(i).dot(Mc);
+                }
+                Vector r = reduced_gradient(free);
+
+                Vector du = -r / theta;
+                if (bfgs.Size()) {
+                    Matrix WtZ = bfgs.WtRows(free);
+                    Vector v = bfgs.M(Vector(WtZ * r));
+                    Matrix N = Matrix::Identity(WtZ.rows(), WtZ.rows()) -
+                               bfgs.M(Matrix(WtZ * WtZ.transpose())) / theta;
+                    v = N.partialPivLu().solve(v);
+                    du -= WtZ.transpose() * v / (theta * theta);
+                }
+
+                double alpha = 1;
+                for (auto i = 0u; i < free.size(); i++) {
+                    if (du(i) > 0) alpha = std::min(alpha, (upper - xcp(free[i])) / du(i));
+                    else if (du(i) < 0) alpha = std::min(alpha, (lower - xcp(free[i])) / du(i));
+                }
+
+                Vector xbar = xcp;
+                xbar(free) += alpha * du;
+                return xbar;
+            }
+
+            double ProjectedGradientNorm(const Vector & x, const Vector & g, double lower, double upper) {
+                return ((x - g).cwiseMax(lower).cwiseMin(upper) - x).lpNorm<Eigen::Infinity>();
+            }
+        }
+
+        LBFGSBFitter::Minimum
+        LBFGSBFitter::
+        Minimize(IFitCalculator * fit_calc,
+                 const Vector & data,
+                 const Vector & seed) const {
+            const int n = seed.size();
+            CompactBFGS bfgs(n, fMemory);
+
+            Vector x = seed.cwiseMax(fLowerBound).cwiseMin(fUpperBound);
+            Vector g;
+            double f = fit_calc->FunAndGradient(x, data, g);
+
+            Minimum minimum{x, f, false, 0};
+            for (auto iteration = 0; iteration < fMaxIterations; iteration++) {
+                minimum.iterations = iteration;
+                if (ProjectedGradientNorm(x, g, fLowerBound, fUpperBound) < fGradientTolerance) {
+                    minimum.converged = true;
+                    break;
+                }
+
+                Vector xcp, c;
+                CauchyPoint(bfgs, x, g, fLowerBound, fUpperBound, xcp, c);
+                Vector direction = SubspaceMinimization(bfgs, x, g, xcp, c, fLowerBound, fUpperBound) - x;
+                double slope = g.dot(direction);
+                if (slope >= 0) {
+                    // approximation has gone bad. Start again from steepest descent
+                    if (bfgs.Size() == 0) break;
+                    bfgs.Reset();
+                    continue;
+                }
+
+                // backtracking line search. Direction is feasible for steps <= 1
+                double step = bfgs.Size() ? 1 : std::min(1., 1. / direction.norm());
+                Vector x_new, g_new;
+                double f_new = f;
+                bool accepted = false;
+                for (auto itry = 0; itry < 30; itry++) {
+                    x_new = (x + step * direction).cwiseMax(fLowerBound).cwiseMin(fUpperBound);
+                    f_new = fit_calc->FunAndGradient(x_new, data, g_new);
+                    if (std::isfinite(f_new) && f_new <= f + 1e-4 * step * slope) {
+                        accepted = true;
+                        break;
+                    }
+                    // minimum of the quadratic interpolation, within [0.1, 0.5] of the current step
+                    double quad = -slope * step * step / (2 * (f_new - f - slope * step));
+                    step = std::isfinite(quad) ? std::max(0.1 * step, std::min(0.5 * step, quad)) : 0.5 * step;
+                }
+                if (!accepted) {
+                    if (bfgs.Size() == 0) break;
+                    bfgs.Reset();
+                    continue;
+                }
+
+                bfgs.Update(x_new - x, g_new - g);
+                double reduction = f - f_new;
+                x = x_new;
+                g = g_new;
+                f = f_new;
+                if (reduction <= fFunctionTolerance * std::max({std::abs(f), std::abs(f + reduction), 1.})) {
+                    minimum.converged = true;
+                    break;
+                }
+            }
+            minimum.params = x;
+            minimum.fun_val = f;
+            return minimum;
+        }
+
+        FitResult
+        LBFGSBFitter::
+        Fit(IFitCalculator * fit_calc,
+            const Vector & data,
+            std::vector<Vector> seeds) {
+            // a warm start is used once and only if the number of free parameters hasn't changed
+            Vector warm_start;
+            std::swap(warm_start, fWarmStartParams);
+            if (warm_start.size() == fit_calc->GetNMinimizerParams()) {
+                seeds.insert(seeds.begin(), warm_start);
+            }
+
+            // if user hasn't provided any starting positions, we'll start at 1 for all params
+            if (seeds.size() == 0) {
+                seeds.push_back(Vector::Ones(fit_calc->GetNMinimizerParams()));
+            }
+
+            Minimum best;
+            best.fun_val = std::numeric_limits<double>::infinity();
+            fNIterations = 0;
+            for (const auto & seed : seeds) {
+                auto minimum = Minimize(fit_calc, data, seed);
+                fNIterations += minimum.iterations;
+                if (minimum.fun_val < best.fun_val) best = minimum;
+            }
+
+            // covariance from the hessian at the minimum
+            Matrix hessian = fit_calc->Hessian(best.params, data);
+            Eigen::LDLT<Matrix> decomp(hessian);
+            Matrix covariance = 2 * fUp * decomp.solve(Matrix::Identity(hessian.rows(), hessian.cols()));
+
+            FitResult result;
+            result.is_valid = best.converged &&
+                              decomp.info() == Eigen::Success &&
+                              decomp.isPositive() &&
+                              covariance.allFinite();
+            if (!result.is_valid) {
+                std::cout << "Warning: Invalid Global Minimum" << std::endl;
+                throw xsec::fit::InvalidMinimumError();
+            }
+
+            result.fun_val = best.fun_val;
+            result.params = fit_calc->ToUserParams(best.params);
+            result.covariance = fit_calc->ToUserCovariance(covariance);
+            result.params_error_up = result.covariance.matrix().diagonal().cwiseMax(0).cwiseSqrt();
+            result.params_error_down = -1 * result.params_error_up;
+            result.fun_calls = fit_calc->GetNFunCalls();
+            return result;
+        }
+    }
+}
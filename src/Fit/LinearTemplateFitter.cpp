@@ -0,0 +1,156 @@
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+
+namespace xsec {
+    namespace fit {
+        Vector
+        LinearTemplateFitter::
+        NNLS(const Matrix & H, const Vector & f, const Vector & x0) {
+            const int n = f.size();
+
+            // most of the time no bound is active,
+            // so try the unconstrained minimum first
+            Eigen::LDLT<Matrix> unconstrained(H);
+            if (unconstrained.info() == Eigen::Success) {
+                Vector x = unconstrained.solve(f);
+                if (x.allFinite() && (x.array() >= 0).all()) return x;
+            }
+
+            const double tolerance = 1e-12 * std::max(1., f.cwiseAbs().maxCoeff());
+            Vector x = x0.cwiseMax(0);
+            std::vector<bool> passive(n);
+            for (auto i = 0; i < n; i++) passive[i] = x(i) > 0;
+            std::vector<bool> rejected(n, false);
+
+            auto solve_passive = [&]() {
+                std::vector<int> idx;
+                for (auto i = 0; i < n; i++) if (passive[i]) idx.push_back(i);
+                Vector s = Vector::Zero(n);
+                if (!idx.empty()) {
+                    Matrix Hp = H(idx, idx);
+                    Vector fp = f(idx);
+                    Vector sp = Hp.ldlt().solve(fp);
+                    s(idx) = sp;
+                }
+                return s;
+            };
+
+            for (auto outer = 0; outer < 3 * n + 1; outer++) {
+                // find the minimum over the passive set while keeping x feasible
+                for (auto inner = 0; inner <= n; inner++) {
+                    Vector s = solve_passive();
+                    double alpha = 1;
+                    for (auto i = 0; i < n; i++) {
+                        if (passive[i] && s(i) <= 0) {
+                            alpha = std::min(alpha, x(i) / (x(i) - s(i)));
+                        }
+                    }
+                    if (alpha == 1) {
+                        x = s;
+                        break;
+                    }
+                    x += alpha * (s - x);
+                    for (auto i = 0; i < n; i++) {
+                        if (passive[i] && x(i) <= tolerance) {
+                            passive[i] = false;
+                            x(i) = 0;
+                        }
+                    }
+                }
+
+                // release the bound with the steepest descent direction
+                Vector w = f - H * x;
+                int next = -1;
+                for (auto i = 0; i < n; i++) {
+                    if (!passive[i] && !rejected[i] && w(i) > tolerance &&
+                        (next < 0 || w(i) > w(next))) {
+                        next = i;
+                    }
+                }
+                if (next < 0) break;
+                passive[next] = true;
+
+                // guard against cycling when a released bound immediately becomes active again
+                Vector s = solve_passive();
+                if (s(next) <= 0) {
+                    passive[next] = false;
+                    rejected[next] = true;
+                }
+                else {
+                    std::fill(rejected.begin(), rejected.end(), false);
+                }
+            }
+            return x;
+        }
+
+        FitResult
+        LinearTemplateFitter::
+        Fit(IFitCalculator * fit_calc,
+            const Vector & data,
+            std::vector<Vector> seeds) {
+            auto calc = dynamic_cast<TemplateFitCalculator *>(fit_calc);
+            if (!calc) {
+                throw std::runtime_error("LinearTemplateFitter requires a TemplateFitCalculator");
+            }
+            const auto nparams = calc->GetNMinimizerParams();
+            const auto & solver = calc->GetCovarianceSolver();
+
+            // prediction = A * minimizer_params + contribution from fixed parameters
+            Matrix design = calc->GetMinimizerDesignMatrix();
+            Vector residual = data - calc->Predict(calc->ToUserParams(Vector::Zero(nparams)));
+
+            // problem is convex for each covariance estimate, so only the best seed matters
+            Vector params = seeds.empty() ? Vector::Ones(nparams) : seeds[0];
+
+            Matrix rhs(design.rows(), nparams + 1);
+            rhs << design, residual;
+
+            bool converged = false;
+            Matrix H;
+            for (auto iteration = 0; iteration < fMaxIterations; iteration++) {
+                Matrix x;
+                if (calc->GetIgnoreStatisticalUncertainty()) {
+                    x = solver.Solve(rhs);
+                }
+                else {
+                    Vector prediction = calc->Predict(calc->ToUserParams(params));
+                    x = solver.Solve(rhs, calc->StatisticalVariance(prediction, data));
+                }
+                H = design.transpose() * x.leftCols(nparams);
+                Vector f = design.transpose() * x.col(nparams);
+
+                Vector next = NNLS(H, f, params);
+                double change = (next - params).norm();
+                params = next;
+                if (calc->GetIgnoreStatisticalUncertainty() ||
+                    change <= fTolerance * (1 + params.norm())) {
+                    converged = true;
+                    break;
+                }
+            }
+
+            // chi2 = (r - Ap)^T C^-1 (r - Ap) so its hessian is 2H
+            Eigen::LDLT<Matrix> hessian(H);
+            Matrix covariance = fUp * hessian.solve(Matrix::Identity(nparams, nparams));
+
+            FitResult result;
+            result.is_valid = converged &&
+                              hessian.info() == Eigen::Success &&
+                              hessian.isPositive() &&
+                              covariance.allFinite();
+            if (!result.is_valid) {
+                std::cout << "Warning: Invalid Global Minimum" << std::endl;
+                throw xsec::fit::InvalidMinimumError();
+            }
+
+            Vector error = covariance.diagonal().cwiseMax(0).cwiseSqrt();
+            result.params = calc->ToUserParams(params);
+            result.params_error_up = calc->GetParamMap().ToUserParams(error);
+            result.params_error_down = -1 * result.params_error_up;
+            result.covariance = calc->ToUserCovariance(covariance);
+            result.fun_val = calc->fun(params, data);
+            result.fun_calls = calc->GetNFunCalls();
+            return result;
+        }
+    }
+}
@@ -4,6 +4,7 @@
 
 #include "XSecAna/Fit/Minuit2TemplateFitter.h"
 #include "XSecAna/Fit/TemplateFitCalculator.h"
+#include <cmath>
 
 namespace xsec {
     namespace fit {
@@ -39,6 +40,29 @@ namespace xsec {
             }
         }
 
+        Minuit2TemplateFitter::
+        Minuit2TemplateFitter(const Minuit2TemplateFitter & other)
+                : IFitter(other),
+                  ROOT::Minuit2::FCNBase(other),
+                  fSeedFitter(other.fSeedFitter ? other.fSeedFitter->Clone() : nullptr),
+                  fFitCalc(other.fFitCalc),
+                  fMnStrategy(other.fMnStrategy),
+                  fUp(other.fUp),
+                  fMinosErrors(other.fMinosErrors),
+                  fInitialError(other.fInitialError),
+                  fData(other.fData),
+                  fWarmStartParams(other.fWarmStartParams),
+                  fWarmStartCovariance(other.fWarmStartCovariance)
+        {}
+
+        void
+        Minuit2TemplateFitter::
+        WarmStart(const Vector & minimizer_params,
+                  const Matrix & minimizer_covariance) {
+            fWarmStartParams = minimizer_params;
+            fWarmStartCovariance = minimizer_covariance;
+        }
+
         FitResult
         Minuit2TemplateFitter::
         Fit(IFitCalculator * fit_calc,
@@ -51,13 +75,40 @@ namespace xsec {
             // setup minuit fitter
             fFitCalc->GetNMinimizerParams();
 
+            if (fSeedFitter) {
+                try {
+                    auto seed_result = fSeedFitter->Fit(fit_calc, data, seeds);
+                    seeds.insert(seeds.begin(), fFitCalc->ToMinimizerParams(seed_result.params));
+                }
+                catch (InvalidMinimumError & e) {
+                    std::cout << "Warning: Seed fitter failed to find a minimum" << std::endl;
+                }
+            }
+
+            // a warm start is used once and only if the number of free parameters hasn't changed
+            Vector warm_start_params;
+            Matrix warm_start_covariance;
+            std::swap(warm_start_params, fWarmStartParams);
+            std::swap(warm_start_covariance, fWarmStartCovariance);
+            bool warm_start = warm_start_params.size() == fFitCalc->GetNMinimizerParams();
+            bool warm_start_covariance_valid = warm_start &&
+                                               warm_start_covariance.rows() == warm_start_params.size() &&
+                                               warm_start_covariance.allFinite() &&
+                                               (warm_start_covariance.diagonal().array() > 0).all();
+            if (warm_start) {
+                seeds.insert(seeds.begin(), warm_start_params.cwiseMax(0));
+            }
+
             // if user hasn't provided any starting positions, we'll start at 1 for all params
             if (seeds.size() == 0) {
                 seeds.push_back(Eigen::VectorXd::Ones(fFitCalc->GetNMinimizerParams()));
             }
 
             std::vector<ROOT::Minuit2::FunctionMinimum> mins;
-            for (auto seed: seeds) {
+            for (auto iseed = 0u; iseed < seeds.size(); iseed++) {
+                const auto & seed = seeds[iseed];
+                bool use_covariance = iseed == 0 && warm_start_covariance_valid;
+
                 // minuit2 requires parameters to be initialized with errors
                 // 10% seems like a reasonable starting point
                 ROOT::Minuit2::MnUserParameters mn_params;
@@ -65,17 +116,29 @@ namespace xsec {
                     // can we name these better?
                     mn_params.Add(std::to_string(i),
                                   seed(i),
-                                  fInitialError);
+                                  use_covariance ? std::sqrt(warm_start_covariance(i, i)) : fInitialError);
                     mn_params.SetLowerLimit(std::to_string(i), 0);
                 }
-                // call minimizer with this
-                ROOT::Minuit2::MnMigrad minimizer(*this, mn_params, fMnStrategy);
 
                 // fit runs here.
                 // Save all the results and find the best one after.
                 // We'll need the best ROOT::Minuit2::FunctionMinimum
                 // to find errors with ROOT::Minuit2::MnMinos
-                mins.push_back(minimizer());
+                if (use_covariance) {
+                    // the previous error matrix saves Migrad from rebuilding it from scratch
+                    ROOT::Minuit2::MnUserCovariance mn_covariance(seed.size());
+                    for (auto i = 0u; i < seed.size(); i++) {
+                        for (auto j = i; j < seed.size(); j++) {
+                            mn_covariance(i, j) = warm_start_covariance(i, j);
+                        }
+                    }
+                    ROOT::Minuit2::MnMigrad minimizer(*this, mn_params, mn_covariance, fMnStrategy);
+                    mins.push_back(minimizer());
+                }
+                else {
+                    ROOT::Minuit2::MnMigrad minimizer(*this, mn_params, fMnStrategy);
+                    mins.push_back(minimizer());
+                }
             }
 
             // find best fit
@@ -0,0 +1,101 @@
+#include "XSecAna/Fit/ProfileScanner.h"
+#include "XSecAna/Fit/FitSession.h"
+#include "XSecAna/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace xsec {
+    namespace fit {
+        std::vector<FitResult>
+        ProfileScanner::
+        Scan(const Vector & data,
+             const std::vector<int> & params,
+             const Matrix & points,
+             const std::vector<std::vector<int>> & paths,
+             const FitResult & start) const {
+            assert(points.cols() == (Eigen::Index) params.size());
+            std::vector<FitResult> results(points.rows());
+
+            parallel::For(paths.size(), [&](std::size_t ipath) {
+                FitSession session(fFitCalc, fFitter);
+                auto fit_calc = session.GetFitCalc();
+
+                Vector warm_params = start.params;
+                Array2D warm_covariance = start.covariance;
+                for (const auto & ipoint : paths[ipath]) {
+                    for (auto i = 0u; i < params.size(); i++) {
+                        session.FixTemplate(params[i], points(ipoint, i));
+                    }
+
+                    auto & result = results[ipoint];
+                    if (fit_calc->GetNMinimizerParams() == 0) {
+                        // nothing left to profile
+                        result.is_valid = true;
+                        result.params = fit_calc->ToUserParams(Vector());
+                        result.fun_val = fit_calc->fun(Vector(), data);
+                        result.covariance = Array2D::Zero(result.params.size(), result.params.size());
+                        result.params_error_up = Array::Zero(result.params.size());
+                        result.params_error_down = Array::Zero(result.params.size());
+                        result.fun_calls = fit_calc->GetNFunCalls();
+                        continue;
+                    }
+
+                    session.GetFitter()->WarmStart(fit_calc->ToMinimizerParams(warm_params),
+                                                   fit_calc->ToMinimizerCovariance(warm_covariance));
+                    try {
+                        result = session.Fit(data);
+                        warm_params = result.params;
+                        warm_covariance = result.covariance;
+                    }
+                    catch (InvalidMinimumError & e) {
+                        result.is_valid = false;
+                        result.fun_val = std::numeric_limits<double>::quiet_NaN();
+                        result.params = fit_calc->ToUserParams(fit_calc->ToMinimizerParams(warm_params));
+                    }
+                }
+            }, fNThreads);
+            return results;
+        }
+
+        std::vector<std::vector<int>>
+        ProfileScanner::
+        SweepPaths(const std::vector<double> & values,
+                   double origin,
+                   int npaths) {
+            std::vector<int> order(values.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(),
+                      [&values](int a, int b) { return values[a] < values[b]; });
+
+            npaths = std::max(1, std::min<int>(npaths, values.size()));
+            std::vector<std::vector<int>> paths;
+            for (auto ipath = 0; ipath < npaths; ipath++) {
+                auto begin = order.begin() + ipath * values.size() / npaths;
+                auto end = order.begin() + (ipath + 1) * values.size() / npaths;
+                std::vector<int> path(begin, end);
+                if (path.empty()) continue;
+                if (values[path.back()] <= origin) {
+                    // entirely below the origin, so walk downward
+                    std::reverse(path.begin(), path.end());
+                }
+                else if (values[path.front()] < origin) {
+                    // straddles the origin, so split into two paths that walk outward from the closest value
+                    auto closest = std::min_element(path.begin(), path.end(),
+                                                    [&](int a, int b) {
+                                                        return std::abs(values[a] - origin) <
+                                                               std::abs(values[b] - origin);
+                                                    });
+                    std::vector<int> downward(path.begin(), closest);
+                    std::reverse(downward.begin(), downward.end());
+                    if (!downward.empty()) paths.push_back(downward);
+                    path = std::vector<int>(closest, path.end());
+                }
+                paths.push_back(path);
+            }
+            return paths;
+        }
+    }
+}
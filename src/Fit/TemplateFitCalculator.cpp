@@ -3,6 +3,7 @@
 //
 
 #include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Parallel.h"
 #include <cmath>
 
 namespace xsec {
@@ -43,22 +44,43 @@ namespace xsec {
             Vector u = this->Predict(user_params);
             Vector v = data - u;
 
-            Matrix total_covariance = fSystematicCovariance;
+            if(fIgnoreStatisticalUncertainty) {
+                return fCovarianceSolver->Chi2(v);
+            }
+
             // add statistical uncertainty of reweighted prediction
-            if(!fIgnoreStatisticalUncertainty) {
-                Vector stat_cnp = Vector::Zero(u.size());
-                for(auto i = 0u; i < stat_cnp.size(); i++) {
-                    if(data(i)) {
-                        stat_cnp(i) = 3. / (1. / data(i) + 2. / u(i));
-                    }
-                    else {
-                        stat_cnp(i) = u(i) / 2.;
-                    }
+            return fCovarianceSolver->Chi2(v, StatisticalVariance(u, data));
+        }
+
+        Vector
+        TemplateFitCalculator::
+        StatisticalVariance(const Vector & prediction, const Vector & data) const {
+            Vector stat_cnp = Vector::Zero(prediction.size());
+            for(auto i = 0u; i < stat_cnp.size(); i++) {
+                if(data(i)) {
+                    stat_cnp(i) = 3. / (1. / data(i) + 2. / prediction(i));
+                }
+                else {
+                    stat_cnp(i) = prediction(i) / 2.;
                 }
-                total_covariance += stat_cnp.asDiagonal();
             }
-            fDecomp.compute(total_covariance);
-            return v.dot(fDecomp.solve(v));// + LogDetV(fDecomp);
+            return stat_cnp;
+        }
+
+        Vector
+        TemplateFitCalculator::
+        StatisticalVarianceDerivative(const Vector & prediction, const Vector & data) const {
+            Vector dstat_cnp = Vector::Zero(prediction.size());
+            for(auto i = 0u; i < dstat_cnp.size(); i++) {
+                if(data(i)) {
+                    double denom = prediction(i) / data(i) + 2.;
+                    dstat_cnp(i) = 6. / (denom * denom);
+                }
+                else {
+                    dstat_cnp(i) = 0.5;
+                }
+            }
+            return dstat_cnp;
         }
 
 /*
@@ -107,6 +129,63 @@ namespace xsec {
             return this->Chi2(this->ToUserParams(minimizer_params), data);
         }
 
+        double
+        TemplateFitCalculator::
+        FunAndGradient(const Vector & minimizer_params,
+                       const Vector & data,
+                       Vector & gradient) const {
+            fNFunCalls++;
+            Vector u = this->Predict(this->ToUserParams(minimizer_params));
+            Vector v = data - u;
+
+            // chi2 = v^T C^-1 v
+            // d(chi2)/du = -2 C^-1 v - (C^-1 v)^2 * d(stat)/du
+            Vector cinv_v;
+            Vector dchi2_du;
+            if(fIgnoreStatisticalUncertainty) {
+                cinv_v = fCovarianceSolver->Solve(v);
+                dchi2_du = -2 * cinv_v;
+            }
+            else {
+                cinv_v = fCovarianceSolver->Solve(v, StatisticalVariance(u, data));
+                dchi2_du = -2 * cinv_v.array() -
+                           cinv_v.array().square() * StatisticalVarianceDerivative(u, data).array();
+            }
+            gradient = fParamMap.ToMinimizerParams(fDesignMatrix->transpose() * dchi2_du);
+            return v.dot(cinv_v);
+        }
+
+        Vector
+        TemplateFitCalculator::
+        Gradient(const Vector & minimizer_params,
+                 const Vector & data) const {
+            Vector gradient;
+            this->FunAndGradient(minimizer_params, data, gradient);
+            return gradient;
+        }
+
+        Matrix
+        TemplateFitCalculator::
+        Hessian(const Vector & minimizer_params,
+                const Vector & data) const {
+            Matrix design = this->GetMinimizerDesignMatrix();
+            Matrix cinv_design;
+            if(fIgnoreStatisticalUncertainty) {
+                cinv_design = fCovarianceSolver->Solve(design);
+            }
+            else {
+                Vector u = this->Predict(this->ToUserParams(minimizer_params));
+                cinv_design = fCovarianceSolver->Solve(design, StatisticalVariance(u, data));
+            }
+            // the design matrix is sparse, so contract with it before selecting the free parameters
+            Matrix user_hessian = fDesignMatrix->transpose() * cinv_design;
+            std::vector<int> minimizer_idx(GetNMinimizerParams());
+            for (auto i = 0u; i < minimizer_idx.size(); i++) {
+                minimizer_idx[i] = fParamMap.MinimizerToUserIdx(i);
+            }
+            return 2 * user_hessian(minimizer_idx, Eigen::all);
+        }
+
         /// \brief User-level function for returning sum
         /// of all templates given the input template normalization
         /// parameters
@@ -152,10 +231,11 @@ namespace xsec {
         TemplateFitCalculator(const ReducedComponentCollection & templates,
                               const std::vector<int> & dims,
                               const Matrix & systematic_covariance,
-                              bool ignore_statistical_uncertainty)
-                : fSystematicCovariance(systematic_covariance),
-                  fNFunCalls(0),
+                              bool ignore_statistical_uncertainty,
+                              CovarianceStructure_t covariance_structure)
+                : fCovarianceStructure(covariance_structure),
                   fComponents(templates),
+                  fNFunCalls(0),
                   fIgnoreStatisticalUncertainty(ignore_statistical_uncertainty) {
 
             // check we have an appropriate covariance matrix
@@ -168,15 +248,111 @@ namespace xsec {
             fParamMap = detail::ParamMap(fNUserParams);
             fFixedParams = Eigen::RowVectorXd::Zero(fNUserParams);
 
+            fCovarianceSolver = std::make_shared<const CovarianceSolver>(systematic_covariance, fCovarianceStructure);
+            SetupDesignMatrix();
             WarnInversionError();
         }
 
+        TemplateFitCalculator::
+        TemplateFitCalculator(const ReducedComponentCollection & templates,
+                              std::shared_ptr<const CovarianceSolver> covariance_solver,
+                              std::shared_ptr<const Eigen::SparseMatrix<double>> design_matrix,
+                              std::shared_ptr<const Vector> prediction_offset,
+                              bool ignore_statistical_uncertainty)
+                : fCovarianceSolver(covariance_solver),
+                  fCovarianceStructure(covariance_solver->GetStructure()),
+                  fComponents(templates),
+                  fDesignMatrix(design_matrix),
+                  fPredictionOffset(prediction_offset),
+                  fNFunCalls(0),
+                  fIgnoreStatisticalUncertainty(ignore_statistical_uncertainty) {
+            fNUserParams = fComponents.GetNOuterBins() * fComponents.size();
+            fNComponents = fComponents.size();
+
+            const int nbins = fComponents.GetNOuterBins() * fComponents.GetNInnerBins();
+            if (fCovarianceSolver->GetCovariance().rows() != nbins ||
+                fDesignMatrix->rows() != nbins ||
+                fDesignMatrix->cols() != fNUserParams ||
+                fPredictionOffset->size() != nbins) {
+                throw std::runtime_error("TemplateFitCalculator: restored pieces don't match the templates");
+            }
+
+            fParamMap = detail::ParamMap(fNUserParams);
+            fFixedParams = Eigen::RowVectorXd::Zero(fNUserParams);
+        }
+
+        void
+        TemplateFitCalculator::
+        SetupDesignMatrix() {
+            // Predictions are affine in the user parameters.
+            // Find the offset and the response to each parameter by evaluating unit vectors
+            Vector offset = this->Predict(Vector::Zero(fNUserParams));
+            std::vector<std::vector<Eigen::Triplet<double>>> columns(fNUserParams);
+            parallel::For(fNUserParams, [&](std::size_t j) {
+                Vector unit = Vector::Zero(fNUserParams);
+                unit(j) = 1;
+                Vector response = this->Predict(unit) - offset;
+                for (auto i = 0u; i < response.size(); i++) {
+                    if (response(i) != 0) columns[j].emplace_back(i, j, response(i));
+                }
+            });
+
+            std::vector<Eigen::Triplet<double>> triplets;
+            for (const auto & column : columns) {
+                triplets.insert(triplets.end(), column.begin(), column.end());
+            }
+            auto design = std::make_shared<Eigen::SparseMatrix<double>>(offset.size(), fNUserParams);
+            design->setFromTriplets(triplets.begin(), triplets.end());
+            fDesignMatrix = design;
+            fPredictionOffset = std::make_shared<const Vector>(offset);
+        }
+
+        Matrix
+        TemplateFitCalculator::
+        GetMinimizerDesignMatrix() const {
+            Matrix design(fDesignMatrix->rows(), GetNMinimizerParams());
+            for (auto i = 0u; i < GetNMinimizerParams(); i++) {
+                design.col(i) = fDesignMatrix->col(fParamMap.MinimizerToUserIdx(i));
+            }
+            return design;
+        }
+
+        Array2D
+        TemplateFitCalculator::
+        ToUserCovariance(const Matrix & minimizer_covariance) const {
+            std::vector<int> user_idx(GetNMinimizerParams());
+            for (auto i = 0u; i < user_idx.size(); i++) {
+                user_idx[i] = fParamMap.MinimizerToUserIdx(i);
+            }
+            Array2D covariance = Array2D::Zero(GetNUserParams(), GetNUserParams());
+            covariance(user_idx, user_idx) = minimizer_covariance;
+            return covariance;
+        }
+
+        Matrix
+        TemplateFitCalculator::
+        ToMinimizerCovariance(const Array2D & user_covariance) const {
+            std::vector<int> user_idx(GetNMinimizerParams());
+            for (auto i = 0u; i < user_idx.size(); i++) {
+                user_idx[i] = fParamMap.MinimizerToUserIdx(i);
+            }
+            return user_covariance(user_idx, user_idx).matrix();
+        }
+
+        void
+        TemplateFitCalculator::
+        SetCovarianceStructure(CovarianceStructure_t structure) {
+            fCovarianceStructure = structure;
+            fCovarianceSolver = std::make_shared<const CovarianceSolver>(GetSystematicCovariance(), fCovarianceStructure);
+        }
+
         void
         TemplateFitCalculator::
         AddNoise(double noise) {
             std::cout << "Info: Adding noise to the Covariance Diagonal: " << noise << std::endl;
-            Matrix epsilon = (Vector::Ones(fSystematicCovariance.rows()) * noise).asDiagonal();
-            fSystematicCovariance += epsilon;
+            Matrix covariance = GetSystematicCovariance();
+            covariance.diagonal().array() += noise;
+            fCovarianceSolver = std::make_shared<const CovarianceSolver>(covariance, fCovarianceStructure);
             WarnInversionError();
         }
 
@@ -184,7 +360,7 @@ namespace xsec {
         TemplateFitCalculator::
         GetTotalCovariance(const Vector & params) const {
             Vector u = this->Predict(params);
-            Matrix total_covariance = fSystematicCovariance;
+            Matrix total_covariance = GetSystematicCovariance();
             // add statistical uncertainty of reweighted prediction
             if(!fIgnoreStatisticalUncertainty) {
                 total_covariance += u.asDiagonal();
@@ -195,11 +371,12 @@ namespace xsec {
         void
         TemplateFitCalculator::
         WarnInversionError() const {
-            Matrix I = Matrix::Identity(fSystematicCovariance.rows(),
-                                        fSystematicCovariance.cols());
-            fDecomp.compute(fSystematicCovariance);
-            Matrix x = fDecomp.solve(I);
-            double error = (fSystematicCovariance * x - I).norm() / I.norm();
+            const auto & covariance = fCovarianceSolver->GetCovariance();
+            Matrix I = Matrix::Identity(covariance.rows(),
+                                        covariance.cols());
+            Eigen::LLT<Matrix> decomp(covariance);
+            Matrix x = decomp.solve(I);
+            double error = (covariance * x - I).norm() / I.norm();
             std::cout << "Info: Numerical Accuracy of Covariance Matrix Inversion = " << error << std::endl;
         }
     }
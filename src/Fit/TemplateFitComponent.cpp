@@ -1,4 +1,6 @@
 #include "XSecAna/Fit/TemplateFitComponent.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/Parallel.h"
 
 namespace xsec {
     namespace fit {
@@ -102,8 +104,9 @@ namespace xsec {
 
                 fM.conservativeResize(fM.rows(), fM.cols() + 1);
                 auto block_cols = fM.cols() - insert_at - 1;
+                // source and destination overlap
                 fM.block(0, insert_at + 1, fM.rows(), block_cols) =
-                        fM.block(0, insert_at, fM.rows(), block_cols);
+                        fM.block(0, insert_at, fM.rows(), block_cols).eval();
                 fM.col(insert_at) = Eigen::VectorXd::Zero(fM.rows());
                 fM(template_idx, insert_at) = 1;
             }
@@ -160,6 +163,7 @@ namespace xsec {
         ReducedComponent(const Vector & a, int nouter_bins, int ninner_bins)
                 : fArray(a), fNOuterBins(nouter_bins), fNInnerBins(ninner_bins) {
             fHist = std::make_shared<TH1D>("", "", a.size(), 0, a.size());
+            fHist->SetDirectory(nullptr);
             for(int i = 0; i < a.size(); i++) {
                 fHist->SetBinContent(i+1, a(i));
             }
@@ -179,6 +183,14 @@ namespace xsec {
                    component_params.asDiagonal()).reshaped();
         }
 
+        void
+        ReducedTemplateComponent::
+        PredictAdd(const Vector & component_params, Eigen::Ref<Vector> prediction) const {
+            prediction.reshaped(fMean->GetNInnerBins(), fMean->GetNOuterBins()) +=
+                    fMean->GetArray().reshaped(fMean->GetNInnerBins(), fMean->GetNOuterBins()) *
+                    component_params.asDiagonal();
+        }
+
         Vector
         ReducedTemplateComponent::
         PredictProjected(const Vector & component_params) const {
@@ -191,12 +203,15 @@ namespace xsec {
         IReducedTemplateComponent *
         UserTemplateComponent::
         Reduce(const ComponentReducer & reducer) const {
-            std::map<std::string, Systematic<TH1>> reduced_systematics;
-            for(const auto & syst : fSystematics) {
-                reduced_systematics[syst.first] = reducer.Reduce(syst.second);
-            }
+            std::vector<std::pair<std::string, Systematic<TH1>>> systematics(fSystematics.begin(),
+                                                                             fSystematics.end());
+            root::EnableThreadSafety();
+            parallel::For(systematics.size(), [&](std::size_t i) {
+                systematics[i].second = reducer.Reduce(systematics[i].second);
+            });
             return new ReducedTemplateComponent(reducer.Reduce(fMean),
-                                                reduced_systematics);
+                                                std::map<std::string, Systematic<TH1>>(systematics.begin(),
+                                                                                       systematics.end()));
         }
 
         IReducedTemplateComponent *
@@ -216,6 +231,28 @@ namespace xsec {
         xsec::Systematic<TH1>
         ComponentReducer::
         Reduce(const Systematic<TH1> & syst) const {
+            auto universes = syst.GetUniverseMatrix();
+            if (universes && universes->GetBinning()->GetDimension() > 1) {
+                // reducing only moves bins around, so reduce a histogram of
+                // global bin numbers (offset by one so 0 is an empty bin) once
+                // and gather every universe with the result
+                auto nbins = universes->GetNBins();
+                auto index = std::shared_ptr<TH1>((TH1 *) universes->GetBinning()->Clone());
+                index->SetDirectory(nullptr);
+                index->SetContent(Array(Array::LinSpaced(nbins, 1, nbins)).data());
+                std::unique_ptr<ReducedComponent> reduced_index(this->Reduce(index));
+
+                const auto & source = reduced_index->GetArray();
+                std::vector<int> rows(source.size() + 2, -1);
+                for (auto i = 0; i < source.size(); i++) {
+                    rows[i + 1] = std::lround(source(i)) - 1;
+                }
+                // same binning and errors as the histograms of ReducedComponent
+                TH1D binning("", "", source.size(), 0, source.size());
+                binning.SetDirectory(nullptr);
+                return Systematic<TH1>(syst.GetName(), universes->Gather(rows, &binning, false));
+            }
+
             std::vector<std::shared_ptr<TH1>> reduced;
             for(auto i = 0u; i < syst.GetShifts().size(); i++) {
                 reduced.push_back(this->Reduce(syst.GetShifts()[i])->GetHist());
@@ -271,6 +308,7 @@ namespace xsec {
                     fMap.ToMinimizerParams(root::MapErrorsToEigen(component.get()));
 
             auto ret = new TH1D("", "", fMap.GetNMinimizerParams(), 0, fMap.GetNMinimizerParams());
+            ret->SetDirectory(nullptr);
             return root::ToROOTLike(ret, compressed_c, compressed_e);
         }
 
@@ -280,7 +318,9 @@ namespace xsec {
             std::vector<int> dims(2);
             if (component->GetDimension() == 1) {
                 std::cout << "Warning: Attempting to apply to mask 1-dimensional template fit" << std::endl;
-                return new ReducedComponent((TH1*) component->Clone(),
+                auto ret = (TH1 *) component->Clone();
+                ret->SetDirectory(nullptr);
+                return new ReducedComponent(ret,
                                             1,
                                             component->GetNbinsX());
                         ;
@@ -291,6 +331,7 @@ namespace xsec {
                 auto ret = new TH2D("", "",
                                     component->GetNbinsY() - 2, 1, component->GetNbinsY(),
                                     nunmasked - 2, 1, nunmasked - 1);
+                ret->SetDirectory(nullptr);
                 auto ii = 0;
                 for (auto i = 0u; i < fMask->GetNbinsX() + 2; i++) {
                     if (fMask->GetBinContent(i)) {
@@ -318,6 +359,7 @@ namespace xsec {
                 auto ret = new TH2D("", "",
                                     component->GetNbinsZ() - 2, 1, component->GetNbinsZ(),
                                     nunmasked - 2, 1, nunmasked - 1);
+                ret->SetDirectory(nullptr);
                 // Not sure why we have to loop over y first,
                 // but its necessary for things to get ordered properly
                 // during the un-masking
@@ -346,9 +388,19 @@ namespace xsec {
         ReducedComponentCollection
         UserComponentCollection::
         Reduce(const ComponentReducer & reducer) const {
+            // components are reduced independently. With fewer components than threads
+            // they're reduced one at a time so each can reduce its systematics in parallel instead
+            std::vector<std::pair<std::string, const IUserTemplateComponent *>> components(fComponents.begin(),
+                                                                                        fComponents.end());
+            std::vector<const IReducedTemplateComponent *> reduced(components.size());
+            root::EnableThreadSafety();
+            parallel::For(components.size(), [&](std::size_t i) {
+                reduced[i] = components[i].second->Reduce(reducer);
+            }, components.size() >= parallel::GetNThreads() ? 0 : 1);
+
             std::map<std::string, const IReducedTemplateComponent *> reduced_components;
-            for (const auto & component: fComponents) {
-                reduced_components[component.first] = component.second->Reduce(reducer);
+            for (auto i = 0u; i < components.size(); i++) {
+                reduced_components[components[i].first] = reduced[i];
             }
             return ReducedComponentCollection(reduced_components);
         }
@@ -498,16 +550,16 @@ namespace xsec {
         Vector
         ReducedComponentCollection::
         Predict(const Vector & user_params) const {
-            Matrix prediction = Matrix::Zero(fNInnerBins * fNOuterBins,
-                                             fComponents.size());
+            // components accumulate into one vector
+            Vector prediction = Vector::Zero(fNInnerBins * fNOuterBins);
             auto user_params_mat = user_params.reshaped(fNOuterBins,
                                                         fComponents.size());
             int i = 0;
             for (const auto & component : fComponents) {
-                prediction.col(i) = component.second->Predict(user_params_mat.col(i));
+                component.second->PredictAdd(user_params_mat.col(i), prediction);
                 i++;
             }
-            return prediction.rowwise().sum();
+            return prediction;
         }
 
         Vector
@@ -0,0 +1,172 @@
+#include "XSecAna/IterativeUnfolder.h"
+#include "XSecAna/Parallel.h"
+
+#include "TDirectory.h"
+#include "TH2D.h"
+#include "TObjString.h"
+#include "TParameter.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace xsec {
+    IterativeUnfolder::
+    IterativeUnfolder(const TH2 * response, int niterations)
+            : IterativeUnfolder(_response_matrix(response), niterations) {}
+
+    IterativeUnfolder::
+    IterativeUnfolder(const Eigen::SparseMatrix<double> & response, int niterations)
+            : fResponse(response), fNIterations(niterations) {
+        if (fResponse.rows() != fResponse.cols()) {
+            throw std::runtime_error("IterativeUnfolder: response must have as many reco bins as truth bins");
+        }
+        if (fNIterations < 1) {
+            throw std::runtime_error("IterativeUnfolder: need at least one iteration");
+        }
+        fResponse.makeCompressed();
+
+        // prior is the truth distribution of the response
+        fPrior = Vector::Zero(fResponse.cols());
+        for (auto j = 0; j < fResponse.outerSize(); j++) {
+            for (Eigen::SparseMatrix<double>::InnerIterator it(fResponse, j); it; ++it) {
+                fPrior(j) += it.value();
+            }
+        }
+        Vector inv_prior = (fPrior.array() == 0).select(0, 1. / fPrior.array());
+        fMigration = fResponse * inv_prior.asDiagonal();
+        fMigrationT = fMigration.transpose();
+    }
+
+    Eigen::SparseMatrix<double>
+    IterativeUnfolder::
+    _response_matrix(const TH2 * response) {
+        if (response->GetNbinsX() != response->GetNbinsY()) {
+            throw std::runtime_error("IterativeUnfolder: response must have as many reco bins as truth bins");
+        }
+        const int nx = response->GetNbinsX() + 2;
+        const int ny = response->GetNbinsY() + 2;
+        // ROOT global bins run fastest along x (reco)
+        auto contents = root::MapContentsToEigen(response).reshaped(nx, ny);
+        std::vector<Eigen::Triplet<double>> triplets;
+        for (auto j = 0; j < ny; j++) {
+            for (auto i = 0; i < nx; i++) {
+                if (contents(i, j) != 0) triplets.emplace_back(i, j, contents(i, j));
+            }
+        }
+        Eigen::SparseMatrix<double> ret(nx, ny);
+        ret.setFromTriplets(triplets.begin(), triplets.end());
+        return ret;
+    }
+
+    Matrix
+    IterativeUnfolder::
+    _unfold(const Matrix & reco, Matrix & prior, Matrix & folded) const {
+        prior = fPrior.replicate(1, reco.cols());
+        Matrix unfolded;
+        for (auto iter = 0; iter < fNIterations; iter++) {
+            if (iter > 0) prior.swap(unfolded);
+            folded = fMigration * prior;
+            Matrix ratio = (folded.array() > 0).select(reco.array() / folded.array(), 0);
+            unfolded = prior.cwiseProduct(fMigrationT * ratio);
+        }
+        return unfolded;
+    }
+
+    Matrix
+    IterativeUnfolder::
+    _variance(const Matrix & prior, const Matrix & folded, const Matrix & error) const {
+        // d t_j / d d_i = M_ij t_j / (M t)_i
+        Matrix inv_folded2 = (folded.array() > 0).select(1. / folded.array().square(), 0);
+        return prior.cwiseAbs2().cwiseProduct(fMigrationT.cwiseAbs2() * error.cwiseAbs2().cwiseProduct(inv_folded2));
+    }
+
+    void
+    IterativeUnfolder::
+    _for_column_blocks(std::size_t ncols, const std::function<void(std::size_t, std::size_t)> & fn) const {
+        if (ncols == 0) return;
+        const std::size_t nthreads = parallel::GetNThreads();
+        const std::size_t block_size = std::max<std::size_t>(1, (ncols + nthreads - 1) / nthreads);
+        const std::size_t nblocks = (ncols + block_size - 1) / block_size;
+        parallel::For(nblocks, [&](std::size_t iblock) {
+            auto first = iblock * block_size;
+            fn(first, std::min<std::size_t>(block_size, ncols - first));
+        });
+    }
+
+    Matrix
+    IterativeUnfolder::
+    Unfold(const Matrix & reco) const {
+        if (reco.rows() != fMigration.rows()) {
+            throw std::runtime_error("IterativeUnfolder: expected " + std::to_string(fMigration.rows()) +
+                                     " reco bins, got " + std::to_string(reco.rows()));
+        }
+        Matrix truth(fMigration.cols(), reco.cols());
+        _for_column_blocks(reco.cols(), [&](std::size_t first, std::size_t ncols) {
+            Matrix prior, folded;
+            truth.middleCols(first, ncols) = _unfold(reco.middleCols(first, ncols), prior, folded);
+        });
+        return truth;
+    }
+
+    void
+    IterativeUnfolder::
+    _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const {
+        Matrix prior, folded;
+        Matrix unfolded = _unfold(data.matrix(), prior, folded);
+        Matrix variance = _variance(prior, folded, error.matrix());
+        result = unfolded.array();
+        rerror = variance.array().sqrt();
+    }
+
+    void
+    IterativeUnfolder::
+    _eval_batch_impl(const Array2D & data, const Array2D & error, Array2DRef result, Array2DRef rerror) const {
+        _for_column_blocks(data.cols(), [&](std::size_t first, std::size_t ncols) {
+            // blocks are copied before writing so results may alias the inputs
+            Matrix prior, folded;
+            Matrix unfolded = _unfold(data.middleCols(first, ncols).matrix(), prior, folded);
+            Matrix variance = _variance(prior, folded, error.middleCols(first, ncols).matrix());
+            result.middleCols(first, ncols) = unfolded.array();
+            rerror.middleCols(first, ncols) = variance.array().sqrt();
+        });
+    }
+
+    std::shared_ptr<TH1>
+    IterativeUnfolder::
+    Truth(const TH1 * reco) const {
+        return this->Eval(reco);
+    }
+
+    void
+    IterativeUnfolder::
+    SaveTo(TDirectory * dir, const std::string & subdir) const {
+        TDirectory * tmp = gDirectory;
+        dir = dir->mkdir(subdir.c_str());
+        dir->cd();
+
+        TObjString("IterativeUnfolder").Write("type");
+        TParameter<int>("fNIterations", fNIterations).Write("fNIterations");
+
+        auto nbins = fResponse.rows() - 2;
+        TH2D response("", "", nbins, 0, nbins, nbins, 0, nbins);
+        response.SetContent(Matrix(fResponse).data());
+        response.Write("fResponse");
+
+        tmp->cd();
+    }
+
+    std::unique_ptr<IMeasurement>
+    IterativeUnfolder::
+    LoadFrom(TDirectory * dir, const std::string & subdir) {
+        dir = dir->GetDirectory(subdir.c_str());
+
+        // make sure we're loading the right type
+        auto ptag = (TObjString *) dir->Get("type");
+        assert(ptag->GetString() == "IterativeUnfolder" && "Type does not match IterativeUnfolder");
+        delete ptag;
+
+        auto niterations = ((TParameter<int> *) dir->Get("fNIterations"))->GetVal();
+        auto response = root::LoadTH1(dir, "fResponse");
+        return std::make_unique<IterativeUnfolder>((TH2 *) response.get(), niterations);
+    }
+}
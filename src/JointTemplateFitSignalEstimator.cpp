@@ -1,41 +1,104 @@
 #include "XSecAna/JointTemplateFitSignalEstimator.h"
 #include "XSecAna/Fit/JointTemplateFitComponent.h"
-#include "XSecAna/Fit/Minuit2TemplateFitter.h"
 #include "XSecAna/Utils.h"
+#include "XSecAna/Parallel.h"
 #include <algorithm>
 
 namespace xsec {
-    template<class T>
-    std::map<std::string, T>
-    JointTemplateFitSignalEstimator::
-    _invert_samples(const std::map<std::string, T> & samples) const {
-        std::map<std::string, T> inverted;
-        int i = fSampleEstimators.size()-1;
-        for(auto const & sample : samples) {
-            inverted[std::to_string(i) + sample.first] = sample.second;
-            i--;
-        }
-        return inverted;
-    }
-
     JointTemplateFitSignalEstimator::
     JointTemplateFitSignalEstimator(const std::map<std::string, fit::TemplateFitSample> & samples,
                                     const std::map<std::string, std::string> & component_conditioning,
                                     const TH1 * mask)
             : fReducer(mask) {
+        root::EnableThreadSafety();
         fJointEstimator = new TemplateFitSignalEstimator(fit::detail::_join(samples, component_conditioning), mask);
+
+        // per-sample estimators reuse the sample components reduced for the joint fit
+        // and blocks of its covariance matrices when possible
+        auto sample_components = _sample_reduced_components(samples);
+        std::vector<std::string> labels;
+        for(const auto & sample : samples) labels.push_back(sample.first);
+        std::vector<TemplateFitSignalEstimator *> estimators(labels.size());
+        if(!sample_components.empty()) {
+            std::map<std::string, Matrix> joint_covariances;
+            for(const auto & syst : fJointEstimator->GetSystematicLabels()) {
+                auto covariance = fJointEstimator->GetSystematicCovariance(syst);
+                joint_covariances[syst] = root::MapContentsToEigenInner(covariance)
+                        .matrix().reshaped(covariance->GetNbinsX(), covariance->GetNbinsX());
+            }
+            parallel::For(labels.size(), [&](std::size_t i) {
+                const auto & bins = fSampleBins.at(labels[i]);
+                std::map<std::string, Matrix> covariances;
+                for(const auto & covariance : joint_covariances) {
+                    covariances[covariance.first] = covariance.second(bins, bins);
+                }
+                estimators[i] = new TemplateFitSignalEstimator(samples.at(labels[i]), mask,
+                                                               sample_components.at(labels[i]),
+                                                               covariances);
+            });
+        }
+        else {
+            // With fewer estimators than threads they're built one at a time
+            // so each parallelizes over its systematics instead
+            parallel::For(labels.size(), [&](std::size_t i) {
+                estimators[i] = new TemplateFitSignalEstimator(samples.at(labels[i]), mask);
+            }, labels.size() >= parallel::GetNThreads() ? 0 : 1);
+        }
+        for(auto i = 0u; i < labels.size(); i++) {
+            fSampleEstimators[labels[i]] = estimators[i];
+        }
+    }
+
+    std::map<std::string, fit::ReducedComponentCollection>
+    JointTemplateFitSignalEstimator::
+    _sample_reduced_components(const std::map<std::string, fit::TemplateFitSample> & samples) {
+        // the joint covariance is calculated about the joined nominal templates,
+        // so its blocks only match per-sample covariances without alternative nominals
         for(const auto & sample : samples) {
-            fSampleEstimators[sample.first] = new TemplateFitSignalEstimator(sample.second, mask);
+            for(const auto & component : sample.second.components.GetComponents()) {
+                if(component.second->GetNominalForErrorCalculation() != component.second->GetNominal()) return {};
+            }
+        }
+
+        std::map<std::string, std::map<std::string, const fit::IReducedTemplateComponent *>> components;
+        for(const auto & component : fJointEstimator->GetReducedComponents()) {
+            auto joint_component = dynamic_cast<const fit::ReducedJointTemplateComponent *>(component.second);
+            if(!joint_component) return {};
+            for(const auto & sample : samples) {
+                if(sample.first == joint_component->GetConditioningSampleLabel()) {
+                    components[sample.first][component.first] = joint_component->GetConditioningComponent();
+                }
+                else {
+                    components[sample.first][component.first] = joint_component->GetComplimentaryComponent(sample.first);
+                }
+            }
+        }
+
+        std::map<std::string, fit::ReducedComponentCollection> ret;
+        for(const auto & sample : components) {
+            ret[sample.first] = fit::ReducedComponentCollection(sample.second);
+        }
+
+        // samples are joined in order along the inner (template) bins of each outer bin
+        const auto & joint = fJointEstimator->GetReducedComponentCollection();
+        int ninner = 0;
+        for(const auto & sample : ret) {
+            if(sample.second.GetNOuterBins() != joint.GetNOuterBins()) return {};
+            ninner += sample.second.GetNInnerBins();
         }
-        //std::map<std::string, fit::TemplateFitSample> inverted_samples = _invert_samples(samples);
-        // TODO remove the inverted fit
-        //fJointEstimatorInverse = new TemplateFitSignalEstimator(fit::detail::_join(inverted_samples, component_conditioning), mask);
-        //
-        //auto sample_it = fSampleEstimators.begin();
-        //fCondiSampleLabel = sample_it->first;
-        //sample_it++;
-        //
-        //fComplimentarySampleLabel = sample_it->first;
+        if(ninner != joint.GetNInnerBins()) return {};
+
+        int offset = 0;
+        for(const auto & sample : ret) {
+            auto & bins = fSampleBins[sample.first];
+            for(auto o = 0; o < joint.GetNOuterBins(); o++) {
+                for(auto i = 0; i < sample.second.GetNInnerBins(); i++) {
+                    bins.push_back(o * joint.GetNInnerBins() + offset + i);
+                }
+            }
+            offset += sample.second.GetNInnerBins();
+        }
+        return ret;
     }
 
     void
@@ -46,7 +109,6 @@ namespace xsec {
             sample.second->FixComponent(template_name, val);
         }
         fJointEstimator->FixComponent(template_name, val);
-        //fJointEstimatorInverse->FixComponent(template_name, val);
     }
 
     void
@@ -57,7 +119,6 @@ namespace xsec {
             sample.second->ReleaseComponent(template_name);
         }
         fJointEstimator->ReleaseComponent(template_name);
-        fJointEstimatorInverse->ReleaseComponent(template_name);
     }
 
     TH1 *
@@ -103,202 +164,53 @@ namespace xsec {
     }
 
 
-    //std::map<std::string, TemplateFitResult>
-    //JointTemplateFitSignalEstimator::
-    //Fit(const std::shared_ptr<TH1> data, int nrandom_seeds) const {
-    //    //return _joint_fit_result(fJointEstimator->Fit(data, nrandom_seeds));
-    //    return _joint_fit_result_run_inverse(fJointEstimator->Fit(data), data);
-    //}
-    //
-    //std::map<std::string, TemplateFitResult>
-    //JointTemplateFitSignalEstimator::
-    //Fit(const std::shared_ptr<TH1> data, fit::IFitter * fitter, int nrandom_seeds) {
-    //    //return _joint_fit_result(fJointEstimator->Fit(data, fitter, nrandom_seeds));
-    //    //return _joint_fit_result_run_inverse(fJointEstimator->Fit(data, fitter), data);
-    //}
-
     std::map<std::string, TH1*>
     JointTemplateFitSignalEstimator::
     ComplimentaryParams(const std::map<std::string, TH1*> & condi_params) const {
         std::map<std::string, TH1*> comp_params;
         for(const auto & component : condi_params) {
-            comp_params[component.first] = _condi_params_to_comp_params(component.first, component.second);
+            auto joint_component = (fit::ReducedJointTemplateComponent*)
+                    fJointEstimator->GetReducedComponent(component.first);
+            comp_params[component.first] = _condi_params_to_comp_params(component.first,
+                                                                        component.second,
+                                                                        joint_component->GetComplimentarySampleLabel());
+        }
+        return comp_params;
+    }
+
+    std::map<std::string, TH1*>
+    JointTemplateFitSignalEstimator::
+    ComplimentaryParams(const std::map<std::string, TH1*> & condi_params,
+                        const std::string & sample_label) const {
+        std::map<std::string, TH1*> comp_params;
+        for(const auto & component : condi_params) {
+            auto joint_component = (fit::ReducedJointTemplateComponent*)
+                    fJointEstimator->GetReducedComponent(component.first);
+            if(joint_component->GetConditioningSampleLabel() == sample_label) {
+                comp_params[component.first] = (TH1*) component.second->Clone();
+            }
+            else {
+                comp_params[component.first] = _condi_params_to_comp_params(component.first,
+                                                                            component.second,
+                                                                            sample_label);
+            }
         }
         return comp_params;
     }
 
     TH1 *
     JointTemplateFitSignalEstimator::
-    _condi_params_to_comp_params(const std::string & component_name, const TH1 * condi) const {
+    _condi_params_to_comp_params(const std::string & component_name,
+                                 const TH1 * condi,
+                                 const std::string & sample_label) const {
         Array _condi = fReducer.GetMap().ToMinimizerParams(root::MapContentsToEigen(condi));
         Array _comp =
                 ((fit::ReducedJointTemplateComponent*) fJointEstimator->GetReducedComponent(component_name))
-                        ->ComplimentaryParams(_condi);
+                        ->ComplimentaryParams(_condi, sample_label);
         return root::ToROOTLike(condi,
                                 fReducer.GetMap().ToUserParams(_comp));
     }
 
-    std::map<std::string, TH1*>
-    JointTemplateFitSignalEstimator::
-    InvertParams(const std::map<std::string, TH1*> & condi_params) const {
-        std::map<std::string, TH1 *> ret;
-        for (const auto & component: condi_params) {
-            Array inverted_component_param =
-                    ((fit::ReducedJointTemplateComponent *)
-                            fJointEstimatorInverse->GetReducedComponent(component.first))->ConditionalParams(
-                            fJointEstimatorInverse->ToCalculatorParamsComponent(component.second)
-                    );
-            ret[component.first] = fJointEstimatorInverse->ToUserParamsComponent(inverted_component_param);
-        }
-        return ret;
-    }
-
-    void
-    JointTemplateFitSignalEstimator::
-    _update_results_with_bias_uncertainty(TemplateFitResult & condi, TemplateFitResult & comp) const {
-
-        for(auto & component : condi.component_params) {
-            Array std_condi = fJointEstimator->ToCalculatorParamsComponent(component.second);
-            Array inv_condi =
-                    ((fit::ReducedJointTemplateComponent *)
-                            fJointEstimatorInverse->GetReducedComponent(component.first))->ComplimentaryParams(
-                            fJointEstimatorInverse->ToCalculatorParamsComponent(
-                                    comp.component_params.at(component.first))
-                    );
-
-            Array bias_error = (std_condi - inv_condi).pow(2);
-
-            Array fit_error_up = fJointEstimator->ToCalculatorParamsComponent(
-                    condi.component_params_error_up.at(component.first)
-            );
-            fit_error_up = fit_error_up.pow(2);
-
-            Array fit_error_down = fJointEstimator->ToCalculatorParamsComponent(
-                    condi.component_params_error_down.at(component.first)
-            );
-            fit_error_down = fit_error_down.pow(2);
-
-
-            Array total_error = ((fit_error_down > fit_error_up).select(fit_error_down, fit_error_up) +
-                    bias_error).sqrt();
-
-            condi.component_params_error_up.at(component.first) = fJointEstimator->ToUserParamsComponent(total_error);
-            condi.component_params_error_down.at(component.first) = fJointEstimator->ToUserParamsComponent(-1 * total_error);
-        }
-    }
-
-    std::map<std::string, TemplateFitResult>
-    JointTemplateFitSignalEstimator::
-    _joint_fit_result_run_inverse(TemplateFitResult condi_sample_fit_result,
-                                  const std::shared_ptr<TH1> inverted_data,
-                                  int nrandom_seeds) const {
-        std::cout << "Standard ordering fit done. Moving on to inverse ordering.\n";
-        std::map<std::string, TemplateFitResult> joint_results;
-
-        std::map<std::string, TH1*> inverted_seed = this->InvertParams(condi_sample_fit_result.component_params);
-
-        ((fit::Minuit2TemplateFitter*) fJointEstimator->GetFitter())->SetMinosErrors(false);
-        auto comp_sample_fit_result = fJointEstimatorInverse->Fit(inverted_data,
-                                                                  fJointEstimator->GetFitter(),
-                                                                  nrandom_seeds);
-
-        auto condi_sample_fit_result_with_bias_error = condi_sample_fit_result.Clone();
-        this->_update_results_with_bias_uncertainty(condi_sample_fit_result_with_bias_error, comp_sample_fit_result);
-
-        joint_results[fCondiSampleLabel] = condi_sample_fit_result;
-        joint_results[fCondiSampleLabel + "_with_bias_error"] = condi_sample_fit_result_with_bias_error;
-        joint_results[fComplimentarySampleLabel] = comp_sample_fit_result;
-
-        double chi2_inv = joint_results.at(fComplimentarySampleLabel).fun_val;
-        double chi2_std = condi_sample_fit_result.fun_val;
-        double chi2_diff = std::abs(chi2_inv - chi2_std);
-        double chi2_inv_at_std = fJointEstimatorInverse->Chi2(inverted_data,
-                                                              inverted_seed);
-        std::cout << "Inverted chi2 = " << chi2_inv << std::endl;
-        std::cout << "Standard chi2 = " << chi2_std << std::endl;
-        std::cout << "Difference = " << chi2_diff << std::endl;
-        std::cout << "Inverted chi2 at standard best fit parameters = " << chi2_inv_at_std << std::endl;
-        for(auto fixed_component : fFixedComponentLabels) {
-            _update_fixed_component_fit_result(joint_results.at(fCondiSampleLabel),
-                                               fixed_component,
-                                               fSampleEstimators.at(fCondiSampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-            _update_fixed_component_fit_result(joint_results.at(fCondiSampleLabel + "_with_bias_error"),
-                                               fixed_component,
-                                               fSampleEstimators.at(fCondiSampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-            _update_fixed_component_fit_result(joint_results.at(fComplimentarySampleLabel),
-                                               fixed_component,
-                                               fSampleEstimators.at(fComplimentarySampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-        }
-
-        return joint_results;
-    }
-
-    std::map<std::string, TemplateFitResult>
-    JointTemplateFitSignalEstimator::
-    _joint_fit_result_run_inverse(TemplateFitResult condi_sample_fit_result,
-                                  const std::shared_ptr<TH1> inverted_data,
-                                  const std::map<std::string, TH1*> & seed) const {
-        std::cout << "Standard ordering fit done. Moving on to inverse ordering.\n";
-        std::map<std::string, TemplateFitResult> joint_results;
-
-        std::map<std::string, TH1*> inverted_seed = this->InvertParams(seed);
-
-        ((fit::Minuit2TemplateFitter*) fJointEstimator->GetFitter())->SetMinosErrors(false);
-        auto comp_sample_fit_result = fJointEstimatorInverse->Fit(inverted_data,
-                                                                  fJointEstimator->GetFitter(),
-                                                                  inverted_seed);
-
-        auto condi_sample_fit_result_with_bias_error = condi_sample_fit_result.Clone();
-        this->_update_results_with_bias_uncertainty(condi_sample_fit_result_with_bias_error, comp_sample_fit_result);
-
-        joint_results[fCondiSampleLabel] = condi_sample_fit_result;
-        joint_results[fCondiSampleLabel + "_with_bias_error"] = condi_sample_fit_result_with_bias_error;
-        joint_results[fComplimentarySampleLabel] = comp_sample_fit_result;
-
-        double chi2_inv = joint_results.at(fComplimentarySampleLabel).fun_val;
-        double chi2_std = condi_sample_fit_result.fun_val;
-        double chi2_diff = std::abs(chi2_inv - chi2_std);
-        double chi2_inv_at_std = fJointEstimatorInverse->Chi2(inverted_data,
-                                                              this->InvertParams(comp_sample_fit_result.component_params));
-        std::cout << "Inverted chi2 = " << chi2_inv << std::endl;
-        std::cout << "Standard chi2 = " << chi2_std << std::endl;
-        std::cout << "Difference = " << chi2_diff << std::endl;
-        std::cout << "Inverted chi2 at standard best fit parameters = " << chi2_inv_at_std << std::endl;
-
-        for(auto fixed_component : fFixedComponentLabels) {
-            _update_fixed_component_fit_result(joint_results.at(fCondiSampleLabel),
-                                               fixed_component,
-                                               fSampleEstimators.at(fCondiSampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-            _update_fixed_component_fit_result(joint_results.at(fCondiSampleLabel + "_with_bias_error"),
-                                               fixed_component,
-                                               fSampleEstimators.at(fCondiSampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-            _update_fixed_component_fit_result(joint_results.at(fComplimentarySampleLabel),
-                                               fixed_component,
-                                               fSampleEstimators.at(fComplimentarySampleLabel)
-                                                       ->PrefitComponentUncertainty(fixed_component));
-        }
-
-        return joint_results;
-    }
-
-    void
-    JointTemplateFitSignalEstimator::
-    _update_fixed_component_fit_result(TemplateFitResult & result,
-                                       std::string component_label,
-                                       const Systematic<TH1> & prefit_error) const {
-        result.component_params_error_up.at(component_label) = (TH1*) prefit_error.Up()->Clone();
-        result.component_params_error_down.at(component_label) = (TH1*) prefit_error.Down()->Clone();
-
-        result.component_params_error_up.at(component_label)->Multiply(result.component_params.at(component_label));
-        result.component_params_error_down.at(component_label)->Multiply(result.component_params.at(component_label));
-    }
-
-
     std::map<std::string, TemplateFitResult>
     JointTemplateFitSignalEstimator::
     _joint_fit_result(const TemplateFitResult & joint_fit_result) const {
@@ -333,7 +245,6 @@ namespace xsec {
             fit::ReducedJointTemplateComponent * joint_component =
                     (fit::ReducedJointTemplateComponent*) fJointEstimator->GetReducedComponent(component.first);
             std::string condi_sample_label = joint_component->GetConditioningSampleLabel();
-            std::string comp_sample_label = joint_component->GetComplimentarySampleLabel();
 
             all_results[condi_sample_label].component_params[component.first] =
                     joint_fit_result.component_params.at(component.first);
@@ -342,16 +253,20 @@ namespace xsec {
             all_results[condi_sample_label].component_params_error_down[component.first] =
                     joint_fit_result.component_params_error_down.at(component.first);
 
-
-            all_results[comp_sample_label].component_params[component.first] =
-                    _condi_params_to_comp_params(component.first,
-                                                 joint_fit_result.component_params.at(component.first));
-            all_results[comp_sample_label].component_params_error_up[component.first] =
-                    _condi_params_to_comp_params(component.first,
-                                                 joint_fit_result.component_params_error_up.at(component.first));
-            all_results[comp_sample_label].component_params_error_down[component.first] =
-                    _condi_params_to_comp_params(component.first,
-                                                 joint_fit_result.component_params_error_down.at(component.first));
+            for(const auto & comp_sample_label : joint_component->GetComplimentarySampleLabels()) {
+                all_results[comp_sample_label].component_params[component.first] =
+                        _condi_params_to_comp_params(component.first,
+                                                     joint_fit_result.component_params.at(component.first),
+                                                     comp_sample_label);
+                all_results[comp_sample_label].component_params_error_up[component.first] =
+                        _condi_params_to_comp_params(component.first,
+                                                     joint_fit_result.component_params_error_up.at(component.first),
+                                                     comp_sample_label);
+                all_results[comp_sample_label].component_params_error_down[component.first] =
+                        _condi_params_to_comp_params(component.first,
+                                                     joint_fit_result.component_params_error_down.at(component.first),
+                                                     comp_sample_label);
+            }
         }
 
 
@@ -380,7 +295,6 @@ namespace xsec {
             fit::ReducedJointTemplateComponent * joint_component =
                     (fit::ReducedJointTemplateComponent*) fJointEstimator->GetReducedComponent(component.first);
             std::string condi_sample_label = joint_component->GetConditioningSampleLabel();
-            std::string comp_sample_label = joint_component->GetComplimentarySampleLabel();
 
 	    Array vcondi_param_variance_up = this->GetSampleTemplateFit(condi_sample_label)
 	      ->ToCalculatorParamsComponent(fit_results[condi_sample_label].component_params_error_up[component.first]);
@@ -391,26 +305,28 @@ namespace xsec {
 	    Array vcondi_param_variance = (vcondi_param_variance_up > vcondi_param_variance_down).select(vcondi_param_variance_up,
 													 vcondi_param_variance_down);
 
-	    Array vcomp_param_variance_up = this->GetSampleTemplateFit(comp_sample_label)
-	      ->ToCalculatorParamsComponent(fit_results[comp_sample_label].component_params_error_up[component.first]);
-	    vcomp_param_variance_up = vcomp_param_variance_up.square();
-	    Array vcomp_param_variance_down = this->GetSampleTemplateFit(comp_sample_label)
-	      ->ToCalculatorParamsComponent(fit_results[comp_sample_label].component_params_error_down[component.first]);
-	    vcomp_param_variance_down = vcomp_param_variance_down.square();
-	    Array vcomp_param_variance = (vcomp_param_variance_up > vcomp_param_variance_down).select(vcomp_param_variance_up,
-												      vcomp_param_variance_down);
-
 	    sample_fit_covariances.at(condi_sample_label)
 	      .block(component_idx * nouter_bins,
 		     component_idx * nouter_bins,
 		     nouter_bins,
 		     nouter_bins).diagonal() = vcondi_param_variance;
 
-	    sample_fit_covariances.at(comp_sample_label)
-	      .block(component_idx * nouter_bins,
-		     component_idx * nouter_bins,
-		     nouter_bins,
-		     nouter_bins).diagonal() = vcomp_param_variance;
+	    for (const auto & comp_sample_label : joint_component->GetComplimentarySampleLabels()) {
+		Array vcomp_param_variance_up = this->GetSampleTemplateFit(comp_sample_label)
+		  ->ToCalculatorParamsComponent(fit_results[comp_sample_label].component_params_error_up[component.first]);
+		vcomp_param_variance_up = vcomp_param_variance_up.square();
+		Array vcomp_param_variance_down = this->GetSampleTemplateFit(comp_sample_label)
+		  ->ToCalculatorParamsComponent(fit_results[comp_sample_label].component_params_error_down[component.first]);
+		vcomp_param_variance_down = vcomp_param_variance_down.square();
+		Array vcomp_param_variance = (vcomp_param_variance_up > vcomp_param_variance_down).select(vcomp_param_variance_up,
+													  vcomp_param_variance_down);
+
+		sample_fit_covariances.at(comp_sample_label)
+		  .block(component_idx * nouter_bins,
+			 component_idx * nouter_bins,
+			 nouter_bins,
+			 nouter_bins).diagonal() = vcomp_param_variance;
+	    }
 
 	    int cross_component_idx = -1;
 	    for (const auto & cross_component: fit_results.at("joint").component_params) {
@@ -459,10 +375,6 @@ namespace xsec {
     Fit(const std::map<std::string, std::shared_ptr<TH1>> data,
         int nrandom_seeds) const {
         return _joint_fit_result(fJointEstimator->Fit(JoinData(data), nrandom_seeds));
-        //return _joint_fit_result_run_inverse(fJointEstimator->Fit(JoinData(data), nrandom_seeds),
-        //                                     JoinData(_invert_samples(data)),
-        //                                     nrandom_seeds);
-        //return this->Fit(JoinData(data), nrandom_seeds);
     }
 
     std::map<std::string, TemplateFitResult>
@@ -470,9 +382,6 @@ namespace xsec {
     Fit(const std::map<std::string, std::shared_ptr<TH1>> data,
         fit::IFitter * fitter,
         int nrandom_seeds) {
-        //return _joint_fit_result_run_inverse(fJointEstimator->Fit(JoinData(data), fitter, nrandom_seeds),
-        //                                     JoinData(_invert_samples(data)),
-        //                                     nrandom_seeds);
         return _joint_fit_result(fJointEstimator->Fit(JoinData(data), fitter, nrandom_seeds));
     }
 
@@ -480,11 +389,7 @@ namespace xsec {
     JointTemplateFitSignalEstimator::
     Fit(const std::map<std::string, std::shared_ptr<TH1>> data,
         const std::map<std::string, TH1*> & seed) const {
-        //return _joint_fit_result_run_inverse(fJointEstimator->Fit(JoinData(data), seed),
-        //                                     JoinData(_invert_samples(data)),
-        //                                     seed);
         return _joint_fit_result(fJointEstimator->Fit(JoinData(data), seed));
-
     }
 
     std::map<std::string, TemplateFitResult>
@@ -492,8 +397,6 @@ namespace xsec {
     Fit(const std::map<std::string, std::shared_ptr<TH1>> data,
         fit::IFitter * fitter,
         const std::map<std::string, TH1*> & seed) {
-        return _joint_fit_result_run_inverse(fJointEstimator->Fit(JoinData(data), fitter, seed),
-                                             JoinData(_invert_samples(data)),
-                                             seed);
+        return _joint_fit_result(fJointEstimator->Fit(JoinData(data), fitter, seed));
     }
 }
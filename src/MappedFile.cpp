@@ -0,0 +1,106 @@
+#include "XSecAna/MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xsec {
+    MappedFile::
+    MappedFile(const std::string & path)
+            : fPath(path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Unable to stat " + path + ": " + std::strerror(errno));
+        }
+        fSize = info.st_size;
+        if (fSize > 0) {
+            void * addr = mmap(nullptr, fSize, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Unable to map " + path + ": " + std::strerror(errno));
+            }
+            fData = static_cast<const char *>(addr);
+        }
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+    }
+
+    MappedFile::
+    ~MappedFile() {
+        Unmap();
+    }
+
+    MappedFile::
+    MappedFile(MappedFile && other) noexcept
+            : fPath(std::move(other.fPath)),
+              fData(other.fData),
+              fSize(other.fSize) {
+        other.fData = nullptr;
+        other.fSize = 0;
+    }
+
+    MappedFile &
+    MappedFile::
+    operator=(MappedFile && other) noexcept {
+        if (this != &other) {
+            Unmap();
+            fPath = std::move(other.fPath);
+            fData = other.fData;
+            fSize = other.fSize;
+            other.fData = nullptr;
+            other.fSize = 0;
+        }
+        return *this;
+    }
+
+    void
+    MappedFile::
+    Unmap() {
+        if (fData) munmap(const_cast<char *>(fData), fSize);
+        fData = nullptr;
+        fSize = 0;
+    }
+
+    void
+    MappedFile::
+    CheckSignature(const detail::FileSignature & signature,
+                   const char * magic,
+                   std::initializer_list<std::uint64_t> versions,
+                   const std::string & description) const {
+        if (std::memcmp(signature.magic, magic, sizeof(signature.magic)) != 0) {
+            throw std::runtime_error(fPath + " is not a valid " + description);
+        }
+        for (auto version : versions) {
+            if (signature.version == version) return;
+        }
+        throw std::runtime_error(fPath + ": unsupported " + description + " version " +
+                                 std::to_string(signature.version));
+    }
+
+    detail::FileSignature
+    MappedFile::
+    Signature(const char * magic, std::uint64_t version) {
+        detail::FileSignature signature;
+        std::memcpy(signature.magic, magic, sizeof(signature.magic));
+        signature.version = version;
+        return signature;
+    }
+
+    void
+    MappedFile::
+    PadTo(std::ostream & file, std::size_t offset) {
+        std::string padding(offset - file.tellp(), '\0');
+        file.write(padding.data(), padding.size());
+    }
+}
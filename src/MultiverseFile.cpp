@@ -0,0 +1,427 @@
+#include "XSecAna/MultiverseFile.h"
+#include "XSecAna/Parallel.h"
+
+#include "RZip.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TH3D.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace xsec {
+    namespace {
+        const char kMagic[8] = {'X', 'S', 'M', 'V', 'F', 'I', 'L', 'E'};
+        const std::uint64_t kVersion = 1;
+        // largest buffer ROOT's compression routines handle in one call
+        const int kMaxZipBlock = 0xffffff;
+        const std::size_t kTargetChunkBytes = 4 << 20;
+
+        class MetadataWriter {
+        public:
+            template<class T>
+            void Put(const T & value) {
+                fBuffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+
+            void PutString(const std::string & value) {
+                Put<std::uint64_t>(value.size());
+                fBuffer.append(value);
+            }
+
+            const std::string & GetBuffer() const { return fBuffer; }
+
+        private:
+            std::string fBuffer;
+        };
+
+        class MetadataReader {
+        public:
+            MetadataReader(const char * data, std::size_t size)
+                    : fData(data), fSize(size) {}
+
+            template<class T>
+            T Get() {
+                T value;
+                std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+            std::string GetString() {
+                auto size = Get<std::uint64_t>();
+                return std::string(Take(size), size);
+            }
+
+        private:
+            const char * Take(std::size_t n) {
+                if (fPosition + n > fSize) {
+                    throw std::runtime_error("MultiverseFile: corrupt metadata");
+                }
+                auto ret = fData + fPosition;
+                fPosition += n;
+                return ret;
+            }
+
+            const char * fData;
+            std::size_t fSize;
+            std::size_t fPosition = 0;
+        };
+
+        void WriteAxis(MetadataWriter & writer, const TAxis * axis) {
+            writer.Put<std::uint64_t>(axis->GetNbins());
+            writer.Put<std::uint64_t>(axis->IsVariableBinSize());
+            writer.Put<double>(axis->GetXmin());
+            writer.Put<double>(axis->GetXmax());
+            if (axis->IsVariableBinSize()) {
+                for (auto i = 1; i <= axis->GetNbins() + 1; i++) {
+                    writer.Put<double>(axis->GetBinLowEdge(i));
+                }
+            }
+            writer.PutString(axis->GetTitle());
+        }
+
+        struct AxisInfo {
+            int nbins;
+            bool variable;
+            double xmin;
+            double xmax;
+            std::vector<double> edges;
+            std::string title;
+        };
+
+        AxisInfo ReadAxis(MetadataReader & reader) {
+            AxisInfo axis;
+            axis.nbins = reader.Get<std::uint64_t>();
+            axis.variable = reader.Get<std::uint64_t>();
+            axis.xmin = reader.Get<double>();
+            axis.xmax = reader.Get<double>();
+            if (axis.variable) {
+                axis.edges.resize(axis.nbins + 1);
+                for (auto & edge : axis.edges) edge = reader.Get<double>();
+            }
+            axis.title = reader.GetString();
+            return axis;
+        }
+
+        std::shared_ptr<TH1> MakeBinning(const std::vector<AxisInfo> & axes) {
+            auto name = root::MakeUnique("MultiverseFileBinning");
+            const auto & x = axes[0];
+            TH1 * h;
+            if (axes.size() == 1) {
+                h = new TH1D(name.c_str(), "", x.nbins, x.xmin, x.xmax);
+            }
+            else if (axes.size() == 2) {
+                const auto & y = axes[1];
+                h = new TH2D(name.c_str(), "", x.nbins, x.xmin, x.xmax, y.nbins, y.xmin, y.xmax);
+            }
+            else {
+                const auto & y = axes[1];
+                const auto & z = axes[2];
+                h = new TH3D(name.c_str(), "",
+                             x.nbins, x.xmin, x.xmax,
+                             y.nbins, y.xmin, y.xmax,
+                             z.nbins, z.xmin, z.xmax);
+            }
+            h->SetDirectory(0);
+            TAxis * haxes[3] = {h->GetXaxis(), h->GetYaxis(), h->GetZaxis()};
+            for (auto i = 0u; i < axes.size(); i++) {
+                if (axes[i].variable) haxes[i]->Set(axes[i].nbins, axes[i].edges.data());
+                haxes[i]->SetTitle(axes[i].title.c_str());
+            }
+            return std::shared_ptr<TH1>(h);
+        }
+
+        ///\brief Compress in blocks ROOT can handle.
+        /// Returns an empty string if the data doesn't compress
+        std::string Compress(const char * src, std::size_t nbytes, int compression) {
+            auto algorithm = (ROOT::RCompressionSetting::EAlgorithm::EValues) (compression / 100);
+            auto level = compression % 100;
+            std::string compressed;
+            for (std::size_t done = 0; done < nbytes; done += kMaxZipBlock) {
+                int srcsize = std::min<std::size_t>(kMaxZipBlock, nbytes - done);
+                // each block carries a 9 byte header
+                int tgtsize = srcsize + 9;
+                std::vector<char> block(tgtsize);
+                int irep = 0;
+                R__zipMultipleAlgorithm(level, &srcsize, const_cast<char *>(src + done),
+                                        &tgtsize, block.data(), &irep, algorithm);
+                if (irep <= 0 || compressed.size() + irep >= nbytes) return std::string();
+                compressed.append(block.data(), irep);
+            }
+            return compressed;
+        }
+
+        void Decompress(const char * src, std::size_t stored_bytes, char * tgt, std::size_t raw_bytes) {
+            auto usrc = reinterpret_cast<unsigned char *>(const_cast<char *>(src));
+            auto utgt = reinterpret_cast<unsigned char *>(tgt);
+            std::size_t read = 0;
+            std::size_t written = 0;
+            while (read < stored_bytes) {
+                int srcsize = 0;
+                int tgtsize = 0;
+                if (R__unzip_header(&srcsize, usrc + read, &tgtsize) != 0 ||
+                    read + srcsize > stored_bytes ||
+                    written + tgtsize > raw_bytes) {
+                    throw std::runtime_error("MultiverseFile: corrupt chunk");
+                }
+                int irep = 0;
+                R__unzip(&srcsize, usrc + read, &tgtsize, utgt + written, &irep);
+                if (irep != tgtsize) {
+                    throw std::runtime_error("MultiverseFile: failed to decompress chunk");
+                }
+                read += srcsize;
+                written += tgtsize;
+            }
+            if (written != raw_bytes) {
+                throw std::runtime_error("MultiverseFile: corrupt chunk");
+            }
+        }
+    }
+
+    void
+    MultiverseFile::
+    Write(const Systematic<TH1> & systematic,
+          const std::string & path,
+          int compression,
+          int universes_per_chunk,
+          bool store_errors) {
+        auto universes = systematic.GetUniverseMatrix();
+        if (!universes) universes = std::make_shared<MultiverseMatrix>(systematic.GetShifts());
+        store_errors &= universes->HasErrors();
+
+        const std::size_t nbins = universes->GetNBins();
+        const std::size_t nuniverses = universes->GetNUniverses();
+        const std::size_t block_bytes = nbins * nuniverses * sizeof(double);
+
+        MetadataWriter metadata;
+        metadata.PutString(systematic.GetName());
+        auto binning = universes->GetBinning();
+        metadata.Put<std::uint64_t>(binning->GetDimension());
+        const TAxis * axes[3] = {binning->GetXaxis(), binning->GetYaxis(), binning->GetZaxis()};
+        for (auto i = 0; i < binning->GetDimension(); i++) WriteAxis(metadata, axes[i]);
+
+        detail::MultiverseFileHeader header;
+        header.signature = MappedFile::Signature(kMagic, kVersion);
+        header.type = systematic.GetType();
+        header.nbins = nbins;
+        header.nuniverses = nuniverses;
+        header.has_errors = store_errors;
+        header.compression = std::max(0, compression);
+        header.metadata_offset = sizeof(header);
+        header.metadata_size = metadata.GetBuffer().size();
+        header.index_offset = MappedFile::Align(header.metadata_offset + header.metadata_size);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Unable to open " + path + " for writing");
+        }
+        if (header.compression == 0) {
+            header.universes_per_chunk = nuniverses;
+            header.nchunks = 1;
+            header.data_offset = header.index_offset;
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(metadata.GetBuffer().data(), metadata.GetBuffer().size());
+            MappedFile::PadTo(file, header.data_offset);
+            file.write(reinterpret_cast<const char *>(universes->GetMatrix().data()), block_bytes);
+            if (store_errors) {
+                file.write(reinterpret_cast<const char *>(universes->GetErrors().data()), block_bytes);
+            }
+        }
+        else {
+            const std::size_t universe_bytes = nbins * sizeof(double) * (store_errors ? 2 : 1);
+            if (universes_per_chunk <= 0) {
+                universes_per_chunk = std::max<std::size_t>(1, kTargetChunkBytes / universe_bytes);
+            }
+            header.universes_per_chunk = std::min<std::size_t>(universes_per_chunk, std::max<std::size_t>(1, nuniverses));
+            header.nchunks = (nuniverses + header.universes_per_chunk - 1) / header.universes_per_chunk;
+
+            // chunks are independent, so compress them in parallel
+            std::vector<std::string> chunks(header.nchunks);
+            std::vector<ChunkIndex> index(header.nchunks);
+            parallel::For(header.nchunks, [&](std::size_t ichunk) {
+                auto first = ichunk * header.universes_per_chunk;
+                auto n = std::min<std::size_t>(header.universes_per_chunk, nuniverses - first);
+                std::string raw(n * universe_bytes, '\0');
+                std::memcpy(&raw[0], universes->GetMatrix().col(first).data(), n * nbins * sizeof(double));
+                if (store_errors) {
+                    std::memcpy(&raw[n * nbins * sizeof(double)],
+                                universes->GetErrors().col(first).data(),
+                                n * nbins * sizeof(double));
+                }
+                chunks[ichunk] = Compress(raw.data(), raw.size(), header.compression);
+                // incompressible chunks are stored as is
+                if (chunks[ichunk].empty()) chunks[ichunk] = std::move(raw);
+                index[ichunk].raw_bytes = n * universe_bytes;
+                index[ichunk].stored_bytes = chunks[ichunk].size();
+            });
+
+            header.data_offset = MappedFile::Align(header.index_offset + header.nchunks * sizeof(ChunkIndex));
+            std::size_t offset = header.data_offset;
+            for (auto & entry : index) {
+                entry.offset = offset;
+                offset = MappedFile::Align(offset + entry.stored_bytes);
+            }
+
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(metadata.GetBuffer().data(), metadata.GetBuffer().size());
+            MappedFile::PadTo(file, header.index_offset);
+            file.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(ChunkIndex));
+            for (auto i = 0u; i < chunks.size(); i++) {
+                MappedFile::PadTo(file, index[i].offset);
+                file.write(chunks[i].data(), chunks[i].size());
+            }
+        }
+        if (!file) {
+            throw std::runtime_error("MultiverseFile: failed to write " + path);
+        }
+    }
+
+    MultiverseFile::
+    MultiverseFile(const std::string & path)
+            : fFile(path) {
+        fHeader = fFile.ReadHeader<detail::MultiverseFileHeader>(kMagic, {kVersion}, "multiverse file");
+        if (fHeader.metadata_offset + fHeader.metadata_size > fFile.size()) {
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        MetadataReader metadata(fFile.data() + fHeader.metadata_offset, fHeader.metadata_size);
+        fName = metadata.GetString();
+        std::vector<AxisInfo> axes(metadata.Get<std::uint64_t>());
+        for (auto & axis : axes) axis = ReadAxis(metadata);
+        fBinning = MakeBinning(axes);
+
+        const std::size_t block_bytes = fHeader.nbins * fHeader.nuniverses * sizeof(double);
+        std::size_t end;
+        if (IsCompressed()) {
+            end = fHeader.index_offset + fHeader.nchunks * sizeof(ChunkIndex);
+            if (end <= fFile.size() && fHeader.nchunks > 0) {
+                auto last = fFile.as<ChunkIndex>(fHeader.index_offset)[fHeader.nchunks - 1];
+                end = last.offset + last.stored_bytes;
+            }
+        }
+        else {
+            end = fHeader.data_offset + block_bytes * (HasErrors() ? 2 : 1);
+        }
+        if (end > fFile.size()) {
+            throw std::runtime_error(path + " is truncated");
+        }
+    }
+
+    void
+    MultiverseFile::
+    ReadChunks(std::size_t first, std::size_t n,
+               Matrix & contents, Matrix & errors, bool read_errors) const {
+        const std::size_t nbins = fHeader.nbins;
+        const std::size_t K = fHeader.universes_per_chunk;
+        contents.resize(nbins, n);
+        if (read_errors) errors.resize(nbins, n);
+        if (n == 0) return;
+
+        const auto index = fFile.as<ChunkIndex>(fHeader.index_offset);
+        const auto first_chunk = first / K;
+        const auto last_chunk = (first + n - 1) / K;
+        parallel::For(last_chunk - first_chunk + 1, [&](std::size_t i) {
+            const auto ichunk = first_chunk + i;
+            const auto & entry = index[ichunk];
+            const auto chunk_first = ichunk * K;
+            const auto chunk_n = std::min<std::size_t>(K, fHeader.nuniverses - chunk_first);
+
+            Matrix raw(nbins, chunk_n * (HasErrors() ? 2 : 1));
+            if (entry.raw_bytes != raw.size() * sizeof(double)) {
+                throw std::runtime_error("MultiverseFile: corrupt chunk index");
+            }
+            if (entry.stored_bytes == entry.raw_bytes) {
+                std::memcpy(raw.data(), fFile.data() + entry.offset, entry.raw_bytes);
+            }
+            else {
+                Decompress(fFile.data() + entry.offset, entry.stored_bytes,
+                           reinterpret_cast<char *>(raw.data()), entry.raw_bytes);
+            }
+
+            // overlap of [first, first + n) with this chunk
+            const auto lo = std::max(first, chunk_first);
+            const auto hi = std::min(first + n, chunk_first + chunk_n);
+            contents.middleCols(lo - first, hi - lo) = raw.middleCols(lo - chunk_first, hi - lo);
+            if (read_errors) {
+                errors.middleCols(lo - first, hi - lo) = raw.middleCols(chunk_n + lo - chunk_first, hi - lo);
+            }
+        });
+    }
+
+    Eigen::Map<const Matrix>
+    MultiverseFile::
+    Map(bool errors) const {
+        if (IsCompressed()) {
+            throw std::runtime_error("MultiverseFile: only uncompressed files can be mapped");
+        }
+        if (errors && !HasErrors()) {
+            throw std::runtime_error("MultiverseFile: " + fName + " has no errors");
+        }
+        auto offset = fHeader.data_offset +
+                      (errors ? fHeader.nbins * fHeader.nuniverses * sizeof(double) : 0);
+        return Eigen::Map<const Matrix>(fFile.as<double>(offset), fHeader.nbins, fHeader.nuniverses);
+    }
+
+    std::shared_ptr<MultiverseMatrix>
+    MultiverseFile::
+    ReadUniverses(std::size_t first, std::size_t n) const {
+        if (first + n > GetNUniverses()) {
+            throw std::out_of_range("MultiverseFile: universe range out of range");
+        }
+        Matrix contents;
+        Matrix errors;
+        if (IsCompressed()) {
+            ReadChunks(first, n, contents, errors, HasErrors());
+        }
+        else {
+            contents = Map().middleCols(first, n);
+            if (HasErrors()) errors = Map(true).middleCols(first, n);
+        }
+        return std::make_shared<MultiverseMatrix>(fBinning.get(), std::move(contents), std::move(errors));
+    }
+
+    std::shared_ptr<MultiverseMatrix>
+    MultiverseFile::
+    Read() const {
+        return ReadUniverses(0, GetNUniverses());
+    }
+
+    Matrix
+    MultiverseFile::
+    ReadBins(std::size_t first, std::size_t n, bool errors) const {
+        if (first + n > GetNBins()) {
+            throw std::out_of_range("MultiverseFile: bin range out of range");
+        }
+        if (!IsCompressed()) return Map(errors).middleRows(first, n);
+
+        if (errors && !HasErrors()) {
+            throw std::runtime_error("MultiverseFile: " + fName + " has no errors");
+        }
+        // chunks hold whole universes, so decompress a chunk at a time
+        // and only keep the requested rows
+        Matrix rows(n, GetNUniverses());
+        const std::size_t K = fHeader.universes_per_chunk;
+        parallel::For(fHeader.nchunks, [&](std::size_t ichunk) {
+            auto first_universe = ichunk * K;
+            auto nuniverses = std::min<std::size_t>(K, GetNUniverses() - first_universe);
+            Matrix contents;
+            Matrix chunk_errors;
+            ReadChunks(first_universe, nuniverses, contents, chunk_errors, errors);
+            rows.middleCols(first_universe, nuniverses) = (errors ? chunk_errors : contents).middleRows(first, n);
+        });
+        return rows;
+    }
+
+    Systematic<TH1>
+    MultiverseFile::
+    Load() const {
+        auto universes = Read();
+        if (GetType() == kMultiverse) {
+            return Systematic<TH1>(fName, universes);
+        }
+        auto shifts = universes->ToTH1s();
+        return Systematic<TH1>(fName, shifts, GetType());
+    }
+}
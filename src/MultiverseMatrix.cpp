@@ -0,0 +1,118 @@
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/Systematic.h"
+
+#include <stdexcept>
+
+namespace xsec {
+    namespace {
+        std::shared_ptr<TH1> EmptyClone(const TH1 * h) {
+            auto binning = std::shared_ptr<TH1>((TH1 *) h->Clone(root::MakeUnique("MultiverseBinning").c_str()));
+            binning->SetDirectory(0);
+            binning->Reset("ICESM");
+            return binning;
+        }
+    }
+
+    MultiverseMatrix::
+    MultiverseMatrix(const TH1 * binning,
+                     Matrix universes,
+                     Matrix errors)
+            : fBinning(EmptyClone(binning)),
+              fUniverses(std::move(universes)),
+              fErrors(std::move(errors)) {
+        if (fUniverses.rows() != root::TH1Props(binning).nbins_and_uof) {
+            throw std::runtime_error("MultiverseMatrix: number of rows does not match the binning");
+        }
+        if (HasErrors() && (fErrors.rows() != fUniverses.rows() || fErrors.cols() != fUniverses.cols())) {
+            throw std::runtime_error("MultiverseMatrix: errors and universes have different shapes");
+        }
+    }
+
+    MultiverseMatrix::
+    MultiverseMatrix(const std::vector<std::shared_ptr<TH1>> & universes) {
+        if (universes.empty()) {
+            throw std::runtime_error("MultiverseMatrix: no universes");
+        }
+        fBinning = EmptyClone(universes[0].get());
+        const auto nbins = root::TH1Props(universes[0].get()).nbins_and_uof;
+        fUniverses.resize(nbins, universes.size());
+        fErrors.resize(nbins, universes.size());
+        for (auto i = 0u; i < universes.size(); i++) {
+            fUniverses.col(i) = root::MapContentsToEigen(universes[i].get()).matrix();
+            fErrors.col(i) = root::MapErrorsToEigen(universes[i].get()).matrix();
+        }
+    }
+
+    std::shared_ptr<TH1>
+    MultiverseMatrix::
+    GetUniverse(std::size_t i) const {
+        root::TH1Props props(fBinning.get(), root::MakeUnique("universe").c_str());
+        if (HasErrors()) {
+            return std::shared_ptr<TH1>(root::ToROOT(fUniverses.col(i).array(),
+                                                     fErrors.col(i).array(),
+                                                     props));
+        }
+        return std::shared_ptr<TH1>(root::ToROOT(fUniverses.col(i).array(), props));
+    }
+
+    std::vector<std::shared_ptr<TH1>>
+    MultiverseMatrix::
+    ToTH1s() const {
+        std::vector<std::shared_ptr<TH1>> universes(GetNUniverses());
+        for (auto i = 0u; i < universes.size(); i++) {
+            universes[i] = GetUniverse(i);
+        }
+        return universes;
+    }
+
+    Vector
+    MultiverseMatrix::
+    Mean() const {
+        return fUniverses.rowwise().mean();
+    }
+
+    Matrix
+    MultiverseMatrix::
+    Covariance() const {
+        Matrix centered = fUniverses.colwise() - Mean();
+        Matrix cov = Matrix::Zero(GetNBins(), GetNBins());
+        cov.selfadjointView<Eigen::Lower>().rankUpdate(centered, 1. / GetNUniverses());
+        return cov.selfadjointView<Eigen::Lower>();
+    }
+
+    Array
+    MultiverseMatrix::
+    Shift(const Array & nominal, double nsigma) const {
+        return MultiverseShift(fUniverses, nominal, nsigma);
+    }
+
+    std::shared_ptr<MultiverseMatrix>
+    MultiverseMatrix::
+    Gather(const std::vector<int> & rows,
+           const TH1 * binning,
+           bool keep_errors) const {
+        keep_errors &= HasErrors();
+        Matrix universes = Matrix::Zero(rows.size(), GetNUniverses());
+        Matrix errors = keep_errors ? Matrix::Zero(rows.size(), GetNUniverses()) : Matrix();
+        for (auto i = 0u; i < rows.size(); i++) {
+            if (rows[i] < 0) continue;
+            universes.row(i) = fUniverses.row(rows[i]);
+            if (keep_errors) errors.row(i) = fErrors.row(rows[i]);
+        }
+        return std::make_shared<MultiverseMatrix>(binning, std::move(universes), std::move(errors));
+    }
+
+    Array
+    MultiverseShift(const Matrix & universes, const Array & nominal, double nsigma) {
+        if (nominal.size() != universes.rows()) {
+            throw std::runtime_error("MultiverseShift: nominal does not match the binning");
+        }
+        Array shift(universes.rows());
+        std::vector<double> values(universes.cols());
+        for (Eigen::Index ibin = 0; ibin < universes.rows(); ibin++) {
+            Eigen::Map<Vector>(values.data(), values.size()) = universes.row(ibin);
+            shift(ibin) = BinSigma(nsigma, values, nominal(ibin));
+        }
+        return shift;
+    }
+}
@@ -0,0 +1,191 @@
+#include "XSecAna/SVDUnfolder.h"
+#include "XSecAna/Parallel.h"
+
+#include "TDirectory.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TObjString.h"
+#include "TParameter.h"
+
+#include <stdexcept>
+
+namespace xsec {
+    namespace {
+        Matrix ResponseMatrix(const TH2 * response) {
+            if (response->GetNbinsX() != response->GetNbinsY()) {
+                throw std::runtime_error("SVDUnfolder: response must have as many reco bins as truth bins");
+            }
+            // ROOT global bins run fastest along x (reco)
+            return root::MapContentsToEigen(response).matrix()
+                    .reshaped(response->GetNbinsX() + 2, response->GetNbinsY() + 2);
+        }
+
+        ///\brief Discrete second derivative with eps subtracted from the diagonal.
+        // Its eigenvalues are in [-4 - eps, -eps], so it is invertible for any eps > 0.
+        Matrix CurvatureMatrix(int n, double eps) {
+            Matrix L = Matrix::Zero(n, n);
+            for (auto i = 0; i < n; i++) {
+                L(i, i) = -2 - eps;
+                if (i > 0) L(i, i - 1) = 1;
+                if (i < n - 1) L(i, i + 1) = 1;
+            }
+            L(0, 0) = -1 - eps;
+            L(n - 1, n - 1) = -1 - eps;
+            return L;
+        }
+
+        Matrix ReadMatrix(TDirectory * dir, const std::string & name) {
+            auto h = root::LoadTH1(dir, name);
+            return root::MapContentsToEigenInner(h.get()).matrix()
+                    .reshaped(h->GetNbinsX(), h->GetNbinsY());
+        }
+    }
+
+    SVDUnfolder::
+    SVDUnfolder(const TH2 * response, double tau, double eps)
+            : SVDUnfolder(ResponseMatrix(response), tau, eps) {}
+
+    SVDUnfolder::
+    SVDUnfolder(const Matrix & response, double tau, double eps) {
+        if (response.rows() != response.cols()) {
+            throw std::runtime_error("SVDUnfolder: response must have as many reco bins as truth bins");
+        }
+        if (eps <= 0) {
+            throw std::runtime_error("SVDUnfolder: eps must be positive");
+        }
+        Array truth = response.colwise().sum().transpose().array();
+        Vector inv_truth = (truth == 0).select(0, 1. / truth);
+        Matrix migration = response * inv_truth.asDiagonal();
+
+        // L is symmetric so A L^-1 = (L^-1 A^T)^T
+        Eigen::PartialPivLU<Matrix> curvature(CurvatureMatrix(response.cols(), eps));
+        Matrix standard_form = Matrix(curvature.solve(migration.transpose())).transpose();
+
+        Eigen::BDCSVD<Matrix> svd(standard_form, Eigen::ComputeThinU | Eigen::ComputeThinV);
+        fLeftSingularVectors = svd.matrixU();
+        fSingularValues = svd.singularValues();
+        fSolutionBasis = curvature.solve(svd.matrixV());
+        SetTau(tau);
+    }
+
+    SVDUnfolder::
+    SVDUnfolder(Matrix left_singular_vectors,
+                Vector singular_values,
+                Matrix solution_basis,
+                double tau)
+            : fLeftSingularVectors(std::move(left_singular_vectors)),
+              fSingularValues(std::move(singular_values)),
+              fSolutionBasis(std::move(solution_basis)) {
+        SetTau(tau);
+    }
+
+    Vector
+    SVDUnfolder::
+    _filter_factors(double tau) const {
+        return (fSingularValues.array() / (fSingularValues.array().square() + tau * tau)).matrix();
+    }
+
+    void
+    SVDUnfolder::
+    SetTau(double tau) {
+        fTau = tau;
+        fUnfoldingMatrix = fSolutionBasis * _filter_factors(tau).asDiagonal() * fLeftSingularVectors.transpose();
+    }
+
+    Matrix
+    SVDUnfolder::
+    Unfold(const Matrix & reco, double tau) const {
+        if (reco.rows() != fLeftSingularVectors.rows()) {
+            throw std::runtime_error("SVDUnfolder: expected " + std::to_string(fLeftSingularVectors.rows()) +
+                                     " reco bins, got " + std::to_string(reco.rows()));
+        }
+        if (tau == fTau) return fUnfoldingMatrix * reco;
+        return fSolutionBasis * (_filter_factors(tau).asDiagonal() * (fLeftSingularVectors.transpose() * reco));
+    }
+
+    std::vector<SVDUnfolder::ScanPoint>
+    SVDUnfolder::
+    ScanTau(const Vector & reco, const std::vector<double> & taus) const {
+        // coefficients of the data in the singular basis, shared by every tau
+        Array coefficients = (fLeftSingularVectors.transpose() * reco).array();
+        double perpendicular2 = std::max(0., reco.squaredNorm() - coefficients.matrix().squaredNorm());
+        Array s2 = fSingularValues.array().square();
+
+        std::vector<ScanPoint> scan(taus.size());
+        parallel::For(taus.size(), [&](std::size_t i) {
+            double tau2 = taus[i] * taus[i];
+            // A x - d = -U diag(tau^2 / (s^2 + tau^2)) U^T d - (1 - U U^T) d and L x = z
+            Array denominator = s2 + tau2;
+            scan[i].tau = taus[i];
+            scan[i].residual_norm = std::sqrt((tau2 * coefficients / denominator).square().sum() + perpendicular2);
+            scan[i].solution_norm = std::sqrt((fSingularValues.array() * coefficients / denominator).square().sum());
+        });
+        return scan;
+    }
+
+    void
+    SVDUnfolder::
+    _eval_impl(const Array & data, const Array & error, ArrayRef result, ArrayRef rerror) const {
+        result = (fUnfoldingMatrix * data.matrix()).array();
+        rerror = (fUnfoldingMatrix.cwiseAbs2() * error.square().matrix()).array().sqrt();
+    }
+
+    void
+    SVDUnfolder::
+    _eval_batch_impl(const Array2D & data, const Array2D & error, Array2DRef result, Array2DRef rerror) const {
+        result = (fUnfoldingMatrix * data.matrix()).array();
+        rerror = (fUnfoldingMatrix.cwiseAbs2() * error.square().matrix()).array().sqrt();
+    }
+
+    std::shared_ptr<TH1>
+    SVDUnfolder::
+    Truth(const TH1 * reco) const {
+        return this->Eval(reco);
+    }
+
+    void
+    SVDUnfolder::
+    SaveTo(TDirectory * dir, const std::string & subdir) const {
+        TDirectory * tmp = gDirectory;
+        dir = dir->mkdir(subdir.c_str());
+        dir->cd();
+
+        TObjString("SVDUnfolder").Write("type");
+        TParameter<double>("fTau", fTau).Write("fTau");
+
+        auto write_matrix = [](const Matrix & m, const char * name) {
+            TH2D h("", "", m.rows(), 0, m.rows(), m.cols(), 0, m.cols());
+            root::FillTH2Contents(&h, m);
+            h.Write(name);
+        };
+        write_matrix(fLeftSingularVectors, "fLeftSingularVectors");
+        write_matrix(fSolutionBasis, "fSolutionBasis");
+
+        TH1D singular_values("", "", fSingularValues.size(), 0, fSingularValues.size());
+        Array contents = Array::Zero(fSingularValues.size() + 2);
+        contents.segment(1, fSingularValues.size()) = fSingularValues.array();
+        singular_values.SetContent(contents.data());
+        singular_values.Write("fSingularValues");
+
+        tmp->cd();
+    }
+
+    std::unique_ptr<IMeasurement>
+    SVDUnfolder::
+    LoadFrom(TDirectory * dir, const std::string & subdir) {
+        dir = dir->GetDirectory(subdir.c_str());
+
+        // make sure we're loading the right type
+        auto ptag = (TObjString *) dir->Get("type");
+        assert(ptag->GetString() == "SVDUnfolder" && "Type does not match SVDUnfolder");
+        delete ptag;
+
+        auto tau = ((TParameter<double> *) dir->Get("fTau"))->GetVal();
+        auto singular_values = root::LoadTH1(dir, "fSingularValues");
+        return std::unique_ptr<IMeasurement>(
+                new SVDUnfolder(ReadMatrix(dir, "fLeftSingularVectors"),
+                                root::MapContentsToEigenInner(singular_values.get()).matrix(),
+                                ReadMatrix(dir, "fSolutionBasis"),
+                                tau));
+    }
+}
@@ -31,6 +31,15 @@ namespace xsec {
         rerror = QuadSum(error, root::MapErrorsToEigen(fBackground));
     }
 
+    //////////////////////////////////////////////////////////
+    void
+    SimpleSignalEstimator::
+    _eval_batch_impl(const Array2D & data, const Array2D & error, Array2DRef result, Array2DRef rerror) const {
+        Array background_e2 = root::MapErrorsToEigen(fBackground).square();
+        rerror = (error.square().colwise() + background_e2).sqrt();
+        result = data.colwise() - root::MapContentsToEigen(fBackground);
+    }
+
     //////////////////////////////////////////////////////////
     TH1 *
     SimpleSignalEstimator::
@@ -4,6 +4,7 @@
 
 #include "XSecAna/Systematic.h"
 #include "XSecAna/IMeasurement.h"
+#include "XSecAna/MultiverseMatrix.h"
 #include "XSecAna/Utils.h"
 
 #include <stdexcept>
@@ -45,6 +46,19 @@ namespace xsec {
               fType(type),
               fName(std::move(name)) { fContainer.shrink_to_fit(); }
 
+    template<class T>
+    Systematic<T>::
+    Systematic(std::string name,
+               std::shared_ptr<const MultiverseMatrix> universes)
+            : fType(kMultiverse),
+              fName(std::move(name)),
+              fUniverseMatrix(std::move(universes)),
+              fShiftCache(std::make_shared<ShiftCache>()) {
+        if constexpr(!std::is_same<T, TH1>::value) {
+            throw std::runtime_error("Only Systematic<TH1> can be backed by a MultiverseMatrix");
+        }
+    }
+
     /*
     template<class T>
     Systematic<T>::
@@ -99,7 +113,24 @@ namespace xsec {
     template<class T>
     const std::vector<std::shared_ptr<T>> &
     Systematic<T>::
-    GetShifts() const { return fContainer; }
+    GetShifts() const {
+        if constexpr(std::is_same<T, TH1>::value) {
+            if (fUniverseMatrix) {
+                std::call_once(fShiftCache->flag, [this]() {
+                    fShiftCache->shifts = fUniverseMatrix->ToTH1s();
+                });
+                return fShiftCache->shifts;
+            }
+        }
+        return fContainer;
+    }
+
+    template<class T>
+    std::size_t
+    Systematic<T>::
+    GetNShifts() const {
+        return fUniverseMatrix ? fUniverseMatrix->GetNUniverses() : fContainer.size();
+    }
 
     /////////////////////////////////////////////////////////////////////////
     template<class T>
@@ -108,9 +139,10 @@ namespace xsec {
     Systematic<T>::
     ForEach(ForEachFunction<U, T> for_each, std::string new_name) {
         if (new_name == "") new_name = this->fName;
-        std::vector<std::shared_ptr<U>> container(this->fContainer.size());
-        for (auto i = 0u; i < this->fContainer.size(); i++) {
-            container[i] = for_each(this->fContainer[i]);
+        const auto & shifts = this->GetShifts();
+        std::vector<std::shared_ptr<U>> container(shifts.size());
+        for (auto i = 0u; i < shifts.size(); i++) {
+            container[i] = for_each(shifts[i]);
         }
         return Systematic<U>(new_name, container, fType);
 
@@ -173,63 +205,47 @@ namespace xsec {
                                      std::string(typeid(T).name()) +
                                      " does not implement CovarianceMatrix. Must be of type Systematic<TH1>.");
         } else {
-            std::vector<Array> shifts(fContainer.size());
-            for(auto i = 0u; i < fContainer.size(); i++) {
-                shifts[i] = root::MapContentsToEigen(fContainer[i].get());
-            }
-
             Array nom_a = root::MapContentsToEigen(nominal);
             Matrix cov(nom_a.size(), nom_a.size());
-            if(fType == kOneSided) {
-                for (auto i = 0; i < nom_a.size(); i++) {
-                    for (auto j = 0; j < nom_a.size(); j++) {
-                        cov(i, j) = (nom_a(i) - shifts[0](i)) *
-                                    (nom_a(j) - shifts[0](j));
-                    }
-                }
+            if (fType == kMultiverse) {
+                // universes as one matrix, so the covariance is a single rank-k update
+                if (fUniverseMatrix) cov = fUniverseMatrix->Covariance();
+                else cov = MultiverseMatrix(fContainer).Covariance();
             }
-            else if(fType == kTwoSided) {
-                for (auto i = 0; i < nom_a.size(); i++) {
-                    for (auto j = 0; j < nom_a.size(); j++) {
-
-                        auto di_0 = nom_a(i) - shifts[0](i);
-                        auto di_1 = nom_a(i) - shifts[1](i);
-                        auto dj_0 = nom_a(j) - shifts[0](j);
-                        auto dj_1 = nom_a(j) - shifts[1](j);
-                        auto di = (std::abs(di_0) > std::abs(di_1)) ? di_0 : di_1;
-                        auto dj = (std::abs(dj_0) > std::abs(dj_1)) ? dj_0 : dj_1;
-
-                        //cov(i, j) = di * dj;
-                        cov(i, j) = (di_0 * dj_0 + di_1 * dj_1) / 2;
-                    }
+            else {
+                std::vector<Array> shifts(fContainer.size());
+                for (auto i = 0u; i < fContainer.size(); i++) {
+                    shifts[i] = root::MapContentsToEigen(fContainer[i].get());
                 }
-            }
-            else { // multiverse
-                std::vector<double> multiverse_means(nom_a.size(), 0);
-                for(auto ibin = 0u; ibin < nom_a.size(); ibin++) {
-                    for(auto imv = 0u; imv < shifts.size(); imv++) {
-                        multiverse_means[ibin] += shifts[imv][ibin];
+                if(fType == kOneSided) {
+                    for (auto i = 0; i < nom_a.size(); i++) {
+                        for (auto j = 0; j < nom_a.size(); j++) {
+                            cov(i, j) = (nom_a(i) - shifts[0](i)) *
+                                        (nom_a(j) - shifts[0](j));
+                        }
                     }
-                    multiverse_means[ibin] /= shifts.size();
                 }
-
-                 for (auto i = 0; i < nom_a.size(); i++) {
-                    for (auto j = 0; j < nom_a.size(); j++) {
-
-                        double v = 0;
-                        for(auto u = 0u; u < shifts.size(); u++) {
-                            //v += (shifts[u](i) - nom_a(i)) *
-                            //     (shifts[u](j) - nom_a(j));
-                            v += (shifts[u](i) - multiverse_means[i]) *
-                                 (shifts[u](j) - multiverse_means[j]);
+                else if(fType == kTwoSided) {
+                    for (auto i = 0; i < nom_a.size(); i++) {
+                        for (auto j = 0; j < nom_a.size(); j++) {
+
+                            auto di_0 = nom_a(i) - shifts[0](i);
+                            auto di_1 = nom_a(i) - shifts[1](i);
+                            auto dj_0 = nom_a(j) - shifts[0](j);
+                            auto dj_1 = nom_a(j) - shifts[1](j);
+                            auto di = (std::abs(di_0) > std::abs(di_1)) ? di_0 : di_1;
+                            auto dj = (std::abs(dj_0) > std::abs(dj_1)) ? dj_0 : dj_1;
+
+                            //cov(i, j) = di * dj;
+                            cov(i, j) = (di_0 * dj_0 + di_1 * dj_1) / 2;
                         }
-                        cov(i, j) =  v / (fContainer.size());
                     }
                 }
             }
             auto ret = new TH2D("", "",
                                 nom_a.size()-2, 0, nom_a.size()-2,
                                 nom_a.size()-2, 0, nom_a.size()-2);
+            ret->SetDirectory(nullptr);
             ret->SetContent(cov.data());
             ret->SetEntries(cov.size());
             return ret;
@@ -286,14 +302,15 @@ namespace xsec {
 
         TObjString("Systematic").Write("type");
         TObjString(this->fName.c_str()).Write("fName");
-        TObjString(std::to_string(this->fContainer.size()).c_str()).Write("NShifts");
+        TObjString(std::to_string(this->GetNShifts()).c_str()).Write("NShifts");
         TObjString(std::to_string(this->fType).c_str()).Write("fType");
 
         auto mv_dir = dir->mkdir("fContainer");
         if constexpr(std::is_same<T, TH1>::value) {
             mv_dir->cd();
-            for (auto i = 0u; i < fContainer.size(); i++) {
-                fContainer[i]->Write(std::to_string(i).c_str());
+            const auto & shifts = GetShifts();
+            for (auto i = 0u; i < shifts.size(); i++) {
+                shifts[i]->Write(std::to_string(i).c_str());
             }
         } else if constexpr(std::is_same<T, Array>::value) {
             auto tmp = new TH1D("", "",
@@ -382,17 +399,16 @@ namespace xsec {
                                                   multiverse.GetType());
         }
         root::TH1Props props(nominal);
-        Array shift_arr(props.nbins_and_uof);
-        for (auto ibin = 0u; ibin < shift_arr.size(); ibin++) {
-            std::vector<double> vals_c(multiverse.GetShifts().size());
-            for (auto iuniv = 0u; iuniv < multiverse.GetShifts().size(); iuniv++) {
-                vals_c[iuniv] = multiverse.GetShifts()[iuniv]->GetBinContent(ibin);
-            }
-            shift_arr(ibin) = BinSigma(nsigma, vals_c, nominal->GetBinContent(ibin));
-        }
+        auto universes = multiverse.GetUniverseMatrix();
+        if (!universes) universes = std::make_shared<MultiverseMatrix>(multiverse.GetShifts());
+        Array shift_arr = universes->Shift(root::MapContentsToEigen(nominal), nsigma);
         return root::ToROOTLike(nominal, shift_arr, Array::Zero(props.nbins_and_uof));
     }
 
+    template
+    double
+    BinSigma(const double &, std::vector<double> &, const double &);
+
     template
     class Systematic<Array>;
 
@@ -3,11 +3,16 @@
 //
 #include "XSecAna/TemplateFitSignalEstimator.h"
 #include "XSecAna/SimpleQuadSum.h"
+#include "XSecAna/Fit/ProfileScanner.h"
+#include "XSecAna/Parallel.h"
 #include "TGaxis.h"
 #include "TVectorD.h"
 #include "TObjString.h"
 #include "TKey.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <random>
 #include <iostream>
 #include <iomanip>
@@ -30,7 +35,8 @@ namespace xsec {
                 _component_params_up,
                 _component_params_down,
                 (TH2D*) this->covariance->Clone(),
-                this->fun_calls};
+                this->fun_calls,
+                this->is_valid};
     }
 
     void
@@ -56,9 +62,11 @@ namespace xsec {
 
         TVectorD _fun_calls(1); _fun_calls[0] = fun_calls;
         TVectorD _fun_val(1); _fun_val[0] = fun_val;
+        TVectorD _is_valid(1); _is_valid[0] = is_valid;
 
         _fun_calls.Write("fun_calls");
         _fun_val.Write("fun_val");
+        _is_valid.Write("is_valid");
 
         dir->cd();
     }
@@ -78,6 +86,10 @@ namespace xsec {
         }
         ret->fun_calls = (*((TVectorD*)subdir->Get("fun_calls")))[0];
         ret->fun_val = (*((TVectorD*)subdir->Get("fun_val")))[0];
+        // results saved before the flag was stored were always valid
+        if(subdir->GetListOfKeys()->Contains("is_valid")) {
+            ret->is_valid = (*((TVectorD*)subdir->Get("is_valid")))[0];
+        }
 
         for(const auto&& obj : *subdir->GetListOfKeys()) {
             if(std::string(((TKey*) obj)->GetClassName()) == "TDirectoryFile") {
@@ -97,7 +109,7 @@ namespace xsec {
     TemplateFitSignalEstimator::
     GetSystematicLabels() const {
         std::vector<std::string> ret;
-        for (auto syst: fSystematics) {
+        for (const auto & syst: fCovarianceMatrices) {
             ret.push_back(syst.first);
         }
         return ret;
@@ -108,8 +120,71 @@ namespace xsec {
                                const TH1 * mask)
             : fReducer(mask),
               fUserComponents(sample.components) {
+        root::EnableThreadSafety();
         fReducedComponents = fUserComponents.Reduce(fReducer);
+        _setup_binning(mask);
+
+        // reduce each systematic and calculate its covariance matrix independently
+        std::vector<std::pair<std::string, Systematic<TH1>>> systematics(sample.shape_only_systematics.begin(),
+                                                                         sample.shape_only_systematics.end());
+        std::vector<TH1 *> covariances(systematics.size());
+        parallel::For(systematics.size(), [&](std::size_t i) {
+            systematics[i].second = fReducer.Reduce(systematics[i].second);
+            covariances[i] = systematics[i].second.CovarianceMatrix(fTotalTemplate);
+            covariances[i]->GetXaxis()->SetTitle("Template Bins");
+            covariances[i]->GetYaxis()->SetTitle("Template Bins");
+            covariances[i]->SetTitle((systematics[i].first + " Covariance").c_str());
+        });
+
+        // sum in a fixed order so the total doesn't depend on scheduling
+        fTotalCovariance = _covariance_hist("Total Covariance");
+        for (auto i = 0u; i < systematics.size(); i++) {
+            fSystematics[systematics[i].first] = systematics[i].second;
+            fCovarianceMatrices[systematics[i].first] = covariances[i];
+            fTotalCovariance->Add(covariances[i]);
+        }
+
+        Matrix total_covariance = _covariance_matrix(fTotalCovariance);
+        fFitCalc = new fit::TemplateFitCalculator(fReducedComponents,
+                                                  {fReducedComponents.GetNOuterBins(),
+                                                   fReducedComponents.GetNInnerBins()},
+                                                  total_covariance);
+
+    }
+
+    TemplateFitSignalEstimator::
+    TemplateFitSignalEstimator(const fit::TemplateFitSample & sample,
+                               const TH1 * mask,
+                               const fit::ReducedComponentCollection & reduced_components,
+                               const std::map<std::string, Matrix> & covariances)
+            : fReducer(mask),
+              fUserComponents(sample.components),
+              fReducedComponents(reduced_components) {
+        _setup_binning(mask);
+
+        const int nbins = fTotalTemplate->GetNbinsX();
+        Matrix total_covariance = Matrix::Zero(nbins, nbins);
+        for (const auto & covariance : covariances) {
+            if (covariance.second.rows() != nbins || covariance.second.cols() != nbins) {
+                throw std::runtime_error("Covariance of " + covariance.first + " doesn't match the reduced templates");
+            }
+            auto hist = _covariance_hist(covariance.first + " Covariance");
+            root::FillTH2Contents(hist, covariance.second);
+            fCovarianceMatrices[covariance.first] = hist;
+            total_covariance += covariance.second;
+        }
+        fTotalCovariance = _covariance_hist("Total Covariance");
+        root::FillTH2Contents((TH2D *) fTotalCovariance, total_covariance);
 
+        fFitCalc = new fit::TemplateFitCalculator(fReducedComponents,
+                                                  {fReducedComponents.GetNOuterBins(),
+                                                   fReducedComponents.GetNInnerBins()},
+                                                  total_covariance);
+    }
+
+    void
+    TemplateFitSignalEstimator::
+    _setup_binning(const TH1 * mask) {
         int icomponent = 0;
         for (const auto & component: fReducedComponents.GetComponents()) {
             fComponentIdx[component.first] = icomponent;
@@ -138,16 +213,12 @@ namespace xsec {
         } else {
             throw std::runtime_error("Template fits with greater than 2 outer dimensions not supported");
         }
+        project_predictions_like->SetDirectory(nullptr);
         // root won't draw histogram unless there are entries
         project_predictions_like->SetEntries(1);
         fProjectPredictionProps = root::TH1Props(project_predictions_like);
         fPredictionProps = root::TH1Props(tmp_component.get());
 
-        // create reduced systematics
-        for (auto syst: sample.shape_only_systematics) {
-            fSystematics[syst.first] = fReducer.Reduce(syst.second);
-        }
-
         // masked parameter map
         auto outer_map = root::MapContentsToEigen(mask);
         fOuterBinMap = fit::detail::ParamMap(outer_map);
@@ -163,48 +234,206 @@ namespace xsec {
         for (const auto & component: fReducedComponents.GetComponents()) {
             if (!fTotalTemplate) {
                 fTotalTemplate = (TH1 *) component.second->GetNominalForErrorCalculation()->GetHist()->Clone();
+                fTotalTemplate->SetDirectory(nullptr);
             } else {
                 fTotalTemplate->Add(component.second->GetNominalForErrorCalculation()->GetHist().get());
             }
         }
+    }
 
-        // calculate and store covariance matrices
-        fTotalCovariance = new TH2D("", "",
-                                    fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX(),
-                                    fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX());
-        fTotalCovariance->SetTitle("Total Covariance");
-        fTotalCovariance->GetXaxis()->SetTitle("Template Bins");
-        fTotalCovariance->GetYaxis()->SetTitle("Template Bins");
-        for (auto systematic: fSystematics) {
-            fCovarianceMatrices[systematic.first] = systematic.second.CovarianceMatrix(fTotalTemplate);
-            fCovarianceMatrices.at(systematic.first)->GetXaxis()->SetTitle("Template Bins");
-            fCovarianceMatrices.at(systematic.first)->GetYaxis()->SetTitle("Template Bins");
-            fCovarianceMatrices.at(systematic.first)->SetTitle((systematic.first + " Covariance").c_str());
+    TH2D *
+    TemplateFitSignalEstimator::
+    _covariance_hist(const std::string & title) const {
+        auto ret = new TH2D("", "",
+                            fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX(),
+                            fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX());
+        ret->SetDirectory(nullptr);
+        ret->SetTitle(title.c_str());
+        ret->GetXaxis()->SetTitle("Template Bins");
+        ret->GetYaxis()->SetTitle("Template Bins");
+        return ret;
+    }
 
-            fTotalCovariance->Add(fCovarianceMatrices.at(systematic.first));
+    Matrix
+    TemplateFitSignalEstimator::
+    _covariance_matrix(const TH1 * covariance) {
+        return root::MapContentsToEigenInner(covariance)
+                .matrix().reshaped(covariance->GetNbinsX(),
+                                   covariance->GetNbinsX());
+    }
 
+    TemplateFitSignalEstimator::
+    TemplateFitSignalEstimator(const fit::TemplateFitSample & sample,
+                               const TH1 * mask,
+                               std::shared_ptr<const ArrayFile> snapshot)
+            : fReducer(mask),
+              fUserComponents(sample.components) {
+        if (!snapshot->Has("type") || snapshot->GetString("type") != "TemplateFitSignalEstimator") {
+            throw std::runtime_error(snapshot->GetPath() + " is not a TemplateFitSignalEstimator snapshot");
+        }
+        auto dims = snapshot->GetInts("dims");
+        Array outer_map = root::MapContentsToEigen(mask);
+        auto snapshot_mask = snapshot->GetMatrix("mask");
+        if (snapshot_mask.size() != outer_map.size() ||
+            ((snapshot_mask.array() != 0) != (outer_map != 0)).any()) {
+            throw std::runtime_error(snapshot->GetPath() + " was made with a different mask");
+        }
+        if ((int) fUserComponents.GetComponents().size() != dims(2)) {
+            throw std::runtime_error(snapshot->GetPath() + " was made with different components");
         }
 
-        Matrix total_covariance = root::MapContentsToEigenInner(fTotalCovariance)
-                .matrix().reshaped(fTotalCovariance->GetNbinsX(),
-                                   fTotalCovariance->GetNbinsX());
-        fFitCalc = new fit::TemplateFitCalculator(fReducedComponents,
-                                                  {fReducedComponents.GetNOuterBins(),
-                                                   fReducedComponents.GetNInnerBins()},
-                                                  total_covariance);
+        // the reduced templates are small, so they're copied out of the snapshot
+        std::map<std::string, const fit::IReducedTemplateComponent *> components;
+        for (const auto & component : fUserComponents.GetComponents()) {
+            auto prefix = "components/" + component.first + "/";
+            if (!snapshot->Has(prefix + "nominal")) {
+                throw std::runtime_error(snapshot->GetPath() + " has no component " + component.first);
+            }
+            auto nominal = new fit::ReducedComponent(Vector(snapshot->GetMatrix(prefix + "nominal")),
+                                                     dims(0), dims(1));
+            if (snapshot->Has(prefix + "nominal_for_error_calculation")) {
+                auto nominal_for_error_calc = new fit::ReducedComponent(
+                        Vector(snapshot->GetMatrix(prefix + "nominal_for_error_calculation")),
+                        dims(0), dims(1));
+                components[component.first] = new fit::ReducedTemplateComponentAlternativeNominal(
+                        nominal, {}, nominal_for_error_calc);
+            }
+            else {
+                components[component.first] = new fit::ReducedTemplateComponent(nominal);
+            }
+        }
+        fReducedComponents = fit::ReducedComponentCollection(components);
+        _setup_binning(mask);
+
+        // covariance histograms are only built if asked for
+        fSnapshot = snapshot;
+        const std::string covariance_prefix = "covariance/";
+        for (const auto & name : snapshot->GetNames()) {
+            if (name.compare(0, covariance_prefix.size(), covariance_prefix) != 0) continue;
+            fCovarianceMatrices[name.substr(covariance_prefix.size())] = nullptr;
+        }
+        fTotalCovariance = nullptr;
+
+        // the fit covariance only differs from the total if noise was added to it
+        auto fit_covariance = snapshot->GetMatrix(snapshot->Has("solver/covariance") ?
+                                                  "solver/covariance" : "total_covariance");
+        std::shared_ptr<const fit::CovarianceSolver> solver;
+        if (snapshot->Has("solver/cholesky_factor")) {
+            // the covariance and factor are used in place, so processes mapping the same snapshot share them
+            solver = std::make_shared<const fit::CovarianceSolver>(fit_covariance,
+                                                                   snapshot->GetMatrix("solver/cholesky_factor").data(),
+                                                                   snapshot);
+        }
+        else {
+            auto structure = (fit::CovarianceStructure_t) snapshot->GetInts("solver/structure")(0);
+            solver = std::make_shared<const fit::CovarianceSolver>(Matrix(fit_covariance), structure);
+        }
+
+        auto shape = snapshot->GetInts("design_matrix/shape");
+        auto outer_index = snapshot->GetInts("design_matrix/outer_index");
+        auto inner_index = snapshot->GetInts("design_matrix/inner_index");
+        auto values = snapshot->GetMatrix("design_matrix/values");
+        auto design = std::make_shared<const Eigen::SparseMatrix<double>>(
+                Eigen::Map<const Eigen::SparseMatrix<double>>(shape(0), shape(1), values.size(),
+                                                              outer_index.data(),
+                                                              inner_index.data(),
+                                                              values.data()));
+        auto offset = std::make_shared<const Vector>(snapshot->GetMatrix("prediction_offset"));
+
+        fFitCalc = new fit::TemplateFitCalculator(fReducedComponents, solver, design, offset);
+
+        // templates fixed on the calculator, either by FixComponent or one by one
+        auto fixed_templates = snapshot->GetInts("fixed/templates");
+        auto fixed_values = snapshot->GetMatrix("fixed/values");
+        for (auto i = 0; i < fixed_templates.size(); i++) {
+            fFitCalc->FixTemplate(fixed_templates(i), fixed_values(i));
+        }
+        const std::string fixed_prefix = "fixed/components/";
+        for (const auto & name : snapshot->GetNames()) {
+            if (name.compare(0, fixed_prefix.size(), fixed_prefix) != 0) continue;
+            auto label = name.substr(fixed_prefix.size());
+            fFixedUserComponents[label] = fUserComponents.GetComponent(label);
+        }
+    }
+
+    std::unique_ptr<TemplateFitSignalEstimator>
+    TemplateFitSignalEstimator::
+    LoadSnapshot(const fit::TemplateFitSample & sample,
+                 const TH1 * mask,
+                 const std::string & path) {
+        return std::unique_ptr<TemplateFitSignalEstimator>(
+                new TemplateFitSignalEstimator(sample, mask, std::make_shared<const ArrayFile>(path)));
+    }
+
+    void
+    TemplateFitSignalEstimator::
+    SaveSnapshot(const std::string & path) const {
+        ArrayFileWriter writer;
+        writer.Add("type", std::string("TemplateFitSignalEstimator"));
+        writer.Add("dims", std::vector<int>{fReducedComponents.GetNOuterBins(),
+                                            fReducedComponents.GetNInnerBins(),
+                                            (int) fReducedComponents.size()});
+        writer.Add("mask", Matrix(root::MapContentsToEigen(fReducer.GetMask()).matrix()));
+
+        for (const auto & component : fReducedComponents.GetComponents()) {
+            // restored components are plain ReducedTemplateComponents
+            if (!dynamic_cast<const fit::ReducedTemplateComponent *>(component.second)) {
+                throw std::runtime_error("SaveSnapshot: component " + component.first +
+                                         " is not a ReducedTemplateComponent");
+            }
+            auto prefix = "components/" + component.first + "/";
+            writer.Add(prefix + "nominal", Matrix(component.second->GetNominal()->GetArray()));
+            if (component.second->GetNominalForErrorCalculation() != component.second->GetNominal()) {
+                writer.Add(prefix + "nominal_for_error_calculation",
+                           Matrix(component.second->GetNominalForErrorCalculation()->GetArray()));
+            }
+        }
+
+        for (const auto & covariance : fCovarianceMatrices) {
+            writer.Add("covariance/" + covariance.first, _covariance_matrix(GetSystematicCovariance(covariance.first)));
+        }
+        Matrix total_covariance = _covariance_matrix(GetTotalSystematicCovariance());
+        writer.Add("total_covariance", total_covariance);
+
+        const auto & solver = fFitCalc->GetCovarianceSolver();
+        if (solver.GetCovariance() != total_covariance) {
+            writer.Add("solver/covariance", solver.GetCovariance());
+        }
+        writer.Add("solver/structure", std::vector<int>{solver.GetStructure()});
+        // block diagonal and sparse factorizations are cheap to redo
+        if (solver.GetStructure() == fit::kDenseStructure) {
+            writer.Add("solver/cholesky_factor", solver.GetCholeskyFactor());
+        }
+
+        Eigen::SparseMatrix<double> design = fFitCalc->GetDesignMatrix();
+        design.makeCompressed();
+        writer.Add("design_matrix/shape", std::vector<int>{(int) design.rows(), (int) design.cols()});
+        writer.Add("design_matrix/outer_index",
+                   std::vector<int>(design.outerIndexPtr(), design.outerIndexPtr() + design.outerSize() + 1));
+        writer.Add("design_matrix/inner_index",
+                   std::vector<int>(design.innerIndexPtr(), design.innerIndexPtr() + design.nonZeros()));
+        writer.Add("design_matrix/values",
+                   Matrix(Eigen::Map<const Vector>(design.valuePtr(), design.nonZeros())));
+        writer.Add("prediction_offset", Matrix(fFitCalc->GetPredictionOffset()));
+
+        std::vector<int> fixed_templates;
+        for (auto i = 0u; i < fFitCalc->GetNTemplates(); i++) {
+            if (fFitCalc->GetParamMap().IsParamMasked(i)) fixed_templates.push_back(i);
+        }
+        writer.Add("fixed/templates", fixed_templates);
+        writer.Add("fixed/values", Matrix(fFitCalc->GetFixedParams()(fixed_templates)));
+        for (const auto & component : fFixedUserComponents) {
+            writer.Add("fixed/components/" + component.first, component.first);
+        }
 
+        writer.Write(path);
     }
 
     TH2D *
     TemplateFitSignalEstimator::
     GetTotalCovariance(const std::map<std::string, TH1*> & params) const {
         Matrix mat = fFitCalc->GetTotalCovariance(ToCalculatorParams(params));
-        auto ret = new TH2D("", "",
-                            fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX(),
-                            fTotalTemplate->GetNbinsX(), 0, fTotalTemplate->GetNbinsX());
-        ret->SetTitle("Total Covariance");
-        ret->GetXaxis()->SetTitle("Template Bins");
-        ret->GetYaxis()->SetTitle("Template Bins");
+        auto ret = _covariance_hist("Total Covariance");
         root::FillTH2Contents(ret, mat);
         return ret;
     }
@@ -212,6 +441,10 @@ namespace xsec {
     TH2D *
     TemplateFitSignalEstimator::
     GetTotalSystematicCovariance() const {
+        if (fSnapshot) {
+            std::lock_guard<std::mutex> lock(fSnapshotMutex);
+            if (!fTotalCovariance) fTotalCovariance = _snapshot_covariance("total_covariance", "Total Covariance");
+        }
         return (TH2D *) fTotalCovariance;
     }
 
@@ -224,7 +457,21 @@ namespace xsec {
     TH2D *
     TemplateFitSignalEstimator::
     GetSystematicCovariance(const std::string & systematic_name) const {
-        return (TH2D *) fCovarianceMatrices.at(systematic_name);
+        auto & covariance = fCovarianceMatrices.at(systematic_name);
+        if (fSnapshot) {
+            std::lock_guard<std::mutex> lock(fSnapshotMutex);
+            if (!covariance) covariance = _snapshot_covariance("covariance/" + systematic_name,
+                                                               systematic_name + " Covariance");
+        }
+        return (TH2D *) covariance;
+    }
+
+    TH1 *
+    TemplateFitSignalEstimator::
+    _snapshot_covariance(const std::string & entry, const std::string & title) const {
+        auto covariance = _covariance_hist(title);
+        root::FillTH2Contents(covariance, fSnapshot->GetMatrix(entry));
+        return covariance;
     }
 
     bool
@@ -280,6 +527,27 @@ namespace xsec {
         return calc_params.reshaped();
     }
 
+    fit::FitResult
+    TemplateFitSignalEstimator::
+    ToFitResult(const TemplateFitResult & fit_result) const {
+        fit::FitResult result;
+        result.is_valid = fit_result.is_valid;
+        result.fun_val = fit_result.fun_val;
+        result.fun_calls = fit_result.fun_calls;
+        result.params = ToCalculatorParams(fit_result.component_params);
+        result.params_error_up = ToCalculatorParams(fit_result.component_params_error_up);
+        result.params_error_down = ToCalculatorParams(fit_result.component_params_error_down);
+        const auto nparams = result.params.size();
+        result.covariance = root::MapContentsToEigenInner(fit_result.covariance).reshaped(nparams, nparams);
+        return result;
+    }
+
+    TemplateFitResult
+    TemplateFitSignalEstimator::
+    FromFitResult(const fit::FitResult & fit_result) const {
+        return _template_fit_result(fit_result);
+    }
+
     TH1 *
     TemplateFitSignalEstimator::ToUserParamsComponent(const fit::Vector & calc_params) const {
         return root::ToROOT(fOuterBinMap.ToUserParams(calc_params), fProjectPredictionProps);
@@ -441,6 +709,19 @@ namespace xsec {
         return this->_fit(data, {fFitCalc->ToMinimizerParams(mseed)});
     }
 
+    TemplateFitResult
+    TemplateFitSignalEstimator::
+    Fit(const std::shared_ptr<TH1> data, const TemplateFitResult & previous) const {
+        auto nparams = fFitCalc->GetNUserParams();
+        Array2D user_covariance = root::MapContentsToEigenInner(previous.covariance).reshaped(nparams, nparams);
+        if (!fFitter) {
+            throw std::runtime_error("This TemplateFitSignalEstimator does not have an active IFitter");
+        }
+        fFitter->WarmStart(fFitCalc->ToMinimizerParams(ToCalculatorParams(previous.component_params)),
+                           fFitCalc->ToMinimizerCovariance(user_covariance));
+        return this->_fit(data, {});
+    }
+
     TemplateFitResult
     TemplateFitSignalEstimator::
     Fit(const std::shared_ptr<TH1> data, int nrandom_seeds) const {
@@ -449,32 +730,204 @@ namespace xsec {
             // seed at all parameters equal to 1
             return this->_fit(data, {Array::Ones(fFitCalc->GetNMinimizerParams())});
         } else {
-            // throw 100 random seed configurations
+            // throw fNSeedThrows random seed configurations
             // evaluate fit calc at seed set and take the best nrandom_seeds
             // seed fit with these
-            int nrandom_throws = 100;
-            if (nrandom_seeds > nrandom_throws) {
-                nrandom_throws = nrandom_seeds;
-            }
             return this->_fit(
                     data,
-                    fFitCalc->GetBestSeeds(
-                            fReducer.Reduce(data)->GetArray(),
-                            fFitCalc->GetRandomSeeds(nrandom_throws, -0.5, 0.5),
-                            nrandom_seeds
-                    )
+                    _random_seeds(fFitCalc, fReducer.Reduce(data)->GetArray(), nrandom_seeds)
             );
         }
     }
 
     TemplateFitResult
     TemplateFitSignalEstimator::
-    _fit(const std::shared_ptr<TH1> data, const std::vector<Vector> & seeds) const {
-        assert(seeds[0].size() == fFitCalc->GetNMinimizerParams());
+    _fit(const std::shared_ptr<TH1> data,
+         const std::vector<Vector> & seeds) const {
+        assert(seeds.empty() || seeds[0].size() == fFitCalc->GetNMinimizerParams());
+        if (!fFitter) {
+            throw std::runtime_error("This TemplateFitSignalEstimator does not have an active IFitter");
+        }
+        auto result = fFitter->Fit(fFitCalc, fReducer.Reduce(data)->GetArray(), seeds);
+        return this->_template_fit_result(result);
+    }
+
+    int
+    TemplateFitSignalEstimator::
+    _calculator_param_idx(const std::string & component_label, int outer_bin) const {
+        if (outer_bin < 0 || outer_bin >= (int) fOuterBinMap.GetNUserParams()) {
+            throw std::out_of_range("Outer bin " + std::to_string(outer_bin) + " is out of range");
+        }
+        if (fOuterBinMap.IsParamMasked(outer_bin)) {
+            throw std::runtime_error("Outer bin " + std::to_string(outer_bin) + " is masked");
+        }
+        return fReducedComponents.GetComponentIdx(component_label) * fReducedComponents.GetNOuterBins() +
+               fOuterBinMap.UserToMinimizerIdx(outer_bin);
+    }
+
+    fit::FitResult
+    TemplateFitSignalEstimator::
+    _profile_start(const Vector & data) const {
         if (!fFitter) {
             throw std::runtime_error("This TemplateFitSignalEstimator does not have an active IFitter");
         }
-        return this->_template_fit_result(fFitter->Fit(fFitCalc, fReducer.Reduce(data)->GetArray(), seeds));
+        // profiles start from the global minimum, found on a session
+        // so concurrent scans don't share the fitter's state
+        fit::FitSession session(fFitCalc, fFitter);
+        fit::FitResult start;
+        try {
+            start = session.Fit(data);
+        }
+        catch (fit::InvalidMinimumError & e) {
+            start.params = fFitCalc->ToUserParams(Vector::Ones(fFitCalc->GetNMinimizerParams()));
+            start.covariance = Array2D::Zero(start.params.size(), start.params.size());
+        }
+        return start;
+    }
+
+    std::vector<double>
+    TemplateFitSignalEstimator::
+    _profile_scan(const Vector & data,
+                  const fit::FitResult & start,
+                  int param,
+                  const std::vector<double> & values,
+                  int nthreads) const {
+        fit::ProfileScanner scanner(fFitCalc, fFitter, nthreads);
+        auto npaths = nthreads > 0 ? nthreads : parallel::GetNThreads();
+        auto results = scanner.Scan(data,
+                                    {param},
+                                    Eigen::Map<const Vector>(values.data(), values.size()),
+                                    fit::ProfileScanner::SweepPaths(values, start.params(param), npaths),
+                                    start);
+        std::vector<double> chi2(results.size());
+        for (auto i = 0u; i < results.size(); i++) chi2[i] = results[i].fun_val;
+        return chi2;
+    }
+
+    TGraph *
+    TemplateFitSignalEstimator::
+    ProfileScan(const std::shared_ptr<TH1> data,
+                const std::string & component_label,
+                int outer_bin,
+                const std::vector<double> & values,
+                int nthreads) const {
+        Vector mdata = fReducer.Reduce(data)->GetArray();
+        auto chi2 = _profile_scan(mdata,
+                                  _profile_start(mdata),
+                                  _calculator_param_idx(component_label, outer_bin),
+                                  values,
+                                  nthreads);
+        auto graph = new TGraph(values.size(), values.data(), chi2.data());
+        graph->Sort();
+        graph->SetTitle(("Profile: " + component_label).c_str());
+        return graph;
+    }
+
+    TGraph *
+    TemplateFitSignalEstimator::
+    ProfileScan(const std::shared_ptr<TH1> data,
+                const std::string & component_label,
+                int outer_bin,
+                double lo,
+                double hi,
+                int npoints,
+                int nrefine,
+                double max_delta_chi2,
+                int nthreads) const {
+        Vector mdata = fReducer.Reduce(data)->GetArray();
+        auto start = _profile_start(mdata);
+        auto param = _calculator_param_idx(component_label, outer_bin);
+
+        std::vector<double> values(npoints);
+        for (auto i = 0; i < npoints; i++) {
+            values[i] = npoints > 1 ? lo + i * (hi - lo) / (npoints - 1) : (lo + hi) / 2;
+        }
+        auto chi2 = _profile_scan(mdata, start, param, values, nthreads);
+
+        for (auto irefine = 0; irefine < nrefine; irefine++) {
+            // values stay sorted since only midpoints are added
+            double min_chi2 = std::numeric_limits<double>::infinity();
+            for (const auto & c : chi2) {
+                if (std::isfinite(c)) min_chi2 = std::min(min_chi2, c);
+            }
+            std::vector<double> midpoints;
+            std::vector<int> insert_after;
+            for (auto i = 0u; i + 1 < values.size(); i++) {
+                if (chi2[i] - min_chi2 <= max_delta_chi2 || chi2[i + 1] - min_chi2 <= max_delta_chi2) {
+                    midpoints.push_back((values[i] + values[i + 1]) / 2);
+                    insert_after.push_back(i);
+                }
+            }
+            if (midpoints.empty()) break;
+
+            auto midpoint_chi2 = _profile_scan(mdata, start, param, midpoints, nthreads);
+            std::vector<double> refined_values;
+            std::vector<double> refined_chi2;
+            auto imid = 0u;
+            for (auto i = 0u; i < values.size(); i++) {
+                refined_values.push_back(values[i]);
+                refined_chi2.push_back(chi2[i]);
+                if (imid < insert_after.size() && insert_after[imid] == i) {
+                    refined_values.push_back(midpoints[imid]);
+                    refined_chi2.push_back(midpoint_chi2[imid]);
+                    imid++;
+                }
+            }
+            values = refined_values;
+            chi2 = refined_chi2;
+        }
+
+        auto graph = new TGraph(values.size(), values.data(), chi2.data());
+        graph->SetTitle(("Profile: " + component_label).c_str());
+        return graph;
+    }
+
+    TH2D *
+    TemplateFitSignalEstimator::
+    ProfileScan2D(const std::shared_ptr<TH1> data,
+                  const std::string & component_label_x,
+                  int outer_bin_x,
+                  int nx, double xlo, double xhi,
+                  const std::string & component_label_y,
+                  int outer_bin_y,
+                  int ny, double ylo, double yhi,
+                  int nthreads) const {
+        auto chi2_map = new TH2D("", "", nx, xlo, xhi, ny, ylo, yhi);
+        chi2_map->SetTitle("Profile #chi^{2}");
+        chi2_map->GetXaxis()->SetTitle(component_label_x.c_str());
+        chi2_map->GetYaxis()->SetTitle(component_label_y.c_str());
+
+        Vector mdata = fReducer.Reduce(data)->GetArray();
+        auto start = _profile_start(mdata);
+        std::vector<int> params = {_calculator_param_idx(component_label_x, outer_bin_x),
+                                   _calculator_param_idx(component_label_y, outer_bin_y)};
+
+        // each column of the grid is a path running outward in y from the global minimum
+        std::vector<double> y(ny);
+        for (auto iy = 0; iy < ny; iy++) y[iy] = chi2_map->GetYaxis()->GetBinCenter(iy + 1);
+        auto column_paths = fit::ProfileScanner::SweepPaths(y, start.params(params[1]), 1);
+
+        Matrix points(nx * ny, 2);
+        std::vector<std::vector<int>> paths;
+        for (auto ix = 0; ix < nx; ix++) {
+            for (auto iy = 0; iy < ny; iy++) {
+                points(ix * ny + iy, 0) = chi2_map->GetXaxis()->GetBinCenter(ix + 1);
+                points(ix * ny + iy, 1) = y[iy];
+            }
+            for (const auto & column_path : column_paths) {
+                paths.emplace_back();
+                for (const auto & iy : column_path) paths.back().push_back(ix * ny + iy);
+            }
+        }
+
+        fit::ProfileScanner scanner(fFitCalc, fFitter, nthreads);
+        auto results = scanner.Scan(mdata, params, points, paths, start);
+        for (auto ix = 0; ix < nx; ix++) {
+            for (auto iy = 0; iy < ny; iy++) {
+                chi2_map->SetBinContent(ix + 1, iy + 1, results[ix * ny + iy].fun_val);
+            }
+        }
+        return chi2_map;
     }
 
     Systematic<TH1>
@@ -484,6 +937,8 @@ namespace xsec {
 
         std::map<std::string, Systematic<TH1>> projected_systematics;
         for(const auto & syst : fCovarianceMatrices) {
+            // shape only systematics don't belong to any component
+            if (!component->GetSystematics().count(syst.first)) continue;
             projected_systematics[syst.first] =
                     component->ProjectSystematic(syst.first);
         }
@@ -558,9 +1013,92 @@ namespace xsec {
         return Fit(data, nrandom_seeds);
     }
 
+    std::vector<Vector>
+    TemplateFitSignalEstimator::
+    _random_seeds(const fit::IFitCalculator * fit_calc,
+                  const Vector & data,
+                  int nrandom_seeds) const {
+        int nrandom_throws = std::max(fNSeedThrows, nrandom_seeds);
+        return fit_calc->GetBestSeeds(data,
+                                      fit_calc->GetRandomSeeds(nrandom_throws, -0.5, 0.5, fSeedRNGSeed),
+                                      nrandom_seeds);
+    }
+
+    TemplateFitSession
+    TemplateFitSignalEstimator::
+    NewSession(const fit::IFitter * fitter) const {
+        TemplateFitSession session(this, fitter ? fitter : fFitter);
+        return session;
+    }
+
+    TemplateFitSession::
+    TemplateFitSession(const TemplateFitSignalEstimator * estimator,
+                       const fit::IFitter * fitter)
+            : fEstimator(estimator),
+              fSession(estimator->fFitCalc, fitter),
+              fFixedUserComponents(estimator->fFixedUserComponents)
+    {}
+
+    void
+    TemplateFitSession::
+    FixComponent(const std::string & component_label, const double & val) {
+        const auto & components = fEstimator->fReducedComponents;
+        auto idx = components.GetComponentIdx(component_label);
+        for (auto o = 0u; o < components.GetNOuterBins(); o++) {
+            fSession.FixTemplate(idx * components.GetNOuterBins() + o, val);
+        }
+        fFixedUserComponents[component_label] = fEstimator->fUserComponents.GetComponent(component_label);
+    }
+
+    void
+    TemplateFitSession::
+    ReleaseComponent(const std::string & component_label) {
+        // if this component isn't fixed, do nothing
+        if (!fFixedUserComponents.erase(component_label)) return;
+        const auto & components = fEstimator->fReducedComponents;
+        auto idx = components.GetComponentIdx(component_label);
+        for (auto o = 0u; o < components.GetNOuterBins(); o++) {
+            fSession.ReleaseTemplate(idx * components.GetNOuterBins() + o);
+        }
+    }
+
+    TemplateFitResult
+    TemplateFitSession::
+    Fit(const std::shared_ptr<TH1> data, int nrandom_seeds) {
+        Vector mdata = fEstimator->fReducer.Reduce(data)->GetArray();
+        std::vector<Vector> seeds;
+        if (nrandom_seeds >= 0) {
+            seeds = fEstimator->_random_seeds(fSession.GetFitCalc(), mdata, nrandom_seeds);
+        }
+        return fEstimator->_template_fit_result(fSession.Fit(mdata, seeds), fFixedUserComponents);
+    }
+
+    TemplateFitResult
+    TemplateFitSession::
+    Fit(const std::shared_ptr<TH1> data, const TemplateFitResult & previous) {
+        auto fit_calc = fSession.GetFitCalc();
+        auto nparams = fit_calc->GetNUserParams();
+        Array2D user_covariance = root::MapContentsToEigenInner(previous.covariance).reshaped(nparams, nparams);
+        if (!fSession.GetFitter()) {
+            throw std::runtime_error("This TemplateFitSession does not have an IFitter");
+        }
+        fSession.ClearWarmStart();
+        fSession.GetFitter()->WarmStart(fit_calc->ToMinimizerParams(fEstimator->ToCalculatorParams(previous.component_params)),
+                                        fit_calc->ToMinimizerCovariance(user_covariance));
+        Vector mdata = fEstimator->fReducer.Reduce(data)->GetArray();
+        return fEstimator->_template_fit_result(fSession.Fit(mdata), fFixedUserComponents);
+    }
+
     TemplateFitResult
     TemplateFitSignalEstimator::
     _template_fit_result(const fit::FitResult & result) const {
+        return _template_fit_result(result, fFixedUserComponents);
+    }
+
+    TemplateFitResult
+    TemplateFitSignalEstimator::
+    _template_fit_result(const fit::FitResult & result,
+                         const std::map<std::string, const fit::IUserTemplateComponent*> & fixed_components) const {
         std::map<std::string, TH1 *> component_params;
         std::map<std::string, TH1 *> component_params_error_up;
         std::map<std::string, TH1 *> component_params_error_down;
@@ -585,7 +1123,7 @@ namespace xsec {
         ToUserParams(result.params, component_params);
         ToUserParams(result.params_error_up, component_params_error_up);
         ToUserParams(result.params_error_down, component_params_error_down);
-        for (const auto & component : fFixedUserComponents) {
+        for (const auto & component : fixed_components) {
             component_params_error_up.at(component.first)->Reset("ICESM");
             component_params_error_down.at(component.first)->Reset("ICESM");
 
@@ -605,7 +1143,8 @@ namespace xsec {
                 component_params_error_up,
                 component_params_error_down,
                 covariance,
-                result.fun_calls};
+                result.fun_calls,
+                result.is_valid};
     }
 
 
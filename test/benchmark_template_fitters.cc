@@ -0,0 +1,84 @@
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LBFGSBFitter.h"
+#include "XSecAna/Fit/Minuit2TemplateFitter.h"
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+// Compares Minuit2 and L-BFGS-B on template fits with an increasing number of parameters.
+// Usage: benchmark_template_fitters [nparams ...]
+// Two components share each outer bin, so the number of parameters is twice the number of outer bins.
+// The covariance is block diagonal over outer bins.
+
+template<class Fitter>
+void Run(const std::string & name, Fitter & fitter, TemplateFitCalculator * fit_calc, const Vector & data) {
+    auto start = std::chrono::steady_clock::now();
+    FitResult result;
+    try {
+        result = fitter.Fit(fit_calc, data);
+    }
+    catch (InvalidMinimumError & e) {
+        result.is_valid = false;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "    " << name
+              << ": time = " << elapsed.count() << " s"
+              << ", chi2 = " << result.fun_val
+              << ", fun calls = " << result.fun_calls
+              << ", valid = " << result.is_valid
+              << std::endl;
+}
+
+int main(int argc, char ** argv) {
+    std::vector<int> sizes = {100, 500, 2000};
+    if (argc > 1) {
+        sizes.clear();
+        for (auto i = 1; i < argc; i++) sizes.push_back(std::stoi(argv[i]));
+    }
+
+    const int ninner = 5;
+    for (auto nparams : sizes) {
+        const int nouter = nparams / 2;
+        std::vector<int> dims = {nouter, ninner};
+        Matrix signal_templates(nouter, ninner);
+        Matrix background_templates(nouter, ninner);
+        auto x = Array::LinSpaced(ninner, 1, ninner);
+        for (auto i = 0; i < nouter; i++) {
+            signal_templates.row(i) = (1 + i % 7) * x;
+            background_templates.row(i) = (1 + i % 3) * x.reverse() + 0.5;
+        }
+        std::map<std::string, const IReducedTemplateComponent *> templates = {
+                {"signal", new ReducedTemplateComponent(new ReducedComponent(signal_templates.reshaped().transpose(), nouter, ninner))},
+                {"background", new ReducedTemplateComponent(new ReducedComponent(background_templates.reshaped().transpose(), nouter, ninner))},
+        };
+
+        auto nbins = nouter * ninner;
+        Matrix covariance = Matrix::Zero(nbins, nbins);
+        for (auto i = 0; i < nouter; i++) {
+            std::vector<int> idx;
+            for (auto j = 0; j < ninner; j++) idx.push_back(j * nouter + i);
+            covariance(idx, idx) = Matrix::Identity(ninner, ninner) * 0.5 + Matrix::Constant(ninner, ninner, 0.1);
+        }
+        auto fit_calc = new TemplateFitCalculator(ReducedComponentCollection(templates), dims, covariance);
+
+        Vector truth = 1 + Array::LinSpaced(fit_calc->GetNUserParams(), 0, 1).sin() / 2;
+        Vector data = fit_calc->Predict(truth) + Vector::LinSpaced(nbins, -0.5, 0.5);
+
+        std::cout << fit_calc->GetNMinimizerParams() << " parameters, "
+                  << nbins << " bins" << std::endl;
+
+        LBFGSBFitter lbfgsb;
+        Run("L-BFGS-B", lbfgsb, fit_calc, data);
+
+        Minuit2TemplateFitter minuit(0, 1, false);
+        minuit.SetPrintLevel(0);
+        Run("Minuit2 ", minuit, fit_calc, data);
+
+        delete fit_calc;
+    }
+}
@@ -0,0 +1,153 @@
+#include "XSecAna/BinMerger.h"
+#include "XSecAna/SimpleQuadSum.h"
+
+#include "test_utils.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace xsec;
+
+const int nfine = 30;
+
+std::shared_ptr<TH1> make_sample(double scale, double slope) {
+    auto h = std::make_shared<TH1D>(root::MakeUnique("sample").c_str(), "", nfine, 0, 3);
+    for (auto i = 0; i <= nfine + 1; i++) {
+        // falling spectrum, so merging the tail pays off
+        h->SetBinContent(i, scale * 100 * std::exp(-0.15 * i) * (1 + slope * i / nfine));
+    }
+    return h;
+}
+
+Systematic<TH1> rebin(const Systematic<TH1> & syst, const Array & edges) {
+    std::vector<std::shared_ptr<TH1>> shifts;
+    for (const auto & shift : syst.GetShifts()) shifts.push_back(BinMerger::Rebin(shift.get(), edges));
+    return Systematic<TH1>(syst.GetName(), shifts, syst.GetType());
+}
+
+// index of each edge among the fine edges
+std::vector<std::size_t> fine_indices(const BinMerger & merger, const Array & edges) {
+    std::vector<std::size_t> indices;
+    for (auto i = 0u; i < edges.size(); i++) {
+        Eigen::Index ifine;
+        (merger.GetFineEdges() - edges(i)).abs().minCoeff(&ifine);
+        indices.push_back(ifine);
+    }
+    return indices;
+}
+
+double total_cost(const BinMerger & merger, const Array & edges) {
+    auto indices = fine_indices(merger, edges);
+    double cost = 0;
+    for (auto i = 0u; i + 1 < indices.size(); i++) cost += merger.Cost(indices[i], indices[i + 1]);
+    return cost;
+}
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto nominal = make_sample(1, 0);
+    auto systematics = test::utils::make_sample_systematics(make_sample, 0);
+
+    BinMerger merger(nominal.get(), systematics);
+    assert(merger.GetNFineBins() == nfine);
+
+    // merged bins agree with rebinning the histograms and running SimpleQuadSum
+    Array edges(4);
+    edges << 0, 0.5, 1.2, 3;
+    auto rebinned = BinMerger::Rebin(nominal.get(), edges);
+    std::map<std::string, Systematic<TH1>> rebinned_systematics;
+    for (const auto & syst : systematics) rebinned_systematics[syst.first] = rebin(syst.second, edges);
+    auto expected = std::get<1>(SimpleQuadSum::TotalFractionalUncertainty(rebinned.get(),
+                                                                          rebinned_systematics)).Up();
+    auto indices = fine_indices(merger, edges);
+    Array content(3);
+    Array fractional(3);
+    for (auto i = 0u; i < 3; i++) {
+        content(i) = merger.Content(indices[i], indices[i + 1]);
+        fractional(i) = merger.FractionalUncertainty(indices[i], indices[i + 1]);
+    }
+    pass &= TEST_ARRAY_SAME("merged content",
+                            content,
+                            root::MapContentsToEigenInner(rebinned.get()),
+                            1e-9,
+                            verbose);
+    pass &= TEST_ARRAY_SAME("merged fractional uncertainty",
+                            fractional,
+                            root::MapContentsToEigenInner(expected.get()),
+                            1e-12,
+                            verbose);
+
+    // rebinning keeps the total and sums errors in quadrature
+    assert(rebinned->GetNbinsX() == 3);
+    assert(std::abs(root::MapContentsToEigen(rebinned.get()).sum() -
+                    root::MapContentsToEigen(nominal.get()).sum()) < 1e-9);
+    assert(std::abs(root::MapErrorsToEigen(rebinned.get()).square().sum() -
+                    root::MapErrorsToEigen(nominal.get()).square().sum()) < 1e-9);
+
+    // dynamic programming finds the same optimum as trying every 3 bin partition
+    auto best = merger.Optimize(3);
+    assert(best.size() == 4);
+    assert(best(0) == 0 && best(3) == 3);
+    double brute_force = std::numeric_limits<double>::infinity();
+    for (auto a = 1u; a < nfine; a++) {
+        for (auto b = a + 1; b < nfine; b++) {
+            brute_force = std::min(brute_force,
+                                   merger.Cost(0, a) + merger.Cost(a, b) + merger.Cost(b, nfine));
+        }
+    }
+    assert(std::abs(total_cost(merger, best) - brute_force) < 1e-12);
+
+    // constraints hold in every merged bin
+    MergeConstraints constraints;
+    constraints.min_content = 50;
+    constraints.max_fractional_uncertainty = 0.2;
+    BinMerger constrained(nominal.get(), systematics, constraints);
+    auto finest = constrained.Finest();
+    auto finest_indices = fine_indices(constrained, finest);
+    for (auto i = 0u; i + 1 < finest_indices.size(); i++) {
+        assert(constrained.Content(finest_indices[i], finest_indices[i + 1]) >= constraints.min_content);
+        assert(constrained.FractionalUncertainty(finest_indices[i], finest_indices[i + 1]) <=
+               constraints.max_fractional_uncertainty);
+    }
+    auto nbins = finest.size() - 1;
+    assert(nbins > 1 && nbins < nfine);
+    assert(std::abs(total_cost(constrained, finest) - total_cost(constrained, constrained.Optimize(nbins))) < 1e-12);
+    bool threw = false;
+    try { constrained.Optimize(nbins + 1); }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    // merged bins are never narrower than min_width
+    MergeConstraints wide;
+    wide.min_width = 0.45;
+    BinMerger wide_merger(nominal.get(), systematics, wide);
+    auto wide_edges = wide_merger.Finest();
+    // 3 / 0.45 leaves room for at most 6 bins
+    assert(wide_edges.size() - 1 == 6);
+    for (auto i = 0u; i + 1 < wide_edges.size(); i++) {
+        assert(wide_edges(i + 1) - wide_edges(i) >= wide.min_width - 1e-12);
+    }
+    assert(std::isinf(wide_merger.Cost(0, 4)));
+    assert(std::isfinite(wide_merger.Cost(0, 5)));
+
+    // no binning meets constraints the whole sample can't
+    MergeConstraints impossible;
+    impossible.min_content = 2 * root::MapContentsToEigenInner(nominal.get()).sum();
+    BinMerger impossible_merger(nominal.get(), systematics, impossible);
+    threw = false;
+    try { impossible_merger.Finest(); }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { impossible_merger.Optimize(1); }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    if (verbose) std::cerr << "finest binning " << finest.transpose() << std::endl;
+
+    return !pass;
+}
@@ -0,0 +1,117 @@
+#include "XSecAna/CutScanner.h"
+#include "XSecAna/MultiverseMatrix.h"
+#include "XSecAna/SimpleQuadSum.h"
+
+#include "test_utils.h"
+
+#include "TH2D.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace xsec;
+
+const int nx = 20;
+const int ny = 4;
+
+// optimization variable on x, analysis variable on y
+std::shared_ptr<TH1> make_sample(double scale, double slope) {
+    auto h = std::make_shared<TH2D>(root::MakeUnique("sample").c_str(), "",
+                                    nx, 0, 1,
+                                    ny, 0, 4);
+    for (auto i = 0; i <= nx + 1; i++) {
+        for (auto j = 0; j <= ny + 1; j++) {
+            h->SetBinContent(i, j, scale * (10 + j + slope * i));
+        }
+    }
+    return h;
+}
+
+// analysis spectrum of events passing cut k, projected the long way
+std::shared_ptr<TH1> project(const TH1 * h, int k, CutDirection_t direction) {
+    auto projection = std::make_shared<TH1D>(root::MakeUnique("projection").c_str(), "", ny, 0, 4);
+    for (auto j = 0; j <= ny + 1; j++) {
+        double sum = 0;
+        for (auto i = 0; i <= nx + 1; i++) {
+            if ((direction == kKeepAbove && i > k) || (direction == kKeepBelow && i <= k)) {
+                sum += h->GetBinContent(i, j);
+            }
+        }
+        projection->SetBinContent(j, sum);
+    }
+    return projection;
+}
+
+Systematic<TH1> project(const Systematic<TH1> & syst, int k, CutDirection_t direction) {
+    std::vector<std::shared_ptr<TH1>> shifts;
+    for (const auto & shift : syst.GetShifts()) shifts.push_back(project(shift.get(), k, direction));
+    return Systematic<TH1>(syst.GetName(), shifts, syst.GetType());
+}
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto nominal = make_sample(1, 1);
+
+    auto systematics = test::utils::make_sample_systematics(make_sample, 1);
+    // the same universes again, as a matrix
+    const auto & universes = systematics.at("multiverse").GetShifts();
+    Matrix universe_matrix(root::TH1Props(universes[0].get()).nbins_and_uof, universes.size());
+    for (auto i = 0u; i < universes.size(); i++) {
+        universe_matrix.col(i) = root::MapContentsToEigen(universes[i].get()).matrix();
+    }
+    systematics["multiverse_matrix"] = Systematic<TH1>("multiverse_matrix",
+                                                       std::make_shared<MultiverseMatrix>(nominal.get(),
+                                                                                          universe_matrix));
+
+    for (auto direction : {kKeepAbove, kKeepBelow}) {
+        CutScanner scanner(nominal.get(), systematics, direction);
+        assert(scanner.GetNCuts() == nx + 1);
+        assert(scanner.GetNBins() == ny + 2);
+        assert(scanner.GetCutValues()(0) == 0);
+        assert(std::abs(scanner.GetCutValues()(nx) - 1) < 1e-12);
+
+        auto total = scanner.TotalFractionalUncertainty();
+        std::vector<double> expected_values;
+        for (auto k = 0; k <= nx; k++) {
+            auto selected = project(nominal.get(), k, direction);
+            std::map<std::string, Systematic<TH1>> selected_systematics;
+            for (const auto & syst : systematics) {
+                selected_systematics[syst.first] = project(syst.second, k, direction);
+            }
+
+            pass &= TEST_ARRAY_SAME("selected nominal " + std::to_string(k),
+                                    scanner.SelectedNominal(k),
+                                    root::MapContentsToEigen(selected.get()),
+                                    1e-9,
+                                    verbose);
+
+            auto expected = std::get<1>(SimpleQuadSum::TotalFractionalUncertainty(selected.get(),
+                                                                                  selected_systematics)).Up();
+            Array expected_inner = root::MapContentsToEigenInner(expected.get());
+            pass &= TEST_ARRAY_SAME("total fractional uncertainty " + std::to_string(k),
+                                    total.col(k).array().segment(1, ny),
+                                    expected_inner,
+                                    1e-12,
+                                    verbose);
+            expected_values.push_back(std::sqrt(expected_inner.square().sum()));
+        }
+
+        auto result = scanner.Scan();
+        for (auto k = 0u; k < expected_values.size(); k++) {
+            assert(std::abs(result.values[k] - expected_values[k]) < 1e-12);
+        }
+
+        // custom objectives only see the inner analysis bins
+        auto signal = scanner.Scan([](const Array & nominal, const Array &) {
+            assert(nominal.size() == ny);
+            return -nominal.sum();
+        });
+        assert(signal.best == (direction == kKeepAbove ? 0 : nx));
+    }
+
+    return !pass;
+}
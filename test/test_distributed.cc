@@ -0,0 +1,117 @@
+#include "XSecAna/Distributed.h"
+#include "XSecAna/SimpleSignalEstimator.h"
+
+#include "test_utils.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::distributed;
+
+// A toy analysis selecting events above cut.
+// The background systematic grows with the cut while the signal shrinks,
+// so the total fractional uncertainty is smallest at the lowest cut
+AnalysisSpec make_analysis(double cut) {
+    Array bins = Array::LinSpaced(5, 0, 4);
+    AnalysisSpec analysis;
+    analysis.data = std::shared_ptr<TH1>(test::utils::make_constant_hist(bins, 100 * (1 - cut) + 10));
+    analysis.nominal = std::make_shared<SimpleSignalEstimator>(test::utils::make_constant_hist(bins, 5));
+    analysis.systematics["background"] = Systematic<IMeasurement>(
+            "background",
+            std::make_shared<SimpleSignalEstimator>(test::utils::make_constant_hist(bins, 5 * (1 + cut))));
+    return analysis;
+}
+
+int main(int argc, char ** argv) {
+    auto quadratic = [](std::size_t i) { return std::pow(double(i) - 7.3, 2); };
+    std::vector<double> expected(20);
+    for (auto i = 0u; i < expected.size(); i++) expected[i] = quadratic(i);
+
+    ThreadDriver threads(4);
+    ForkDriver forks(3);
+    for (IDriver * driver : std::vector<IDriver *>{&threads, &forks}) {
+        auto result = Minimum(driver->Evaluate(expected.size(), quadratic));
+        assert(result.best == 7);
+        assert(result.value == expected[7]);
+        assert(result.values == expected);
+    }
+
+    // NaN is never the minimum
+    assert(Minimum({std::nan(""), 3, 1, std::nan("")}).best == 2);
+    // and there is no minimum without a valid value
+    for (auto values : {std::vector<double>{}, std::vector<double>{std::nan(""), std::nan("")}}) {
+        bool threw = false;
+        try { Minimum(values); }
+        catch (std::runtime_error &) { threw = true; }
+        assert(threw);
+    }
+
+    // a failing worker is reported to the parent
+    bool threw = false;
+    try {
+        forks.Evaluate(10, [](std::size_t i) -> double {
+            if (i == 5) throw std::runtime_error("test_distributed: expected failure");
+            return i;
+        });
+    }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    // so is one throwing something other than a std::exception
+    threw = false;
+    try {
+        forks.Evaluate(10, [](std::size_t i) -> double {
+            if (i == 5) throw 5;
+            return i;
+        });
+    }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    // cut scan through the analysis and SimpleQuadSum
+    auto serial = OptimizeCut(threads, 0, 0.9, 10, make_analysis);
+    auto forked = OptimizeCut(forks, 0, 0.9, 10, make_analysis);
+    assert(serial.best == 0);
+    assert(forked.best == serial.best);
+    for (auto i = 0u; i < serial.values.size(); i++) {
+        assert(std::abs(forked.values[i] - serial.values[i]) < 1e-12);
+    }
+    // 4 bins, each 5 * cut / (100 * (1 - cut) + 5)
+    double cut = 0.5;
+    assert(std::abs(serial.values[5] - 2 * 5 * cut / (100 * (1 - cut) + 5)) < 1e-12);
+
+    // an objective that is never valid has no best cut
+    threw = false;
+    try {
+        OptimizeCut(threads, 0, 0.9, 10, make_analysis, [](const AnalysisSpec &) {
+            return std::nan("");
+        });
+    }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+#ifdef XSECANA_USE_MPI
+    // run with mpirun -np N. Every rank gets every value
+    {
+        MPIDriver mpi;
+        auto result = Minimum(mpi.Evaluate(expected.size(), quadratic));
+        assert(result.best == 7);
+        assert(result.values == expected);
+        if (mpi.GetRank() == 0) std::cout << "test_distributed: " << mpi.GetSize() << " ranks" << std::endl;
+    }
+
+    // MPI stays initialized for later drivers, and a failure on one rank reaches every rank
+    MPIDriver mpi;
+    threw = false;
+    try {
+        mpi.Evaluate(expected.size(), [](std::size_t i) -> double {
+            if (i == 1) throw 1;
+            return i;
+        });
+    }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+#endif
+}
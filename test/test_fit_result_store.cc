@@ -0,0 +1,142 @@
+#include "XSecAna/Fit/FitResultStore.h"
+
+#include <Eigen/Dense>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+FitResult make_result(int row, int nparams) {
+    FitResult result;
+    result.is_valid = row % 7 != 0;
+    result.fun_val = 0.5 * row;
+    result.fun_calls = 10 + row;
+    result.params = Vector::LinSpaced(nparams, row, row + 1);
+    result.params_error_up = Array::Constant(nparams, 0.1 * row);
+    result.params_error_down = -result.params_error_up;
+    Matrix a = Matrix::Random(nparams, nparams);
+    result.covariance = a * a.transpose();
+    return result;
+}
+
+int main(int argc, char ** argv) {
+    const int nparams = 4;
+    const int nrows = 2500;
+    const std::string path = "test_fit_result_store.bin";
+
+    for (auto store_covariance : {false, true}) {
+        std::vector<FitResult> results;
+        {
+            // groups of 1000 so the last group is only partially filled
+            FitResultWriter writer(path, nparams, store_covariance, 1000);
+            for (auto i = 0; i < nrows; i++) {
+                results.push_back(make_result(i, nparams));
+                writer.Append(results.back());
+            }
+            assert(writer.GetNRows() == nrows);
+        }
+
+        // the last group isn't padded to 1000 rows
+        auto row_width = fit::detail::FitResultRowWidth(nparams, store_covariance);
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        assert((std::size_t) file.tellg() == sizeof(fit::detail::FitResultStoreHeader) +
+                                             3 * sizeof(std::uint64_t) +
+                                             nrows * row_width * sizeof(double));
+
+        FitResultReader reader(path);
+        assert(reader.GetNRows() == nrows);
+        assert(reader.GetNParams() == nparams);
+        assert(reader.HasCovariance() == store_covariance);
+
+        // columns across every row group
+        Array fun_val = reader.Column(kFunValColumn);
+        Array param2 = reader.Column(kParamsColumn, 2);
+        Array error_down = reader.Column(kParamsErrorDownColumn, 3);
+        Array valid = reader.Column(kIsValidColumn);
+        assert(fun_val.size() == nrows);
+        for (auto i = 0; i < nrows; i++) {
+            assert(fun_val(i) == results[i].fun_val);
+            assert(param2(i) == results[i].params(2));
+            assert(error_down(i) == results[i].params_error_down(3));
+            assert(valid(i) == results[i].is_valid);
+        }
+
+        for (auto i : {0, 999, 1000, 2000, 2499}) {
+            auto row = reader.GetRow(i);
+            assert(row.is_valid == results[i].is_valid);
+            assert(row.fun_calls == results[i].fun_calls);
+            assert(row.params == results[i].params);
+            assert((row.params_error_up == results[i].params_error_up).all());
+            if (store_covariance) {
+                assert((row.covariance == results[i].covariance).all());
+            }
+        }
+
+        // indices past the end of a column
+        for (auto column : {kParamsColumn, kParamsErrorUpColumn, kParamsErrorDownColumn}) {
+            for (auto index : {-1, nparams}) {
+                bool threw = false;
+                try {
+                    reader.Column(column, index);
+                }
+                catch (std::out_of_range & e) {
+                    threw = true;
+                }
+                assert(threw);
+            }
+        }
+
+        if (store_covariance) {
+            bool threw = false;
+            try {
+                reader.Column(kCovarianceColumn, nparams * (nparams + 1) / 2);
+            }
+            catch (std::out_of_range & e) {
+                threw = true;
+            }
+            assert(threw);
+
+            Array cov13 = reader.Column(kCovarianceColumn, FitResultReader::CovarianceIndex(3, 1, nparams));
+            for (auto i = 0; i < nrows; i++) {
+                assert(cov13(i) == results[i].covariance(1, 3));
+            }
+        }
+        else {
+            bool threw = false;
+            try {
+                reader.Column(kCovarianceColumn);
+            }
+            catch (std::runtime_error & e) {
+                threw = true;
+            }
+            assert(threw);
+        }
+    }
+
+    // the default group size comes from the row width, so it holds many small rows
+    {
+        {
+            FitResultWriter writer(path, 1);
+            for (auto i = 0; i < 10; i++) writer.Append(make_result(i, 1));
+        }
+        std::ifstream file(path, std::ios::binary);
+        fit::detail::FitResultStoreHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        assert(header.rows_per_group == FitResultWriter::kGroupBytes /
+                                        (fit::detail::FitResultRowWidth(1, false) * sizeof(double)));
+        FitResultReader reader(path);
+        assert(reader.GetNRows() == 10);
+        assert(reader.GetRow(9).fun_val == make_result(9, 1).fun_val);
+    }
+
+    // packed upper triangle is in row order
+    for (auto i = 0, k = 0; i < nparams; i++) {
+        for (auto j = i; j < nparams; j++) {
+            assert(FitResultReader::CovarianceIndex(i, j, nparams) == k++);
+        }
+    }
+
+    std::remove(path.c_str());
+}
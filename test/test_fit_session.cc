@@ -0,0 +1,80 @@
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/LBFGSBFitter.h"
+#include "XSecAna/Fit/FitSession.h"
+#include "XSecAna/Parallel.h"
+
+#include "test_utils.h"
+
+#include <Eigen/Dense>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+int main(int argc, char ** argv) {
+    auto dims = test::utils::template_fit_dims;
+    auto templates = test::utils::make_reduced_templates();
+    auto nbins = dims[0] * dims[1];
+    Matrix covariance = test::utils::make_template_covariance();
+    auto fit_calc = new TemplateFitCalculator(ReducedComponentCollection(templates), dims, covariance);
+    fit_calc->SetIgnoreStatisticalUncertainty(true);
+
+    Vector truth = Vector::LinSpaced(fit_calc->GetNUserParams(), 0.5, 2);
+    Vector data = fit_calc->Predict(truth) + Vector::LinSpaced(nbins, -1, 1);
+
+    LinearTemplateFitter linear;
+    LBFGSBFitter lbfgsb;
+
+    // variants: all free, first component fixed, last outer bin of every component fixed
+    std::vector<FitSession> sessions(3, FitSession(fit_calc, &linear));
+    for (auto o = 0; o < dims[0]; o++) sessions[1].FixTemplate(o, truth(o));
+    for (auto c = 0; c < 3; c++) sessions[2].FixTemplate(c * dims[0] + dims[0] - 1, 1);
+    sessions[2].SetFitter(&lbfgsb);
+
+    // sessions share the immutable parts of the calculator but not the parameter map
+    for (const auto & session : sessions) {
+        assert(&session.GetFitCalc()->GetCovarianceSolver() == &fit_calc->GetCovarianceSolver());
+        assert(&session.GetFitCalc()->GetDesignMatrix() == &fit_calc->GetDesignMatrix());
+    }
+    assert(fit_calc->GetNMinimizerParams() == fit_calc->GetNUserParams());
+    assert(sessions[1].GetFitCalc()->GetNMinimizerParams() == fit_calc->GetNUserParams() - dims[0]);
+
+    std::vector<FitResult> serial;
+    for (auto & session : sessions) serial.push_back(FitSession(session).Fit(data));
+
+    parallel::SetNThreads(3);
+    std::vector<FitResult> concurrent(sessions.size());
+    parallel::For(sessions.size(), [&](std::size_t i) {
+        concurrent[i] = sessions[i].Fit(data);
+    });
+    for (auto i = 0u; i < sessions.size(); i++) {
+        assert(concurrent[i].is_valid);
+        assert(std::abs(concurrent[i].fun_val - serial[i].fun_val) < 1e-8 * serial[i].fun_val);
+        assert((concurrent[i].params - serial[i].params).isZero(1e-6));
+    }
+    assert((concurrent[1].params.head(dims[0]) - truth.head(dims[0])).isZero(0));
+    assert(concurrent[0].fun_val <= concurrent[1].fun_val);
+
+    // a warm started session starts each fit from its previous minimum
+    Vector similar_data = data + Vector::LinSpaced(nbins, -0.1, 0.1);
+    FitSession cold(fit_calc, &lbfgsb);
+    auto cold_result = cold.Fit(similar_data);
+    FitSession warm(fit_calc, &lbfgsb);
+    warm.SetWarmStart(true);
+    warm.Fit(data);
+    auto warm_result = warm.Fit(similar_data);
+    assert(((LBFGSBFitter *) warm.GetFitter())->GetNIterations() <
+           ((LBFGSBFitter *) cold.GetFitter())->GetNIterations());
+    assert(std::abs(warm_result.fun_val - cold_result.fun_val) < 1e-6 * cold_result.fun_val);
+    // fixing a template invalidates the cached minimum
+    warm.FixTemplate(0, truth(0));
+    assert(warm.Fit(similar_data).is_valid);
+
+    // changing the covariance of one calculator replaces, rather than modifies, the shared solver
+    auto copy = fit_calc->Clone();
+    copy->AddNoise(0.1);
+    assert(&copy->GetCovarianceSolver() != &fit_calc->GetCovarianceSolver());
+    assert(fit_calc->GetSystematicCovariance() == covariance);
+    delete copy;
+}
@@ -94,6 +94,25 @@ int main(int argc, char ** argv) {
     }
     assert((root::MapContentsToEigen(bin_width) - root::MapBinWidthsToEigen(th1)).isZero(0));
 
+    auto th3_var = new TH3D("", "",
+                            nx, 0, 2 * nx,
+                            ny, 0, ny,
+                            nz, 0, 3 * nz);
+    auto bin_width3 = (TH3D *) th3_var->Clone();
+    bin_width3->Reset();
+    for (auto i = 0; i <= nx + 1; i++) {
+        for (auto j = 0; j <= ny + 1; j++) {
+            for (auto k = 0; k <= nz + 1; k++) {
+                bool inner = i > 0 && i <= nx && j > 0 && j <= ny && k > 0 && k <= nz;
+                bin_width3->SetBinContent(i, j, k, inner ?
+                                                   th3_var->GetXaxis()->GetBinWidth(i) *
+                                                   th3_var->GetYaxis()->GetBinWidth(j) *
+                                                   th3_var->GetZaxis()->GetBinWidth(k) : 1);
+            }
+        }
+    }
+    assert((root::MapContentsToEigen(bin_width3) - root::MapBinWidthsToEigen(th3_var)).isZero(0));
+
     auto output = new TFile("test_hist.root", "recreate");
     th1->Write("th1");
     th2->Write("th2");
@@ -0,0 +1,60 @@
+#include "XSecAna/IterativeUnfolder.h"
+#include "XSecAna/Utils.h"
+
+#include <iostream>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TH2D.h"
+
+using namespace xsec;
+
+int main(int argc, char ** argv) {
+    // near-diagonal migrations
+    const int nbins = 10;
+    auto response = new TH2D("", "", nbins, 0, 1, nbins, 0, 1);
+    auto truth = new TH1D("", "", nbins, 0, 1);
+    for (auto j = 1; j <= nbins; j++) {
+        response->SetBinContent(j, j, 80 + j);
+        if (j > 1) response->SetBinContent(j - 1, j, 10);
+        if (j < nbins) response->SetBinContent(j + 1, j, 12);
+        truth->SetBinContent(j, 50 + 5 * j);
+    }
+
+    IterativeUnfolder unfold(response, 100);
+    assert(unfold.GetResponse().nonZeros() == 3 * nbins - 2);
+
+    // fold the truth and unfold it again
+    Vector true_contents = root::MapContentsToEigen(truth).matrix();
+    Vector reco_contents = unfold.GetMigrationMatrix() * true_contents;
+    auto reco = root::ToROOTLike(truth, reco_contents.array(), reco_contents.array().sqrt());
+    auto unfolded = unfold.Truth(reco);
+    assert((root::MapContentsToEigen(unfolded.get()) - true_contents.array()).isZero(1e-6 * true_contents.norm()));
+    assert((root::MapErrorsToEigen(unfolded.get()).segment(1, nbins) > 0).all());
+
+    // universes unfold in one pass and agree with unfolding one at a time
+    const int nuniverses = 17;
+    Matrix universes(nbins + 2, nuniverses);
+    for (auto i = 0; i < nuniverses; i++) {
+        universes.col(i) = reco_contents * (1 + 0.01 * i);
+    }
+    Matrix unfolded_universes = unfold.Unfold(universes);
+    for (auto i = 0; i < nuniverses; i++) {
+        auto universe = root::ToROOTLike(truth, universes.col(i).array());
+        Array single = root::MapContentsToEigen(unfold.Truth(universe).get());
+        assert((single - unfolded_universes.col(i).array()).isZero(1e-10 * single.matrix().norm()));
+    }
+
+    // save and load
+    std::string fname = "test_iterative_unfolder.root";
+    auto output = new TFile(fname.c_str(), "recreate");
+    unfold.SaveTo(output, "unfold");
+    output->Close();
+
+    auto input = TFile::Open(fname.c_str());
+    auto loaded = IterativeUnfolder::LoadFrom(input, "unfold");
+    auto loaded_unfolded = loaded->Eval(reco);
+    assert((root::MapContentsToEigen(loaded_unfolded.get()) -
+            root::MapContentsToEigen(unfolded.get())).isZero(1e-10));
+    input->Close();
+}
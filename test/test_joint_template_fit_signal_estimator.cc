@@ -0,0 +1,306 @@
+#include "XSecAna/JointTemplateFitSignalEstimator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace xsec;
+
+/////////////////////////////////////////////////////////
+// 3D histogram with nz template bins, filled including under/overflow
+std::shared_ptr<TH1> make_hist3d(int nz, const std::function<double(int x, int y, int z)> & content) {
+    auto h = std::make_shared<TH3D>(root::MakeUnique("hist3d").c_str(), "",
+                                    3, 0, 3,
+                                    2, 0, 2,
+                                    nz, 0, nz);
+    h->SetDirectory(nullptr);
+    for (auto x = 0; x <= 4; x++) {
+        for (auto y = 0; y <= 3; y++) {
+            for (auto z = 0; z <= nz + 1; z++) {
+                h->SetBinContent(x, y, z, content(x, y, z));
+                h->SetBinError(x, y, z, 0.1 * content(x, y, z));
+            }
+        }
+    }
+    return h;
+}
+
+/////////////////////////////////////////////////////////
+Array to_array(const Matrix & m) {
+    return m.reshaped().array();
+}
+
+/////////////////////////////////////////////////////////
+Matrix to_matrix(const TH1 * covariance) {
+    return root::MapContentsToEigenInner(covariance).matrix()
+            .reshaped(covariance->GetNbinsX(), covariance->GetNbinsX());
+}
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    // joining 3D histograms of different numbers of template bins
+    // places each sample after all of the previous ones and carries over
+    // the under/overflow of the leading axes
+    {
+        std::vector<int> nz = {4, 2, 3};
+        std::vector<std::shared_ptr<TH1>> hists;
+        for (auto i = 0u; i < nz.size(); i++) {
+            hists.push_back(make_hist3d(nz[i], [=](int x, int y, int z) { return 100 * (i + 1) + 10 * x + y + 0.1 * z; }));
+        }
+        auto joined = fit::detail::_join(hists);
+        assert(joined->GetNbinsX() == 3 && joined->GetNbinsY() == 2 && joined->GetNbinsZ() == 9);
+        for (auto x = 0; x <= 4; x++) {
+            for (auto y = 0; y <= 3; y++) {
+                assert(joined->GetBinContent(x, y, 0) == 0);
+                assert(joined->GetBinContent(x, y, 10) == 0);
+                int offset = 0;
+                for (auto i = 0u; i < nz.size(); i++) {
+                    for (auto z = 1; z <= nz[i]; z++) {
+                        assert(joined->GetBinContent(x, y, offset + z) == hists[i]->GetBinContent(x, y, z));
+                        assert(joined->GetBinError(x, y, offset + z) == hists[i]->GetBinError(x, y, z));
+                    }
+                    offset += nz[i];
+                }
+            }
+        }
+    }
+
+    auto mask = test::utils::make_template_fit_mask();
+    std::map<std::string, fit::TemplateFitSample> samples = {
+            {"s1", test::utils::make_template_fit_sample(1, 20)},
+            {"s2", test::utils::make_template_fit_sample(2, 20)},
+    };
+    std::map<std::string, std::string> conditioning = {
+            {"a", "s1"},
+            {"b", "s1"},
+            {"c", "s2"},
+    };
+    JointTemplateFitSignalEstimator joint(samples, conditioning, mask);
+
+    std::map<std::string, TemplateFitSignalEstimator *> direct;
+    for (const auto & sample : samples) {
+        direct[sample.first] = new TemplateFitSignalEstimator(sample.second, mask);
+    }
+
+    // the sample bins partition the joint bins, and each per-sample
+    // covariance is the block of the joint one at those bins
+    {
+        auto njoint = joint.GetTotalSystematicCovariance()->GetNbinsX();
+        std::vector<int> all_bins;
+        for (const auto & sample : samples) {
+            auto bins = joint.GetSampleBins(sample.first);
+            assert((int) bins.size() == direct.at(sample.first)->GetTotalSystematicCovariance()->GetNbinsX());
+            all_bins.insert(all_bins.end(), bins.begin(), bins.end());
+        }
+        std::sort(all_bins.begin(), all_bins.end());
+        assert((int) all_bins.size() == njoint);
+        for (auto i = 0; i < njoint; i++) assert(all_bins[i] == i);
+
+        for (const auto & label : joint.GetJointTemplateFit()->GetSystematicLabels()) {
+            Matrix joint_covariance = to_matrix(joint.GetSystematicCovariance(label));
+            for (const auto & sample : samples) {
+                auto bins = joint.GetSampleBins(sample.first);
+                Matrix block = joint_covariance(bins, bins);
+                pass &= TEST_ARRAY_SAME("block " + sample.first + " " + label,
+                                        to_array(to_matrix(joint.GetSampleTemplateFit(sample.first)
+                                                                   ->GetSystematicCovariance(label))),
+                                        to_array(block),
+                                        0,
+                                        verbose);
+            }
+        }
+    }
+
+    // per-sample estimators of the joint fit match the ones built directly from their samples
+    for (const auto & sample : samples) {
+        auto from_joint = joint.GetSampleTemplateFit(sample.first);
+        auto directly = direct.at(sample.first);
+        assert(from_joint->GetSystematicLabels() == directly->GetSystematicLabels());
+        for (const auto & label : directly->GetSystematicLabels()) {
+            Matrix expected = to_matrix(directly->GetSystematicCovariance(label));
+            pass &= TEST_ARRAY_SAME("per-sample " + sample.first + " " + label,
+                                    to_array(to_matrix(from_joint->GetSystematicCovariance(label))) /
+                                    expected.cwiseAbs().maxCoeff(),
+                                    to_array(expected) / expected.cwiseAbs().maxCoeff(),
+                                    1e-10,
+                                    verbose);
+        }
+
+        auto data = test::utils::make_template_fit_data(sample.second);
+        fit::LinearTemplateFitter fitter;
+        auto result = from_joint->Fit(data, &fitter);
+        auto expected = directly->Fit(data, &fitter);
+        for (const auto & params : expected.component_params) {
+            pass &= TEST_HIST("fit " + sample.first + " " + params.first,
+                              result.component_params.at(params.first),
+                              params.second,
+                              1e-6,
+                              verbose);
+        }
+    }
+
+    // joint components add their predictions in place, and the rows of each sample
+    // are the prediction of that sample's component with its parameters
+    {
+        const auto & components = joint.GetJointTemplateFit()->GetReducedComponents();
+        auto nouter = joint.GetJointTemplateFit()->GetReducedComponentCollection().GetNOuterBins();
+        auto njoint = joint.GetTotalSystematicCovariance()->GetNbinsX();
+
+        fit::Vector total = fit::Vector::Constant(njoint, 1);
+        fit::Vector expected_total = fit::Vector::Constant(njoint, 1);
+        auto scale = 0.8;
+        for (const auto & component : components) {
+            auto joint_component = dynamic_cast<const fit::ReducedJointTemplateComponent *>(component.second);
+            assert(joint_component);
+            fit::Vector condi_params = fit::Vector::LinSpaced(nouter, scale, scale + 0.5);
+            scale += 0.1;
+
+            fit::Vector prediction = joint_component->Predict(condi_params);
+            joint_component->PredictAdd(condi_params, total);
+            expected_total += prediction;
+
+            auto condi_label = joint_component->GetConditioningSampleLabel();
+            auto condi_bins = joint.GetSampleBins(condi_label);
+            pass &= TEST_ARRAY_SAME("conditioning rows " + component.first,
+                                    prediction(condi_bins).array(),
+                                    joint_component->GetConditioningComponent()->Predict(condi_params).array(),
+                                    1e-9,
+                                    verbose);
+            for (const auto & comp_label : joint_component->GetComplimentarySampleLabels()) {
+                auto comp_bins = joint.GetSampleBins(comp_label);
+                fit::Vector comp_params = joint_component->ComplimentaryParams(condi_params, comp_label);
+                pass &= TEST_ARRAY_SAME("complimentary rows " + component.first + " " + comp_label,
+                                        prediction(comp_bins).array(),
+                                        joint_component->GetComplimentaryComponent(comp_label)->Predict(comp_params).array(),
+                                        1e-9,
+                                        verbose);
+            }
+        }
+        pass &= TEST_ARRAY_SAME("PredictAdd",
+                                total.array(),
+                                expected_total.array(),
+                                1e-9,
+                                verbose);
+    }
+
+    // three samples, with components conditioned on different samples
+    {
+        std::map<std::string, fit::TemplateFitSample> samples3 = {
+                {"s1", test::utils::make_template_fit_sample(1, 20)},
+                {"s2", test::utils::make_template_fit_sample(2, 20)},
+                {"s3", test::utils::make_template_fit_sample(3, 20)},
+        };
+        std::map<std::string, std::string> conditioning3 = {
+                {"a", "s2"},
+                {"b", "s1"},
+                {"c", "s3"},
+        };
+        JointTemplateFitSignalEstimator joint3(samples3, conditioning3, mask);
+        auto nouter = joint3.GetJointTemplateFit()->GetReducedComponentCollection().GetNOuterBins();
+
+        for (const auto & component : joint3.GetJointTemplateFit()->GetReducedComponents()) {
+            auto joint_component = dynamic_cast<const fit::ReducedJointTemplateComponent *>(component.second);
+            assert(joint_component->GetConditioningSampleLabel() == conditioning3.at(component.first));
+            const auto & comp_labels = joint_component->GetComplimentarySampleLabels();
+            assert(comp_labels.size() == 2);
+            assert(std::find(comp_labels.begin(), comp_labels.end(),
+                             conditioning3.at(component.first)) == comp_labels.end());
+
+            // the nominal conditioning sample predicts nominal complimentary samples
+            pass &= TEST_ARRAY_SAME("nominal " + component.first,
+                                    joint_component->ComplimentaryParams(fit::Vector::Ones(nouter)).array(),
+                                    Array::Ones(2 * nouter),
+                                    1e-9,
+                                    verbose);
+
+            fit::Vector condi_params = fit::Vector::LinSpaced(nouter, 0.7, 1.4);
+            fit::Vector stacked = joint_component->ComplimentaryParams(condi_params);
+            assert(stacked.size() == 2 * nouter);
+            for (auto i = 0u; i < comp_labels.size(); i++) {
+                fit::Vector comp_params = joint_component->ComplimentaryParams(condi_params, comp_labels[i]);
+                pass &= TEST_ARRAY_SAME("stacked " + component.first + " " + comp_labels[i],
+                                        stacked.segment(i * nouter, nouter).array(),
+                                        comp_params.array(),
+                                        1e-12,
+                                        verbose);
+                pass &= TEST_ARRAY_SAME("conditional " + component.first + " " + comp_labels[i],
+                                        joint_component->ConditionalParams(comp_params, comp_labels[i]).array(),
+                                        condi_params.array(),
+                                        1e-8,
+                                        verbose);
+            }
+            pass &= TEST_ARRAY_SAME("conditional default " + component.first,
+                                    joint_component->ConditionalParams(stacked.head(nouter)).array(),
+                                    condi_params.array(),
+                                    1e-8,
+                                    verbose);
+        }
+
+        // the fit gives every sample the parameters its components predict for it
+        std::map<std::string, std::shared_ptr<TH1>> data;
+        for (const auto & sample : samples3) {
+            data[sample.first] = test::utils::make_template_fit_data(sample.second);
+        }
+        fit::LinearTemplateFitter fitter;
+        auto results = joint3.Fit(data, &fitter);
+        assert(results.size() == samples3.size() + 1);
+        const auto & joint_params = results.at("joint").component_params;
+        for (const auto & sample : samples3) {
+            auto expected = joint3.ComplimentaryParams(joint_params, sample.first);
+            for (const auto & params : expected) {
+                pass &= TEST_HIST("joint fit " + sample.first + " " + params.first,
+                                  results.at(sample.first).component_params.at(params.first),
+                                  params.second,
+                                  1e-12,
+                                  verbose);
+            }
+        }
+        auto inverted = joint3.InvertParams(joint_params);
+        auto first_comp = joint3.ComplimentaryParams(joint_params);
+        for (const auto & params : first_comp) {
+            pass &= TEST_HIST("InvertParams " + params.first,
+                              inverted.at(params.first),
+                              params.second,
+                              0,
+                              verbose);
+        }
+    }
+
+    // an estimator assembled from reduced components and covariance matrices
+    // fits like the one that reduced them
+    {
+        auto directly = direct.at("s1");
+        std::map<std::string, Matrix> covariances;
+        for (const auto & label : directly->GetSystematicLabels()) {
+            covariances[label] = to_matrix(directly->GetSystematicCovariance(label));
+        }
+        TemplateFitSignalEstimator assembled(samples.at("s1"), mask,
+                                             directly->GetReducedComponentCollection(),
+                                             covariances);
+        pass &= TEST_ARRAY_SAME("assembled covariance",
+                                to_array(to_matrix(assembled.GetTotalSystematicCovariance())),
+                                to_array(to_matrix(directly->GetTotalSystematicCovariance())),
+                                0,
+                                verbose);
+
+        auto data = test::utils::make_template_fit_data(samples.at("s1"), 0.8);
+        fit::LinearTemplateFitter fitter;
+        auto result = assembled.Fit(data, &fitter);
+        auto expected = directly->Fit(data, &fitter);
+        for (const auto & params : expected.component_params) {
+            pass &= TEST_HIST("assembled fit " + params.first,
+                              result.component_params.at(params.first),
+                              params.second,
+                              1e-10,
+                              verbose);
+        }
+    }
+
+    return !pass;
+}
@@ -0,0 +1,90 @@
+#include "XSecAna/Analysis.h"
+#include "XSecAna/SimpleFlux.h"
+#include "test_utils.h"
+#include <iostream>
+
+#include "TFile.h"
+
+using namespace xsec;
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto ones = test::utils::get_hist_of_ones();
+    SimpleFlux nominal(ones);
+
+    // shift i scales the flux by i + 1
+    auto scaled_flux = [&](int scale) {
+        auto h = (TH1 *) ones->Clone();
+        h->Scale(scale);
+        return std::make_shared<SimpleFlux>(h);
+    };
+    std::vector<std::shared_ptr<IMeasurement>> universes;
+    for (auto i = 0; i < 20; i++) universes.push_back(scaled_flux(i + 1));
+    std::vector<Systematic<IMeasurement>> systematics = {
+            Systematic<IMeasurement>("mv", universes),
+            Systematic<IMeasurement>("1sided", scaled_flux(2)),
+            Systematic<IMeasurement>("2sided", scaled_flux(2), scaled_flux(3)),
+    };
+
+    // serial and parallel writes produce the same analysis
+    std::string serial_file_name = test::utils::test_dir() + "test_lazy_analysis_serial.root";
+    std::string parallel_file_name = test::utils::test_dir() + "test_lazy_analysis_parallel.root";
+    auto output = new TFile(serial_file_name.c_str(), "recreate");
+    SaveAnalysis(&nominal, systematics, ones, output, "analysis");
+    output->Close();
+    delete output;
+    SaveAnalysis(&nominal, systematics, ones, parallel_file_name, "analysis", 4);
+
+    for (const auto & file_name : {serial_file_name, parallel_file_name}) {
+        LazyAnalysis analysis(SimpleFlux::LoadFrom, file_name, "analysis");
+        assert(analysis.GetNSystematics() == systematics.size());
+
+        pass &= TEST_HIST("nominal",
+                          analysis.GetNominal()->Eval(analysis.GetData()).get(),
+                          ones,
+                          0,
+                          verbose);
+
+        // nothing is read until asked for
+        for (auto i = 0u; i < systematics.size(); i++) {
+            assert(analysis.GetSystematicName(i) == systematics[i].GetName());
+            assert(analysis.GetSystematicType(i) == systematics[i].GetType());
+            assert(analysis.GetNShifts(i) == systematics[i].GetShifts().size());
+            assert(!analysis.IsLoaded(i));
+        }
+
+        analysis.Prefetch(2);
+        auto mv = analysis.GetSystematic(0);
+        assert(analysis.IsLoaded(0));
+        assert(mv.GetType() == kMultiverse);
+        for (auto i = 0u; i < universes.size(); i++) {
+            pass &= TEST_HIST("universe " + std::to_string(i),
+                              mv.GetShifts()[i]->Eval(ones).get(),
+                              universes[i]->Eval(ones).get(),
+                              0,
+                              verbose);
+        }
+        auto up = analysis.GetShift(2, 0);
+        pass &= TEST_HIST("2sided up",
+                          up->Eval(ones).get(),
+                          systematics[2].Up()->Eval(ones).get(),
+                          0,
+                          verbose);
+
+        // dropped shifts stay valid for their holders and are reloaded on demand
+        analysis.Drop(0);
+        assert(!analysis.IsLoaded(0));
+        pass &= TEST_HIST("dropped universe",
+                          mv.GetShifts()[3]->Eval(ones).get(),
+                          universes[3]->Eval(ones).get(),
+                          0,
+                          verbose);
+        assert(analysis.GetShift(0, 3) != mv.GetShifts()[3]);
+        analysis.DropAll();
+    }
+
+    return !pass;
+}
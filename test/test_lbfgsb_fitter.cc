@@ -0,0 +1,106 @@
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/LBFGSBFitter.h"
+
+#include "test_utils.h"
+
+#include <Eigen/Dense>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+///\brief (x - a)^T Q (x - a) with finite difference derivatives from IFitCalculator
+class QuadraticCalculator : public IFitCalculator {
+public:
+    QuadraticCalculator(const Matrix & Q, const Vector & a) : fQ(Q), fA(a) {}
+
+    double fun(const Vector & params, const Vector & data) const override {
+        fNFunCalls++;
+        return (params - fA).dot(fQ * (params - fA));
+    }
+
+    unsigned int GetNMinimizerParams() const override { return fA.size(); }
+    unsigned int GetNUserParams() const override { return fA.size(); }
+    unsigned int GetNFunCalls() const override { return fNFunCalls; }
+    Vector ToUserParams(const Vector & minimizer_coords) const override { return minimizer_coords; }
+    Vector ToMinimizerParams(const Vector & user_coords) const override { return user_coords; }
+
+private:
+    Matrix fQ;
+    Vector fA;
+    mutable unsigned int fNFunCalls = 0;
+};
+
+int main(int argc, char ** argv) {
+    // bounded quadratic. Compare to the active set solution
+    auto n = 20;
+    Matrix R = Matrix::Random(n, n);
+    Matrix Q = R * R.transpose() + Matrix::Identity(n, n);
+    Vector a = Vector::LinSpaced(n, -1, 2);
+    QuadraticCalculator quadratic(Q, a);
+
+    LBFGSBFitter fitter(1, 10, 10000, 1e-8, 0);
+    auto result = fitter.Fit(&quadratic, Vector());
+    Vector target = LinearTemplateFitter::NNLS(Q, Q * a, Vector::Zero(n));
+    assert(result.is_valid);
+    assert((result.params.array() >= 0).all());
+    assert((result.params - target).isZero(1e-5));
+
+    // template fit
+    auto dims = test::utils::template_fit_dims;
+    auto templates = test::utils::make_reduced_templates();
+    auto nbins = dims[0] * dims[1];
+    Matrix covariance = test::utils::make_template_covariance();
+    auto fit_calc = new TemplateFitCalculator(ReducedComponentCollection(templates), dims, covariance);
+
+    Vector truth = Vector::LinSpaced(fit_calc->GetNUserParams(), 0.5, 2);
+    truth(1) = -0.5;
+    Vector data = fit_calc->Predict(truth) + Vector::LinSpaced(nbins, -1, 1);
+
+    // analytic gradient agrees with finite differences
+    Vector params = Vector::LinSpaced(fit_calc->GetNMinimizerParams(), 0.8, 1.2);
+    for (auto ignore_stat : {true, false}) {
+        fit_calc->SetIgnoreStatisticalUncertainty(ignore_stat);
+        Vector analytic = fit_calc->Gradient(params, data);
+        Vector numeric = fit_calc->IFitCalculator::Gradient(params, data);
+        assert((analytic - numeric).norm() < 1e-5 * analytic.norm());
+    }
+
+    // with a fixed covariance both fitters find the same bounded minimum
+    fit_calc->SetIgnoreStatisticalUncertainty(true);
+    LBFGSBFitter lbfgsb;
+    LinearTemplateFitter linear;
+    auto lbfgsb_result = lbfgsb.Fit(fit_calc, data);
+    auto linear_result = linear.Fit(fit_calc, data);
+    assert(std::abs(lbfgsb_result.fun_val - linear_result.fun_val) < 1e-6 * linear_result.fun_val);
+    assert((lbfgsb_result.params - linear_result.params).isZero(1e-3));
+    assert((lbfgsb_result.covariance - linear_result.covariance).isZero(1e-6));
+
+    // with the statistical term the linear fitter is an approximation
+    fit_calc->SetIgnoreStatisticalUncertainty(false);
+    lbfgsb_result = lbfgsb.Fit(fit_calc, data);
+    linear_result = linear.Fit(fit_calc, data);
+    assert(lbfgsb_result.fun_val <= linear_result.fun_val + 1e-6);
+    assert((lbfgsb_result.params.array() >= 0).all());
+
+    // covariance round trip between user and minimizer parameters with a fixed template
+    fit_calc->FixTemplate(2, 1);
+    Matrix minimizer_covariance = Matrix::Identity(fit_calc->GetNMinimizerParams(), fit_calc->GetNMinimizerParams());
+    minimizer_covariance(0, 1) = minimizer_covariance(1, 0) = 0.5;
+    Array2D user_covariance = fit_calc->ToUserCovariance(minimizer_covariance);
+    assert((user_covariance.row(2) == 0).all());
+    assert(fit_calc->ToMinimizerCovariance(user_covariance) == minimizer_covariance);
+    assert(fit_calc->IFitCalculator::ToMinimizerCovariance(user_covariance).isApprox(minimizer_covariance));
+    fit_calc->ReleaseTemplate(2);
+
+    // warm starting from the previous minimum saves iterations on similar data
+    Vector similar_data = data + Vector::LinSpaced(nbins, 0.1, -0.1);
+    auto cold = lbfgsb.Fit(fit_calc, similar_data);
+    auto cold_iterations = lbfgsb.GetNIterations();
+    lbfgsb.WarmStart(fit_calc->ToMinimizerParams(lbfgsb_result.params),
+                     fit_calc->ToMinimizerCovariance(lbfgsb_result.covariance));
+    auto warm = lbfgsb.Fit(fit_calc, similar_data);
+    assert(std::abs(warm.fun_val - cold.fun_val) < 1e-6 * cold.fun_val);
+    assert(lbfgsb.GetNIterations() < cold_iterations);
+}
@@ -0,0 +1,111 @@
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/Minuit2TemplateFitter.h"
+
+#include "test_utils.h"
+
+#include <Eigen/Dense>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+int main(int argc, char ** argv) {
+    // bounded least squares with a known solution
+    // unconstrained minimum is (2, -1), bounded minimum is (1.5, 0)
+    Matrix H(2, 2);
+    H << 2, 1,
+         1, 2;
+    Vector f = H * (Vector(2) << 2, -1).finished();
+    Vector x = LinearTemplateFitter::NNLS(H, f, Vector::Ones(2));
+    assert(std::abs(x(0) - 1.5) < 1e-12 && x(1) == 0);
+    x = LinearTemplateFitter::NNLS(H, H * Vector::Ones(2), Vector::Zero(2));
+    assert((x - Vector::Ones(2)).isZero(1e-12));
+
+    auto dims = test::utils::template_fit_dims;
+    auto templates = test::utils::make_reduced_templates();
+    Matrix covariance = test::utils::make_template_covariance();
+
+    auto fit_calc = new TemplateFitCalculator(ReducedComponentCollection(templates), dims, covariance);
+
+    // prediction is affine in the user parameters
+    Vector truth = Vector::LinSpaced(fit_calc->GetNUserParams(), 0.5, 2);
+    Vector affine = fit_calc->GetPredictionOffset() + fit_calc->GetDesignMatrix() * truth;
+    assert((affine - fit_calc->Predict(truth)).isZero(1e-10));
+
+    LinearTemplateFitter fitter;
+    Vector data = fit_calc->Predict(truth);
+
+    // with and without statistical uncertainty, exact data is fit exactly
+    for (auto ignore_stat : {true, false}) {
+        fit_calc->SetIgnoreStatisticalUncertainty(ignore_stat);
+        auto result = fitter.Fit(fit_calc, data);
+        assert(result.is_valid);
+        assert((result.params - truth).isZero(1e-6));
+        assert(result.fun_val < 1e-10);
+        assert(result.covariance.rows() == fit_calc->GetNUserParams());
+        assert((result.params_error_up > 0).all());
+    }
+
+    // fixed parameters are excluded from the fit
+    fit_calc->FixTemplate(3, truth(3));
+    auto result = fitter.Fit(fit_calc, data);
+    assert((result.params - truth).isZero(1e-6));
+    assert(result.params_error_up(3) == 0);
+    assert((result.covariance.row(3) == 0).all());
+    fit_calc->ReleaseTemplate(3);
+
+    // non-negativity bounds are respected
+    Vector negative_truth = truth;
+    negative_truth(1) = -0.5;
+    Vector negative_data = fit_calc->Predict(negative_truth);
+    fit_calc->SetIgnoreStatisticalUncertainty(true);
+    result = fitter.Fit(fit_calc, negative_data);
+    assert((result.params.array() >= 0).all());
+    assert(result.params(1) == 0);
+
+    // the minimum found is a minimum of the bounded problem
+    auto fun_val = result.fun_val;
+    for (auto i = 0u; i < fit_calc->GetNMinimizerParams(); i++) {
+        for (auto step : {-1e-3, 1e-3}) {
+            Vector shifted = fit_calc->ToMinimizerParams(result.params);
+            shifted(i) += step;
+            if (shifted(i) < 0) continue;
+            assert(fit_calc->fun(shifted, negative_data) >= fun_val);
+        }
+    }
+
+    // use the linear fitter as a seed for minuit
+    fit_calc->SetIgnoreStatisticalUncertainty(false);
+    Minuit2TemplateFitter minuit(2, 1, false);
+    minuit.SetPrintLevel(0);
+    minuit.SetSeedFitter(&fitter);
+    result = minuit.Fit(fit_calc, data);
+    assert(result.is_valid);
+    assert(result.fun_val < 1e-6);
+
+    // clones keep their own copy of the seed fitter
+    {
+        LinearTemplateFitter seed;
+        minuit.SetSeedFitter(&seed);
+    }
+    std::unique_ptr<IFitter> clone(minuit.Clone());
+    minuit.SetSeedFitter(nullptr);
+    auto clone_result = clone->Fit(fit_calc, data);
+    assert(clone_result.is_valid);
+    assert(std::abs(clone_result.fun_val - result.fun_val) < 1e-6);
+
+    // warm starting from the previous minimum saves function calls on similar data
+    minuit.SetSeedFitter(nullptr);
+    Vector similar_data = data + Vector::LinSpaced(data.size(), -0.5, 0.5);
+    auto ncalls = fit_calc->GetNFunCalls();
+    auto cold = minuit.Fit(fit_calc, similar_data);
+    auto cold_calls = fit_calc->GetNFunCalls() - ncalls;
+
+    minuit.WarmStart(fit_calc->ToMinimizerParams(result.params),
+                     fit_calc->ToMinimizerCovariance(result.covariance));
+    ncalls = fit_calc->GetNFunCalls();
+    auto warm = minuit.Fit(fit_calc, similar_data);
+    assert(fit_calc->GetNFunCalls() - ncalls < cold_calls);
+    assert(std::abs(warm.fun_val - cold.fun_val) < 1e-4 * (1 + cold.fun_val));
+}
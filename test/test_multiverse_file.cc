@@ -0,0 +1,85 @@
+#include "XSecAna/MultiverseFile.h"
+#include "test_utils.h"
+#include <iostream>
+
+#include "TFile.h"
+
+using namespace xsec;
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto nominal = test::utils::get_simple_nominal_hist();
+    int nuniverses = 50;
+    auto universes = test::utils::make_simple_hist_multiverse(nominal, nuniverses);
+    Systematic<TH1> syst("test_mv", universes);
+    MultiverseMatrix expected(universes);
+
+    std::string path = test::utils::test_dir() + "test_multiverse_file.bin";
+    // uncompressed, compressed in one chunk, compressed in uneven chunks
+    for (auto [compression, universes_per_chunk] : std::vector<std::pair<int, int>>{{0, 0}, {101, 0}, {101, 7}}) {
+        MultiverseFile::Write(syst, path, compression, universes_per_chunk);
+        MultiverseFile file(path);
+        assert(file.GetName() == "test_mv");
+        assert(file.GetType() == kMultiverse);
+        assert(file.GetNUniverses() == nuniverses);
+        assert(file.GetNBins() == expected.GetNBins());
+        assert(file.IsCompressed() == (compression > 0));
+
+        auto read = file.Read();
+        assert(read->GetMatrix() == expected.GetMatrix());
+        assert(read->GetErrors() == expected.GetErrors());
+
+        // partial reads
+        auto some = file.ReadUniverses(5, 20);
+        assert(some->GetMatrix() == expected.GetMatrix().middleCols(5, 20));
+        assert(file.ReadBins(2, 3) == expected.GetMatrix().middleRows(2, 3));
+        assert(file.ReadBins(1, 4, true) == expected.GetErrors().middleRows(1, 4));
+
+        if (!file.IsCompressed()) {
+            assert(file.Map() == expected.GetMatrix());
+        }
+
+        // loaded systematics are matrix backed and match the original histograms
+        auto loaded = file.Load();
+        assert(loaded.GetUniverseMatrix());
+        pass &= TEST_MULTIVERSE("load " + std::to_string(compression),
+                                loaded,
+                                syst,
+                                0,
+                                verbose);
+    }
+
+    // round trip through the per-histogram ROOT layout
+    std::string root_file_name = test::utils::test_dir() + "test_multiverse_file.root";
+    auto output = new TFile(root_file_name.c_str(), "recreate");
+    MultiverseFile(path).Load().SaveTo(output, "test_mv");
+    output->Close();
+    delete output;
+
+    TFile * input = TFile::Open(root_file_name.c_str());
+    auto from_root = Systematic<TH1>::LoadFrom(root::LoadTH1, input, "test_mv");
+    input->Close();
+    delete input;
+    pass &= TEST_MULTIVERSE("root round trip",
+                            *from_root,
+                            syst,
+                            0,
+                            verbose);
+
+    // two-sided systematics are stored too
+    Systematic<TH1> two_sided("two_sided", universes[0], universes[1]);
+    MultiverseFile::Write(two_sided, path);
+    auto loaded = MultiverseFile(path).Load();
+    assert(loaded.GetType() == kTwoSided);
+    pass &= TEST_HIST("two sided down",
+                      loaded.Down().get(),
+                      universes[1].get(),
+                      0,
+                      verbose);
+
+    std::remove(path.c_str());
+    return !pass;
+}
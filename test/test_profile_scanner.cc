@@ -0,0 +1,89 @@
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/LBFGSBFitter.h"
+#include "XSecAna/Fit/ProfileScanner.h"
+#include "XSecAna/Parallel.h"
+
+#include "test_utils.h"
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+int main(int argc, char ** argv) {
+    // paths cover every value once and walk away from the origin
+    std::vector<double> values = {0.3, 1.5, 0.9, 0.1, 1.1, 0.7, 1.3, 0.5};
+    for (auto npaths : {1, 3, 8}) {
+        auto paths = ProfileScanner::SweepPaths(values, 0.8, npaths);
+        std::vector<int> count(values.size(), 0);
+        for (const auto & path : paths) {
+            for (auto i = 1u; i < path.size(); i++) {
+                assert(std::abs(values[path[i]] - 0.8) > std::abs(values[path[i - 1]] - 0.8));
+            }
+            for (const auto & i : path) count[i]++;
+        }
+        assert(std::all_of(count.begin(), count.end(), [](int c) { return c == 1; }));
+    }
+
+    auto dims = test::utils::template_fit_dims;
+    auto templates = test::utils::make_reduced_templates();
+    auto nbins = dims[0] * dims[1];
+    Matrix covariance = test::utils::make_template_covariance();
+    auto fit_calc = new TemplateFitCalculator(ReducedComponentCollection(templates), dims, covariance);
+    fit_calc->SetIgnoreStatisticalUncertainty(true);
+
+    Vector truth = Vector::LinSpaced(fit_calc->GetNUserParams(), 0.5, 2);
+    Vector data = fit_calc->Predict(truth) + Vector::LinSpaced(nbins, -1, 1);
+
+    LinearTemplateFitter fitter;
+    auto best = fitter.Fit(fit_calc, data);
+
+    // 1D scan in parallel matches fixing and refitting point by point
+    parallel::SetNThreads(4);
+    int param = 2;
+    std::vector<double> scan_values;
+    for (auto i = 0; i < 11; i++) scan_values.push_back(best.params(param) + (i - 5) * 0.1);
+    ProfileScanner scanner(fit_calc, &fitter);
+    auto results = scanner.Scan(data,
+                                {param},
+                                Eigen::Map<const Vector>(scan_values.data(), scan_values.size()),
+                                ProfileScanner::SweepPaths(scan_values, best.params(param), 4),
+                                best);
+    assert(fit_calc->GetNMinimizerParams() == fit_calc->GetNUserParams());
+    for (auto i = 0u; i < scan_values.size(); i++) {
+        auto serial_calc = fit_calc->Clone();
+        serial_calc->FixTemplate(param, scan_values[i]);
+        auto serial = fitter.Fit(serial_calc, data);
+        assert(results[i].is_valid);
+        assert(std::abs(results[i].fun_val - serial.fun_val) < 1e-8 * (1 + serial.fun_val));
+        assert(results[i].params(param) == scan_values[i]);
+        assert(results[i].fun_val >= best.fun_val - 1e-8);
+        delete serial_calc;
+    }
+    // the profile is lowest at the global minimum
+    assert(std::abs(results[5].fun_val - best.fun_val) < 1e-8 * best.fun_val);
+
+    // 2D scan with warm started L-BFGS-B fits agrees with the linear fitter
+    LBFGSBFitter lbfgsb;
+    ProfileScanner scanner2d(fit_calc, &lbfgsb, 2);
+    Matrix points(9, 2);
+    std::vector<std::vector<int>> paths(3);
+    for (auto i = 0; i < 3; i++) {
+        for (auto j = 0; j < 3; j++) {
+            points.row(i * 3 + j) << best.params(0) + 0.1 * (i - 1), best.params(4) + 0.1 * j;
+            paths[i].push_back(i * 3 + j);
+        }
+    }
+    auto results2d = scanner2d.Scan(data, {0, 4}, points, paths, best);
+    for (auto i = 0; i < points.rows(); i++) {
+        auto serial_calc = fit_calc->Clone();
+        serial_calc->FixTemplate(0, points(i, 0));
+        serial_calc->FixTemplate(4, points(i, 1));
+        auto serial = fitter.Fit(serial_calc, data);
+        assert(std::abs(results2d[i].fun_val - serial.fun_val) < 1e-5 * serial.fun_val);
+        delete serial_calc;
+    }
+}
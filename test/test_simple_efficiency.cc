@@ -68,6 +68,35 @@ int main(int argc, char ** argv) {
               0,
               verbose);
 
+    // the cached result is reused until the cache is invalidated
+    assert(eff.IsDataIndependent());
+    num->SetBinContent(1, 5);
+    pass &= TEST_HIST("cached ratio",
+                      eff.Eval(den).get(),
+                      expected,
+                      0,
+                      verbose);
+    eff.InvalidateCache();
+    expected->SetBinContent(1, 0.5);
+    expected->SetBinError(1, std::sqrt(0.5 * 0.5 / 10));
+    pass &= TEST_HIST("changed numerator",
+                      eff.Eval(den).get(),
+                      expected,
+                      1e-15,
+                      verbose);
+    den->SetBinContent(1, 20);
+    eff.InvalidateCache();
+    expected->SetBinContent(1, 0.25);
+    expected->SetBinError(1, std::sqrt(0.25 * 0.75 / 20));
+    pass &= TEST_HIST("changed denominator",
+                      eff.Eval(num).get(),
+                      expected,
+                      1e-15,
+                      verbose);
+    num->SetBinContent(1, 1);
+    den->SetBinContent(1, 10);
+    eff.InvalidateCache();
+
     std::string test_file_name = "test_simple_efficiency.root";
     auto output = new TFile(test_file_name.c_str(), "recreate");
     eff.SaveTo(output, "simple_efficiency");
@@ -137,6 +137,25 @@ int main(int argc, char ** argv) {
                       1e-11,
                       verbose);
 
+    // every column of a batch agrees with evaluating it on its own
+    {
+        Array2D batch_data(data->GetNbinsX() + 2, 3), batch_error(data->GetNbinsX() + 2, 3);
+        std::vector<std::shared_ptr<TH1>> universes;
+        for (auto i = 0; i < batch_data.cols(); i++) {
+            universes.emplace_back((TH1 *) data->Clone());
+            universes.back()->Scale(1 + 0.1 * i);
+            root::MapToEigen(universes.back().get(), batch_data.col(i), batch_error.col(i));
+        }
+        for (auto estimator : std::vector<IEigenEval *>{xsec, xsec_differential}) {
+            auto [result, rerror] = estimator->EvalBatch(data, batch_data, batch_error);
+            for (auto i = 0; i < batch_data.cols(); i++) {
+                auto single = estimator->Eval(universes[i].get());
+                pass &= (result.col(i) - root::MapContentsToEigen(single.get())).isZero(1e-12);
+                pass &= (rerror.col(i) - root::MapErrorsToEigen(single.get())).isZero(1e-12);
+            }
+        }
+    }
+
     std::string test_file_name = test::utils::test_dir() + "test_simple_xsec.root";
     auto output = new TFile(test_file_name.c_str(), "recreate");
     xsec->SaveTo(output, "xsec");
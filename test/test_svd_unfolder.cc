@@ -0,0 +1,80 @@
+#include "XSecAna/SVDUnfolder.h"
+#include "XSecAna/Utils.h"
+
+#include <iostream>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TH2D.h"
+
+using namespace xsec;
+
+int main(int argc, char ** argv) {
+    // near-diagonal migrations
+    const int nbins = 10;
+    auto response = new TH2D("", "", nbins, 0, 1, nbins, 0, 1);
+    auto truth = new TH1D("", "", nbins, 0, 1);
+    for (auto j = 0; j <= nbins + 1; j++) {
+        response->SetBinContent(j, j, 80 + j);
+        if (j > 0) response->SetBinContent(j - 1, j, 10);
+        if (j < nbins + 1) response->SetBinContent(j + 1, j, 12);
+        truth->SetBinContent(j, 50 + 5 * j);
+    }
+    Matrix migration = root::MapContentsToEigen(response).matrix().reshaped(nbins + 2, nbins + 2);
+    migration = migration * migration.colwise().sum().cwiseInverse().asDiagonal();
+
+    // closure with negligible regularization
+    SVDUnfolder unfold(response, 1e-8);
+    Vector true_contents = root::MapContentsToEigen(truth).matrix();
+    Vector reco_contents = migration * true_contents;
+    auto reco = root::ToROOTLike(truth, reco_contents.array(), reco_contents.array().sqrt());
+    auto unfolded = unfold.Truth(reco);
+    assert((root::MapContentsToEigen(unfolded.get()) - true_contents.array()).isZero(1e-6 * true_contents.norm()));
+
+    // re-unfolding at another strength agrees with solving the regularized problem directly
+    const double tau = 0.3;
+    Matrix curvature = Matrix::Zero(nbins + 2, nbins + 2);
+    for (auto i = 0; i < nbins + 2; i++) {
+        curvature(i, i) = -2 - 1e-3;
+        if (i > 0) curvature(i, i - 1) = 1;
+        if (i < nbins + 1) curvature(i, i + 1) = 1;
+    }
+    curvature(0, 0) = curvature(nbins + 1, nbins + 1) = -1 - 1e-3;
+    Vector noisy = reco_contents + Vector::LinSpaced(nbins + 2, -3, 3);
+    Vector direct = (migration.transpose() * migration + tau * tau * curvature.transpose() * curvature)
+            .ldlt().solve(migration.transpose() * noisy);
+    Vector regularized = unfold.Unfold(noisy, tau);
+    assert((regularized - direct).isZero(1e-8 * direct.norm()));
+
+    // scan norms match the unfolded results
+    auto scan = unfold.ScanTau(noisy, {0.01, tau, 3});
+    assert(scan.size() == 3 && scan[1].tau == tau);
+    assert(std::abs(scan[1].residual_norm - (migration * regularized - noisy).norm()) < 1e-8);
+    assert(std::abs(scan[1].solution_norm - (curvature * regularized).norm()) < 1e-8);
+    // stronger regularization trades residual for smoothness
+    assert(scan[0].residual_norm < scan[2].residual_norm);
+    assert(scan[0].solution_norm > scan[2].solution_norm);
+
+    // universes unfold in one product
+    Matrix universes = reco_contents * Eigen::RowVectorXd::LinSpaced(5, 0.9, 1.1);
+    unfold.SetTau(tau);
+    Matrix unfolded_universes = unfold.Unfold(universes);
+    for (auto i = 0; i < universes.cols(); i++) {
+        assert((unfolded_universes.col(i) - unfold.Unfold(universes.col(i), tau)).isZero(1e-10));
+    }
+
+    // save and load the factorization
+    std::string fname = "test_svd_unfolder.root";
+    auto output = new TFile(fname.c_str(), "recreate");
+    unfold.SaveTo(output, "unfold");
+    output->Close();
+
+    auto input = TFile::Open(fname.c_str());
+    auto loaded = SVDUnfolder::LoadFrom(input, "unfold");
+    assert(loaded->cast<SVDUnfolder>()->GetTau() == tau);
+    auto loaded_unfolded = loaded->Eval(reco);
+    auto expected = unfold.Eval(reco);
+    assert((root::MapContentsToEigen(loaded_unfolded.get()) -
+            root::MapContentsToEigen(expected.get())).isZero(1e-10));
+    input->Close();
+}
@@ -2,13 +2,16 @@
 #include <stdio.h>
 
 #include "XSecAna/Systematic.h"
+#include "XSecAna/MultiverseMatrix.h"
 #include "XSecAna/SimpleEfficiency.h"
 #include "XSecAna/SimpleFlux.h"
 #include "XSecAna/SimpleSignalEstimator.h"
+#include "XSecAna/Fit/TemplateFitComponent.h"
 #include "test_utils.h"
 
 #include <Eigen/Dense>
 #include "TFile.h"
+#include "TH2D.h"
 
 using namespace xsec;
 
@@ -225,6 +228,32 @@ bool run_tests_mv(bool verbose, std::string dir) {
                       verbose);
 
 
+    // the same multiverse backed by a single matrix
+    Systematic<TH1> syst_matrix("test_mv", std::make_shared<MultiverseMatrix>(universes));
+    assert(syst_matrix.GetUniverseMatrix()->GetNUniverses() == nuniverses);
+    assert(syst_matrix.GetNShifts() == nuniverses);
+    pass &= TEST_HIST("matrix minus 1 sigma",
+                      MultiverseShift(syst_matrix, nominal, -1),
+                      minus_1sigma,
+                      0,
+                      verbose);
+    pass &= TEST_HIST("matrix plus 1 sigma",
+                      MultiverseShift(syst_matrix, nominal, 1),
+                      plus_1sigma,
+                      0,
+                      verbose);
+    pass &= TEST_HIST("matrix covariance",
+                      syst_matrix.CovarianceMatrix(nominal),
+                      syst.CovarianceMatrix(nominal),
+                      1e-12,
+                      verbose);
+    // universe histograms are made on demand
+    pass &= TEST_MULTIVERSE("matrix universes",
+                            syst_matrix,
+                            syst,
+                            0,
+                            verbose);
+
     // save everything for later inspection
     TFile * output = new TFile(test_file_name.c_str(), "update");
     nominal->Write("nominal");
@@ -269,6 +298,46 @@ bool run_tests_mv(bool verbose, std::string dir) {
 }
 
 
+bool run_tests_reducer(bool verbose) {
+    bool pass = true;
+
+    // analysis variable on x, template variable on y
+    const int nx = 5;
+    const int ny = 4;
+    const int nuniverses = 10;
+    std::vector<std::shared_ptr<TH1>> universes;
+    for (auto u = 0; u < nuniverses; u++) {
+        auto h = std::make_shared<TH2D>(root::MakeUnique("universe").c_str(), "",
+                                        nx, 0, nx,
+                                        ny, 0, ny);
+        for (auto i = 0; i <= nx + 1; i++) {
+            for (auto j = 0; j <= ny + 1; j++) {
+                h->SetBinContent(i, j, 1 + i + 10 * j + 0.1 * u * (i - j));
+            }
+        }
+        universes.push_back(h);
+    }
+
+    // mask out one analysis bin
+    TH1D mask("mask", "", nx, 0, nx);
+    for (auto i = 0; i <= nx + 1; i++) mask.SetBinContent(i, i == 3 ? 0 : 1);
+    fit::ComponentReducer reducer(&mask);
+
+    // gathering every universe with a reduced index histogram agrees with reducing them one by one
+    Systematic<TH1> syst("mv", universes);
+    Systematic<TH1> syst_matrix("mv", std::make_shared<MultiverseMatrix>(universes));
+    auto reduced = reducer.Reduce(syst);
+    auto reduced_matrix = reducer.Reduce(syst_matrix);
+    assert(reduced_matrix.GetUniverseMatrix());
+    assert(reduced_matrix.GetNShifts() == nuniverses);
+    pass &= TEST_MULTIVERSE("reduced matrix universes",
+                            reduced_matrix,
+                            reduced,
+                            0,
+                            verbose);
+    return pass;
+}
+
 int main(int argc, char ** argv) {
     bool verbose = false;
     if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
@@ -282,6 +351,8 @@ int main(int argc, char ** argv) {
 
     pass &= run_tests_mv<double, Eigen::Dynamic>(verbose, "mv_double_dynamic");
 
+    pass &= run_tests_reducer(verbose);
+
     auto den = test::utils::get_simple_nominal_hist();
     auto num = test::utils::get_simple_down_hist();
 
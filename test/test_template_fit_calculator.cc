@@ -5,6 +5,7 @@
 
 #include "XSecAna/Fit/TemplateFitCalculator.h"
 #include "XSecAna/Fit/Minuit2TemplateFitter.h"
+#include "XSecAna/Fit/CovarianceSolver.h"
 #
 #include <Eigen/Dense>
 #include <iostream>
@@ -120,6 +121,75 @@ int main(int argc, char ** argv) {
 
     assert(result.fun_val == fit_calc->Chi2(fit_calc->ToUserParams(result.params),
                                             fit_calc->Predict(user_params)));
+
+    // seeds are reproducible and stratified in every parameter
+    auto nthrows = 50;
+    auto seeds = fit_calc->GetRandomSeeds(nthrows, -0.5, 0.5, 7);
+    auto same_seeds = fit_calc->GetRandomSeeds(nthrows, -0.5, 0.5, 7);
+    for (auto i = 0; i < nthrows; i++) assert((seeds[i] == same_seeds[i]).all());
+    assert(!(seeds[0] == fit_calc->GetRandomSeeds(nthrows, -0.5, 0.5, 8)[0]).all());
+    for (auto iparam = 0u; iparam < fit_calc->GetNMinimizerParams(); iparam++) {
+        std::vector<int> stratum_count(nthrows, 0);
+        for (const auto & seed : seeds) {
+            assert(seed(iparam) >= 0.5 && seed(iparam) < 1.5);
+            stratum_count[std::min(nthrows - 1, int((seed(iparam) - 0.5) * nthrows))]++;
+        }
+        assert(std::all_of(stratum_count.begin(), stratum_count.end(), [](int c) { return c == 1; }));
+    }
+
+    // parallel seed scoring returns the lowest chi2 seeds in order
+    auto ncalls = fit_calc->GetNFunCalls();
+    Vector seed_data = fit_calc->Predict(user_params);
+    auto best_seeds = fit_calc->GetBestSeeds(seed_data, seeds, 5);
+    assert(best_seeds.size() == 5);
+    assert(fit_calc->GetNFunCalls() == ncalls + nthrows);
+    std::vector<double> seed_chi2;
+    for (const auto & seed : seeds) seed_chi2.push_back(fit_calc->fun(seed.matrix(), seed_data));
+    std::sort(seed_chi2.begin(), seed_chi2.end());
+    for (auto i = 0u; i < best_seeds.size(); i++) {
+        assert(fit_calc->fun(best_seeds[i], seed_data) == seed_chi2[i]);
+    }
+
+    // structure-aware covariance solvers must agree with the dense solver
+    auto ncov = 60;
+    Matrix block_covariance = Matrix::Zero(ncov, ncov);
+    Matrix banded_covariance = Matrix::Zero(ncov, ncov);
+    Matrix sparse_covariance = Matrix::Zero(ncov, ncov);
+    for (auto i = 0; i < ncov; i++) {
+        block_covariance(i, i) = 1 + i;
+        banded_covariance(i, i) = 4;
+        sparse_covariance(i, i) = 10;
+        if (i % 10 && i < 50) {
+            // blocks of 10 bins, the last 10 bins are uncorrelated
+            block_covariance(i, i - 1) = block_covariance(i - 1, i) = 0.5;
+        }
+        if (i > 0) banded_covariance(i, i - 1) = banded_covariance(i - 1, i) = 1;
+        if (i > 1) banded_covariance(i, i - 2) = banded_covariance(i - 2, i) = 0.5;
+        if (i > 0) sparse_covariance(i, i - 1) = sparse_covariance(i - 1, i) = 1;
+        auto j = (i * 37 + 11) % ncov;
+        if (j != i) sparse_covariance(i, j) = sparse_covariance(j, i) = 1;
+    }
+    Vector residual = Vector::LinSpaced(ncov, -2, 3);
+    Vector stat = Vector::LinSpaced(ncov, 0.5, 5);
+
+    std::vector<std::pair<Matrix, CovarianceStructure_t>> covariances = {
+            {block_covariance, kBlockDiagonalStructure},
+            {banded_covariance, kSparseStructure},
+            {sparse_covariance, kSparseStructure},
+            {Matrix(banded_covariance + Matrix::Constant(ncov, ncov, 0.1)), kDenseStructure},
+    };
+    for (const auto & cov : covariances) {
+        CovarianceSolver detected(cov.first);
+        CovarianceSolver dense(cov.first, kDenseStructure);
+        assert(detected.GetStructure() == cov.second);
+
+        auto target = dense.Chi2(residual, stat);
+        assert(std::abs(detected.Chi2(residual, stat) - target) < 1e-10 * target);
+        target = dense.Chi2(residual);
+        assert(std::abs(detected.Chi2(residual) - target) < 1e-10 * target);
+    }
+    assert(CovarianceSolver(block_covariance).GetBlocks().size() == 15);
+    assert(CovarianceSolver(banded_covariance).GetBandwidth() == 2);
 }
 
 
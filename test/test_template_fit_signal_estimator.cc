@@ -0,0 +1,126 @@
+#include "XSecAna/TemplateFitSignalEstimator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/Fit/FitResultStore.h"
+#include "XSecAna/Parallel.h"
+
+#include "test_utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+using namespace xsec;
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto sample = test::utils::make_template_fit_sample();
+    auto mask = test::utils::make_template_fit_mask();
+    auto data = test::utils::make_template_fit_data(sample);
+
+    TemplateFitSignalEstimator estimator(sample, mask);
+    fit::LinearTemplateFitter fitter;
+    estimator.SetFitter(&fitter);
+    auto result = estimator.Fit(data);
+    assert(result.is_valid);
+
+    // flat fit results keep the validity flag and parameters,
+    // including through a fit result store
+    for (auto is_valid : {true, false}) {
+        auto original = result.Clone();
+        original.is_valid = is_valid;
+        auto flat = estimator.ToFitResult(original);
+        assert(flat.is_valid == is_valid);
+
+        const std::string path = "test_template_fit_signal_estimator.bin";
+        {
+            fit::FitResultWriter writer(path, flat.params.size(), true);
+            writer.Append(flat);
+        }
+        fit::FitResultReader reader(path);
+        auto restored = estimator.FromFitResult(reader.GetRow(0));
+        std::remove(path.c_str());
+
+        assert(restored.is_valid == is_valid);
+        assert(restored.fun_val == original.fun_val);
+        assert(restored.fun_calls == original.fun_calls);
+        for (const auto & params : original.component_params) {
+            pass &= TEST_HIST("round trip " + params.first,
+                              restored.component_params.at(params.first),
+                              params.second,
+                              1e-12,
+                              verbose);
+        }
+        pass &= TEST_HIST("round trip covariance",
+                          restored.covariance,
+                          original.covariance,
+                          1e-12,
+                          verbose);
+    }
+
+    // a session started from a previous fit finds the same minimum
+    {
+        auto session = estimator.NewSession();
+        auto warm = session.Fit(data, result);
+        assert(warm.is_valid);
+        for (const auto & params : result.component_params) {
+            pass &= TEST_HIST("warm start " + params.first,
+                              warm.component_params.at(params.first),
+                              params.second,
+                              1e-6,
+                              verbose);
+        }
+    }
+
+    // profile scans are lowest at the fitted value, and reject masked or out of range bins
+    {
+        auto outer_bin = mask->GetBin(1, 1);
+        auto best = result.component_params.at("a")->GetBinContent(outer_bin);
+        std::unique_ptr<TGraph> profile(estimator.ProfileScan(data, "a", outer_bin,
+                                                              {best - 0.1, best, best + 0.1}));
+        assert(profile->GetN() == 3);
+        assert(std::abs(profile->GetY()[1] - result.fun_val) < 1e-6 * (1 + result.fun_val));
+        assert(profile->GetY()[0] > profile->GetY()[1]);
+        assert(profile->GetY()[2] > profile->GetY()[1]);
+
+        bool threw = false;
+        try { estimator.ProfileScan(data, "a", 0, {best}); }
+        catch (const std::runtime_error &) { threw = true; }
+        assert(threw);
+
+        threw = false;
+        try { estimator.ProfileScan(data, "a", mask->GetNcells(), {best}); }
+        catch (const std::out_of_range &) { threw = true; }
+        assert(threw);
+    }
+
+    // reducing the templates and systematics in parallel gives the same covariances
+    // as doing it on a single thread
+    {
+        parallel::SetNThreads(1);
+        TemplateFitSignalEstimator serial(sample, mask);
+        parallel::SetNThreads(3);
+        TemplateFitSignalEstimator threaded(sample, mask);
+        parallel::SetNThreads(0);
+
+        assert(serial.GetSystematicLabels() == threaded.GetSystematicLabels());
+        for (const auto & label : serial.GetSystematicLabels()) {
+            pass &= TEST_HIST("nthreads " + label,
+                              threaded.GetSystematicCovariance(label),
+                              serial.GetSystematicCovariance(label),
+                              0,
+                              verbose);
+        }
+        pass &= TEST_HIST("nthreads total",
+                          threaded.GetTotalSystematicCovariance(),
+                          serial.GetTotalSystematicCovariance(),
+                          0,
+                          verbose);
+    }
+
+    return !pass;
+}
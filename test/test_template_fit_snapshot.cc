@@ -0,0 +1,127 @@
+#include "XSecAna/ArrayFile.h"
+#include "XSecAna/Fit/TemplateFitCalculator.h"
+#include "XSecAna/Fit/LinearTemplateFitter.h"
+#include "XSecAna/TemplateFitSignalEstimator.h"
+
+#include "test_utils.h"
+
+#include <Eigen/Dense>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace xsec;
+using namespace xsec::fit;
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    if (argc > 1 && std::strcmp(argv[1], "-v") == 0) verbose = true;
+    bool pass = true;
+
+    auto dims = test::utils::template_fit_dims;
+    auto templates = test::utils::make_reduced_templates(2);
+    auto nbins = dims[0] * dims[1];
+    Matrix covariance = test::utils::make_template_covariance();
+    TemplateFitCalculator calc(ReducedComponentCollection(templates), dims, covariance);
+    assert(calc.GetCovarianceSolver().GetStructure() == kDenseStructure);
+
+    // write and map back
+    std::string path = "test_template_fit_snapshot.xsa";
+    const auto & design = calc.GetDesignMatrix();
+    {
+        ArrayFileWriter writer;
+        writer.Add("covariance", covariance);
+        writer.Add("cholesky_factor", calc.GetCovarianceSolver().GetCholeskyFactor());
+        writer.Add("design_matrix", Matrix(design));
+        writer.Add("prediction_offset", Matrix(calc.GetPredictionOffset()));
+        writer.Add("dims", dims);
+        writer.Add("type", std::string("test"));
+        writer.Write(path);
+    }
+    auto snapshot = std::make_shared<const ArrayFile>(path);
+    assert(snapshot->GetString("type") == "test");
+    assert(snapshot->GetInts("dims")(1) == dims[1]);
+    assert(snapshot->GetMatrix("covariance") == covariance);
+    assert(snapshot->GetNames().size() == 6);
+    // data blocks are aligned for vectorized access
+    assert(((std::uintptr_t) snapshot->GetMatrix("cholesky_factor").data()) % 64 == 0);
+
+    bool threw = false;
+    try { snapshot->GetInts("covariance"); }
+    catch (std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    // solver reusing the mapped factor agrees with one factorizing again
+    auto restored_solver = std::make_shared<const CovarianceSolver>(
+            snapshot->GetMatrix("covariance"),
+            snapshot->GetMatrix("cholesky_factor").data(),
+            snapshot);
+    Vector v = Vector::LinSpaced(nbins, -1, 2);
+    assert(std::abs(restored_solver->Chi2(v) - calc.GetCovarianceSolver().Chi2(v)) < 1e-10);
+    assert((restored_solver->Solve(v) - calc.GetCovarianceSolver().Solve(v)).isZero(1e-10));
+    assert((restored_solver->GetCholeskyFactor() - calc.GetCovarianceSolver().GetCholeskyFactor()).isZero(0));
+    // and reads the covariance in place too
+    assert(restored_solver->GetCovariance().data() == snapshot->GetMatrix("covariance").data());
+
+    TemplateFitCalculator restored(ReducedComponentCollection(templates),
+                                   restored_solver,
+                                   std::make_shared<const Eigen::SparseMatrix<double>>(
+                                           Matrix(snapshot->GetMatrix("design_matrix")).sparseView()),
+                                   std::make_shared<const Vector>(snapshot->GetMatrix("prediction_offset")));
+    Vector params = Vector::LinSpaced(calc.GetNUserParams(), 0.5, 2);
+    Vector data = calc.Predict(Vector::Ones(calc.GetNUserParams()));
+    assert(std::abs(restored.fun(params, data) - calc.fun(params, data)) < 1e-10);
+    Vector g1, g2;
+    restored.FunAndGradient(params, data, g1);
+    calc.FunAndGradient(params, data, g2);
+    assert((g1 - g2).isZero(1e-10));
+
+    std::remove(path.c_str());
+
+    // an estimator loaded from a snapshot fits like the one that saved it, fixed components included
+    {
+        auto sample = test::utils::make_template_fit_sample();
+        auto mask = test::utils::make_template_fit_mask();
+        auto data = test::utils::make_template_fit_data(sample);
+        TemplateFitSignalEstimator estimator(sample, mask);
+        estimator.FixComponent("c", 1.1);
+
+        const std::string estimator_path = "test_template_fit_snapshot_estimator.xsa";
+        estimator.SaveSnapshot(estimator_path);
+        auto loaded = TemplateFitSignalEstimator::LoadSnapshot(sample, mask, estimator_path);
+
+        LinearTemplateFitter fitter;
+        estimator.SetFitter(&fitter);
+        loaded->SetFitter(&fitter);
+        auto result = estimator.Fit(data);
+        auto loaded_result = loaded->Fit(data);
+        assert(std::abs(loaded_result.fun_val - result.fun_val) < 1e-8 * result.fun_val);
+        for (const auto & params : result.component_params) {
+            pass &= TEST_HIST("loaded snapshot params " + params.first,
+                              loaded_result.component_params.at(params.first),
+                              params.second,
+                              1e-8,
+                              verbose);
+        }
+        assert(std::abs(loaded->Chi2(data) - estimator.Chi2(data)) < 1e-8 * estimator.Chi2(data));
+        assert(std::abs(loaded->Chi2(data, result.component_params) - result.fun_val) < 1e-8 * result.fun_val);
+
+        assert(loaded->GetSystematicLabels() == estimator.GetSystematicLabels());
+        for (const auto & label : estimator.GetSystematicLabels()) {
+            pass &= TEST_HIST("loaded snapshot covariance " + label,
+                              loaded->GetSystematicCovariance(label),
+                              estimator.GetSystematicCovariance(label),
+                              0,
+                              verbose);
+        }
+        // the snapshot keeps covariance contents, not the errors the total picks up from adding histograms
+        pass &= TEST_ARRAY_SAME("loaded snapshot total covariance",
+                                root::MapContentsToEigen(loaded->GetTotalSystematicCovariance()),
+                                root::MapContentsToEigen(estimator.GetTotalSystematicCovariance()),
+                                0,
+                                verbose);
+        std::remove(estimator_path.c_str());
+    }
+
+    return !pass;
+}
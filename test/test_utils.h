@@ -1,7 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include "TH1D.h"
+#include "TH2D.h"
+#include "TH3D.h"
 #include "XSecAna/Utils.h"
 
 #include "XSecAna/IUnfold.h"
@@ -9,6 +12,7 @@
 #include "XSecAna/SimpleEfficiency.h"
 #include "XSecAna/SimpleFlux.h"
 #include "XSecAna/CrossSection.h"
+#include "XSecAna/Fit/TemplateFitComponent.h"
 
 [[nodiscard]] inline bool TEST_HIST(std::string test_name,
                                     const TH1 * HIST,
@@ -239,6 +243,64 @@ namespace xsec {
                 return ret;
             }
 
+            /////////////////////////////////////////////////////////
+            ///\brief One sided, two sided and 25 universe multiverse systematics around
+            /// make_sample(1, slope), for the binning and cut optimization tests
+            inline std::map<std::string, Systematic<TH1>>
+            make_sample_systematics(const std::function<std::shared_ptr<TH1>(double scale, double slope)> & make_sample,
+                                    double slope) {
+                std::vector<std::shared_ptr<TH1>> universes;
+                for (auto i = 0; i < 25; i++) {
+                    universes.push_back(make_sample(1 + 0.01 * (i - 12), slope + 0.05 * (i % 5 - 2)));
+                }
+                return {
+                        {"one_sided", Systematic<TH1>("one_sided", make_sample(1.02, slope + 0.3))},
+                        {"two_sided", Systematic<TH1>("two_sided",
+                                                      make_sample(1, slope + 0.2),
+                                                      make_sample(0.97, slope - 0.1))},
+                        {"multiverse", Systematic<TH1>("multiverse", universes)},
+                };
+            }
+
+            /////////////////////////////////////////////////////////
+            // outer x inner bins of the reduced templates used by the template fit tests
+            const std::vector<int> template_fit_dims = {4, 10};
+
+            ///\brief Reduced templates for template fit tests:
+            /// a signal "a" and backgrounds "b" and "c", the first ncomponents of them
+            inline std::map<std::string, const fit::IReducedTemplateComponent *>
+            make_reduced_templates(int ncomponents = 3) {
+                const auto & dims = template_fit_dims;
+                Matrix signal_templates(dims[0], dims[1]);
+                Matrix background1_templates(dims[0], dims[1]);
+                Matrix background2_templates(dims[0], dims[1]);
+
+                auto x = Array::LinSpaced(dims[1], 0, dims[1]);
+                for (auto i = 0u; i < signal_templates.rows(); i++) {
+                    signal_templates.row(i) = (i + 1) * x + 0.5;
+                    background1_templates.row(i) = (i + 1) * x.reverse() + 0.5;
+                    background2_templates.row(i) = (i + 1) * Vector::Ones(dims[1]) + x.square().matrix();
+                }
+
+                std::vector<std::pair<std::string, Matrix>> components = {
+                        {"a", signal_templates},
+                        {"b", background1_templates},
+                        {"c", background2_templates},
+                };
+                std::map<std::string, const fit::IReducedTemplateComponent *> templates;
+                for (auto i = 0; i < ncomponents; i++) {
+                    templates[components[i].first] = new fit::ReducedTemplateComponent(
+                            new fit::ReducedComponent(components[i].second.reshaped().transpose(), dims[0], dims[1]));
+                }
+                return templates;
+            }
+
+            ///\brief Dense covariance matching make_reduced_templates
+            inline Matrix make_template_covariance() {
+                auto nbins = template_fit_dims[0] * template_fit_dims[1];
+                return Matrix::Identity(nbins, nbins) * 0.5 + Matrix::Constant(nbins, nbins, 0.1);
+            }
+
             /////////////////////////////////////////////////////////
             std::vector<std::shared_ptr<TH1>> make_simple_hist_multiverse(const TH1 * hnominal, int nuniverses) {
                 double maxy = 0.1;
@@ -255,6 +317,111 @@ namespace xsec {
                 }
                 return hist_universes;
             }
+
+            /////////////////////////////////////////////////////////
+            // analysis bins on x and y, template bins on z of make_template_fit_sample
+            const std::vector<int> template_fit_nbins = {3, 2, 4};
+
+            ///\brief Template of make_template_fit_sample.
+            /// Axes have variable bins, as TemplateFitSignalEstimator expects
+            inline std::shared_ptr<TH1> make_template(const std::function<double(int x, int y, int z)> & content) {
+                const auto & n = template_fit_nbins;
+                Array xbins = Array::LinSpaced(n[0] + 1, 0, n[0]);
+                Array ybins = Array::LinSpaced(n[1] + 1, 0, n[1]);
+                Array zbins = Array::LinSpaced(n[2] + 1, 0, n[2]);
+                auto h = std::make_shared<TH3D>(root::MakeUnique("template").c_str(), "",
+                                                n[0], xbins.data(),
+                                                n[1], ybins.data(),
+                                                n[2], zbins.data());
+                h->SetDirectory(nullptr);
+                for (auto x = 0; x <= n[0] + 1; x++) {
+                    for (auto y = 0; y <= n[1] + 1; y++) {
+                        for (auto z = 0; z <= n[2] + 1; z++) {
+                            h->SetBinContent(x, y, z, content(x, y, z));
+                            h->SetBinError(x, y, z, std::sqrt(content(x, y, z)));
+                        }
+                    }
+                }
+                return h;
+            }
+
+            ///\brief User level template fit sample: a signal "a" and backgrounds "b" and "c"
+            /// with different shapes along the template axis, and shape only systematics:
+            /// a multiverse tilting their total and a one sided stretch of it.
+            /// scale multiplies everything, e.g. to make a second sample.
+            /// With ncomponent_universes > 0 each component also gets a "flux" multiverse
+            /// changing its normalization differently in each analysis bin, correlated between samples
+            /// through the universe index,
+            /// as joint template fits need
+            inline fit::TemplateFitSample make_template_fit_sample(double scale = 1, int ncomponent_universes = 0) {
+                std::vector<std::function<double(int, int, int)>> shapes = {
+                        [=](int x, int y, int z) { return scale * (10 + 5 * z + x + y); },
+                        [=](int x, int y, int z) { return scale * (30 - 5 * z + 2 * x); },
+                        [=](int x, int y, int z) { return scale * (8 + y + (z - 2) * (z - 2)); },
+                };
+                const std::vector<std::string> labels = {"a", "b", "c"};
+                std::map<std::string, const fit::IUserTemplateComponent *> components;
+                for (auto i = 0u; i < shapes.size(); i++) {
+                    std::map<std::string, Systematic<TH1>> systematics;
+                    if (ncomponent_universes > 0) {
+                        std::vector<std::shared_ptr<TH1>> flux_universes;
+                        for (auto u = 0; u < ncomponent_universes; u++) {
+                            flux_universes.push_back(make_template([&](int x, int y, int z) {
+                                return shapes[i](x, y, z) * (1 + 0.02 * (u - ncomponent_universes / 2) * (1 + 0.2 * i) +
+                                                             0.01 * ((u * (x + 3 * y) + (int) scale) % 11 - 5));
+                            }));
+                        }
+                        systematics.emplace("flux", Systematic<TH1>("flux", flux_universes));
+                    }
+                    components[labels[i]] = new fit::UserTemplateComponent(make_template(shapes[i]), systematics);
+                }
+
+                auto total = [&](int x, int y, int z) {
+                    return shapes[0](x, y, z) + shapes[1](x, y, z) + shapes[2](x, y, z);
+                };
+                std::vector<std::shared_ptr<TH1>> universes;
+                for (auto u = 0; u < 20; u++) {
+                    universes.push_back(make_template([&](int x, int y, int z) {
+                        return total(x, y, z) * (1 + 0.01 * (u - 10) * (z - 2) + 0.005 * ((u * 7) % 5 - 2) * x);
+                    }));
+                }
+                auto stretched = make_template([&](int x, int y, int z) { return total(x, y, z) * (1 + 0.03 * z); });
+                std::map<std::string, Systematic<TH1>> shape_only_systematics = {
+                        {"tilt", Systematic<TH1>("tilt", universes)},
+                        {"stretch", Systematic<TH1>("stretch", stretched)},
+                };
+                return fit::TemplateFitSample(components, shape_only_systematics);
+            }
+
+            ///\brief Mask of the analysis bins of make_template_fit_sample.
+            /// Under/overflow and the analysis bin (masked_x, masked_y), if given, are masked out
+            inline TH1 * make_template_fit_mask(int masked_x = -1, int masked_y = -1) {
+                const auto & n = template_fit_nbins;
+                auto mask = new TH2D(root::MakeUnique("mask").c_str(), "",
+                                     n[0], 0, n[0],
+                                     n[1], 0, n[1]);
+                mask->SetDirectory(nullptr);
+                for (auto x = 1; x <= n[0]; x++) {
+                    for (auto y = 1; y <= n[1]; y++) {
+                        mask->SetBinContent(x, y, x == masked_x && y == masked_y ? 0 : 1);
+                    }
+                }
+                return mask;
+            }
+
+            ///\brief Total of the templates of sample, with the signal "a" scaled by signal_scale
+            inline std::shared_ptr<TH1> make_template_fit_data(const fit::TemplateFitSample & sample,
+                                                               double signal_scale = 1.2) {
+                std::shared_ptr<TH1> data;
+                for (const auto & component : sample.components.GetComponents()) {
+                    auto nominal = std::shared_ptr<TH1>((TH1 *) component.second->GetNominal()->Clone());
+                    if (component.first == "a") nominal->Scale(signal_scale);
+                    if (!data) data = nominal;
+                    else data->Add(nominal.get());
+                }
+                data->SetDirectory(nullptr);
+                return data;
+            }
         } // utils
     } // test
 } // xsec